@@ -223,6 +223,57 @@ int32_t db_upperbound_i64(account_name code, account_name scope, table_name tabl
   */
 int32_t db_end_i64(account_name code, account_name scope, table_name table);
 
+/**
+  *
+  *  Copy consecutive table rows of a primary 64-bit integer index table, starting at the referenced row, in one call
+  *  Each row is written to `data` as its `uint64_t` primary key, a `uint32_t` size and then `size` bytes of the record.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy consecutive table rows of a primary 64-bit integer index table
+  *  @param iterator - The iterator to the first table row to copy
+  *  @param max_rows - Maximum number of table rows to copy
+  *  @param data - Pointer to the buffer which will be filled with the copied rows
+  *  @param len - Size of the buffer
+  *  @param next - Pointer to an `int32_t` variable which will be set to the iterator of the first table row not copied (or the end iterator of the table)
+  *  @return number of table rows copied into the buffer
+  *  @pre `iterator` points to an existing table row in the table or it is the end iterator of the table
+  *  @post copying stops early at the first table row that does not fit into the remaining buffer space
+  *
+  *  Example:
+  *
+  *  @code
+  *  char rows[4096];
+  *  int32_t next = 0;
+  *  int32_t itr = db_lowerbound_i64(receiver, receiver, table1, 0);
+  *  while( itr >= 0 ) {
+  *     int32_t count = db_get_range_i64(itr, 64, rows, sizeof(rows), &next);
+  *     eosio_assert(count > 0, "row does not fit into the buffer");
+  *     // ... walk `count` rows in `rows` ...
+  *     itr = next;
+  *  }
+  *  @endcode
+  */
+int32_t db_get_range_i64(int32_t iterator, uint32_t max_rows, void* data, uint32_t len, int32_t* next);
+
+/**
+  *
+  *  Copy the table rows for a list of primary keys of a primary 64-bit integer index table in one call
+  *  Rows are written in the same layout as `db_get_range_i64`; primary keys without a row are skipped.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy the table rows for a list of primary keys of a primary 64-bit integer index table
+  *  @param code - The name of the owner of the table
+  *  @param scope - The scope where the table resides
+  *  @param table - The table name
+  *  @param ids - Pointer to the array of primary keys to look up
+  *  @param ids_count - Number of primary keys in `ids`
+  *  @param data - Pointer to the buffer which will be filled with the copied rows
+  *  @param len - Size of the buffer
+  *  @return number of table rows copied into the buffer
+  *  @pre `data` is large enough to hold all of the found table rows, otherwise the action is aborted
+  */
+int32_t db_get_multi_i64(account_name code, account_name scope, table_name table, const uint64_t* ids, uint32_t ids_count, void* data, uint32_t len);
+
 /**
   *
   *  Store an association of a 64-bit integer secondary key to a primary key in a secondary 64-bit integer index table
@@ -364,6 +415,23 @@ int32_t db_idx64_upperbound(account_name code, account_name scope, table_name ta
   */
 int32_t db_idx64_end(account_name code, account_name scope, table_name table);
 
+/**
+  *
+  *  Copy consecutive (secondary key, primary key) pairs of a secondary 64-bit integer index table in one call
+  *  Each pair is written to `data` as the 8-byte secondary key followed by the `uint64_t` primary key.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy consecutive (secondary key, primary key) pairs of a secondary 64-bit integer index table
+  *  @param iterator - The iterator to the first table row to copy (may be the end iterator when `reverse` is set)
+  *  @param max_rows - Maximum number of pairs to copy
+  *  @param reverse - Walk the index backwards instead of forwards
+  *  @param data - Pointer to the buffer which will be filled with the copied pairs
+  *  @param len - Size of the buffer
+  *  @param next - Pointer to an `int32_t` variable which will be set to the iterator of the first table row not copied (the end iterator or -1 once the table is exhausted)
+  *  @return number of pairs copied into the buffer
+  */
+int32_t db_idx64_get_range(int32_t iterator, uint32_t max_rows, uint32_t reverse, void* data, uint32_t len, int32_t* next);
+
 
 
 /**
@@ -507,6 +575,23 @@ int32_t db_idx128_upperbound(account_name code, account_name scope, table_name t
   */
 int32_t db_idx128_end(account_name code, account_name scope, table_name table);
 
+/**
+  *
+  *  Copy consecutive (secondary key, primary key) pairs of a secondary 128-bit integer index table in one call
+  *  Each pair is written to `data` as the 16-byte secondary key followed by the `uint64_t` primary key.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy consecutive (secondary key, primary key) pairs of a secondary 128-bit integer index table
+  *  @param iterator - The iterator to the first table row to copy (may be the end iterator when `reverse` is set)
+  *  @param max_rows - Maximum number of pairs to copy
+  *  @param reverse - Walk the index backwards instead of forwards
+  *  @param data - Pointer to the buffer which will be filled with the copied pairs
+  *  @param len - Size of the buffer
+  *  @param next - Pointer to an `int32_t` variable which will be set to the iterator of the first table row not copied (the end iterator or -1 once the table is exhausted)
+  *  @return number of pairs copied into the buffer
+  */
+int32_t db_idx128_get_range(int32_t iterator, uint32_t max_rows, uint32_t reverse, void* data, uint32_t len, int32_t* next);
+
 /**
   *
   *  Store an association of a 256-bit secondary key to a primary key in a secondary 256-bit index table
@@ -654,6 +739,23 @@ int32_t db_idx256_upperbound(account_name code, account_name scope, table_name t
   */
 int32_t db_idx256_end(account_name code, account_name scope, table_name table);
 
+/**
+  *
+  *  Copy consecutive (secondary key, primary key) pairs of a secondary 256-bit index table in one call
+  *  Each pair is written to `data` as the 32-byte secondary key followed by the `uint64_t` primary key.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy consecutive (secondary key, primary key) pairs of a secondary 256-bit index table
+  *  @param iterator - The iterator to the first table row to copy (may be the end iterator when `reverse` is set)
+  *  @param max_rows - Maximum number of pairs to copy
+  *  @param reverse - Walk the index backwards instead of forwards
+  *  @param data - Pointer to the buffer which will be filled with the copied pairs
+  *  @param len - Size of the buffer
+  *  @param next - Pointer to an `int32_t` variable which will be set to the iterator of the first table row not copied (the end iterator or -1 once the table is exhausted)
+  *  @return number of pairs copied into the buffer
+  */
+int32_t db_idx256_get_range(int32_t iterator, uint32_t max_rows, uint32_t reverse, void* data, uint32_t len, int32_t* next);
+
 /**
   *
   *  Store an association of a double-precision floating-point secondary key to a primary key in a secondary double-precision floating-point index table
@@ -795,6 +897,23 @@ int32_t db_idx_double_upperbound(account_name code, account_name scope, table_na
   */
 int32_t db_idx_double_end(account_name code, account_name scope, table_name table);
 
+/**
+  *
+  *  Copy consecutive (secondary key, primary key) pairs of a secondary double-precision floating-point index table in one call
+  *  Each pair is written to `data` as the 8-byte secondary key followed by the `uint64_t` primary key.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy consecutive (secondary key, primary key) pairs of a secondary double-precision floating-point index table
+  *  @param iterator - The iterator to the first table row to copy (may be the end iterator when `reverse` is set)
+  *  @param max_rows - Maximum number of pairs to copy
+  *  @param reverse - Walk the index backwards instead of forwards
+  *  @param data - Pointer to the buffer which will be filled with the copied pairs
+  *  @param len - Size of the buffer
+  *  @param next - Pointer to an `int32_t` variable which will be set to the iterator of the first table row not copied (the end iterator or -1 once the table is exhausted)
+  *  @return number of pairs copied into the buffer
+  */
+int32_t db_idx_double_get_range(int32_t iterator, uint32_t max_rows, uint32_t reverse, void* data, uint32_t len, int32_t* next);
+
 /**
   *
   *  Store an association of a quadruple-precision floating-point secondary key to a primary key in a secondary quadruple-precision floating-point index table
@@ -936,5 +1055,22 @@ int32_t db_idx_long_double_upperbound(account_name code, account_name scope, tab
   */
 int32_t db_idx_long_double_end(account_name code, account_name scope, table_name table);
 
+/**
+  *
+  *  Copy consecutive (secondary key, primary key) pairs of a secondary quadruple-precision floating-point index table in one call
+  *  Each pair is written to `data` as the 16-byte secondary key followed by the `uint64_t` primary key.
+  *  Only available to privileged contracts.
+  *
+  *  @brief Copy consecutive (secondary key, primary key) pairs of a secondary quadruple-precision floating-point index table
+  *  @param iterator - The iterator to the first table row to copy (may be the end iterator when `reverse` is set)
+  *  @param max_rows - Maximum number of pairs to copy
+  *  @param reverse - Walk the index backwards instead of forwards
+  *  @param data - Pointer to the buffer which will be filled with the copied pairs
+  *  @param len - Size of the buffer
+  *  @param next - Pointer to an `int32_t` variable which will be set to the iterator of the first table row not copied (the end iterator or -1 once the table is exhausted)
+  *  @return number of pairs copied into the buffer
+  */
+int32_t db_idx_long_double_get_range(int32_t iterator, uint32_t max_rows, uint32_t reverse, void* data, uint32_t len, int32_t* next);
+
 ///@} databasec
 }
@@ -80,10 +80,12 @@ struct test_db {
    static void primary_i64_general(uint64_t receiver, uint64_t code, uint64_t action);
    static void primary_i64_lowerbound(uint64_t receiver, uint64_t code, uint64_t action);
    static void primary_i64_upperbound(uint64_t receiver, uint64_t code, uint64_t action);
+   static void primary_i64_batch(uint64_t receiver, uint64_t code, uint64_t action);
 
    static void idx64_general(uint64_t receiver, uint64_t code, uint64_t action);
    static void idx64_lowerbound(uint64_t receiver, uint64_t code, uint64_t action);
    static void idx64_upperbound(uint64_t receiver, uint64_t code, uint64_t action);
+   static void idx64_batch(uint64_t receiver, uint64_t code, uint64_t action);
 
    static void test_invalid_access(uint64_t receiver, uint64_t code, uint64_t action);
 
@@ -13,9 +13,11 @@ extern "C" {
       WASM_TEST_HANDLER_EX(test_db, primary_i64_general);
       WASM_TEST_HANDLER_EX(test_db, primary_i64_lowerbound);
       WASM_TEST_HANDLER_EX(test_db, primary_i64_upperbound);
+      WASM_TEST_HANDLER_EX(test_db, primary_i64_batch);
       WASM_TEST_HANDLER_EX(test_db, idx64_general);
       WASM_TEST_HANDLER_EX(test_db, idx64_lowerbound);
       WASM_TEST_HANDLER_EX(test_db, idx64_upperbound);
+      WASM_TEST_HANDLER_EX(test_db, idx64_batch);
       WASM_TEST_HANDLER_EX(test_db, test_invalid_access);
       WASM_TEST_HANDLER_EX(test_db, idx_double_nan_create_fail);
       WASM_TEST_HANDLER_EX(test_db, idx_double_nan_modify_fail);
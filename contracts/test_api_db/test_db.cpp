@@ -242,6 +242,58 @@ void test_db::primary_i64_upperbound(uint64_t receiver, uint64_t code, uint64_t
    }
 }
 
+void test_db::primary_i64_batch(uint64_t receiver, uint64_t code, uint64_t action)
+{
+   (void)code;(void)action;
+   auto table = N(mytable);
+   const std::string err = "primary_i64_batch";
+
+   const size_t header_size = sizeof(uint64_t) + sizeof(uint32_t);
+   char buffer[256];
+
+   // rows stored by primary_i64_lowerbound: alice, allyson, bob, charlie, emily, joe
+   {
+      int itr  = db_find_i64(receiver, receiver, table, N(alice));
+      int next = 0;
+      int count = db_get_range_i64(itr, 3, buffer, sizeof(buffer), &next);
+      eosio_assert(count == 3, err.c_str());
+      eosio_assert(next == db_find_i64(receiver, receiver, table, N(charlie)), err.c_str());
+
+      uint64_t pk = 0; uint32_t size = 0;
+      memcpy(&pk, buffer, sizeof(pk));
+      memcpy(&size, buffer + sizeof(pk), sizeof(size));
+      eosio_assert(pk == N(alice) && size == strlen("alice's info"), err.c_str());
+      eosio_assert(memcmp(buffer + header_size, "alice's info", size) == 0, err.c_str());
+   }
+   {
+      int itr  = db_find_i64(receiver, receiver, table, N(emily));
+      int next = 0;
+      int count = db_get_range_i64(itr, 10, buffer, sizeof(buffer), &next);
+      eosio_assert(count == 2, err.c_str());
+      eosio_assert(next == db_end_i64(receiver, receiver, table), err.c_str());
+   }
+   {
+      // stops at the first row which does not fit
+      int itr  = db_find_i64(receiver, receiver, table, N(alice));
+      int next = 0;
+      int count = db_get_range_i64(itr, 10, buffer, header_size + strlen("alice's info"), &next);
+      eosio_assert(count == 1, err.c_str());
+      eosio_assert(next == db_find_i64(receiver, receiver, table, N(allyson)), err.c_str());
+   }
+   {
+      uint64_t ids[] = { N(joe), N(kevin), N(bob) };
+      int count = db_get_multi_i64(receiver, receiver, table, ids, 3, buffer, sizeof(buffer));
+      eosio_assert(count == 2, err.c_str());
+
+      uint64_t pk = 0; uint32_t size = 0;
+      memcpy(&pk, buffer, sizeof(pk));
+      memcpy(&size, buffer + sizeof(pk), sizeof(size));
+      eosio_assert(pk == N(joe), err.c_str());
+      memcpy(&pk, buffer + header_size + size, sizeof(pk));
+      eosio_assert(pk == N(bob), err.c_str());
+   }
+}
+
 void test_db::idx64_general(uint64_t receiver, uint64_t code, uint64_t action)
 {
    (void)code;(void)action;
@@ -361,6 +413,49 @@ void test_db::idx64_general(uint64_t receiver, uint64_t code, uint64_t action)
    }
 }
 
+void test_db::idx64_batch(uint64_t receiver, uint64_t code, uint64_t action)
+{
+   (void)code;(void)action;
+   const auto table = N(myindextable);
+   const std::string err = "idx64_batch";
+
+   struct pair {
+      uint64_t secondary;
+      uint64_t primary;
+   };
+   pair pairs[4];
+
+   // rows stored by idx64_general in secondary order:
+   // alice/265, allyson/650, bob/540, bob/781, charlie/234, emily/976, joe/110
+   uint64_t sec = 0;
+   {
+      int itr  = db_idx64_find_primary(receiver, receiver, table, &sec, 265);
+      int next = 0;
+      int count = db_idx64_get_range(itr, 3, 0, pairs, sizeof(pairs), &next);
+      eosio_assert(count == 3, err.c_str());
+      eosio_assert(pairs[0].secondary == N(alice) && pairs[0].primary == 265, err.c_str());
+      eosio_assert(pairs[1].secondary == N(allyson) && pairs[1].primary == 650, err.c_str());
+      eosio_assert(pairs[2].secondary == N(bob) && pairs[2].primary == 540, err.c_str());
+      eosio_assert(next == db_idx64_find_primary(receiver, receiver, table, &sec, 781), err.c_str());
+   }
+   {
+      int end  = db_idx64_end(receiver, receiver, table);
+      int next = 0;
+      int count = db_idx64_get_range(end, 2, 1, pairs, sizeof(pairs), &next);
+      eosio_assert(count == 2, err.c_str());
+      eosio_assert(pairs[0].secondary == N(joe) && pairs[0].primary == 110, err.c_str());
+      eosio_assert(pairs[1].secondary == N(emily) && pairs[1].primary == 976, err.c_str());
+      eosio_assert(next == db_idx64_find_primary(receiver, receiver, table, &sec, 234), err.c_str());
+   }
+   {
+      int itr  = db_idx64_find_primary(receiver, receiver, table, &sec, 265);
+      int next = 0;
+      int count = db_idx64_get_range(itr, 4, 1, pairs, sizeof(pairs), &next);
+      eosio_assert(count == 1 && pairs[0].primary == 265, err.c_str());
+      eosio_assert(next == -1, err.c_str());
+   }
+}
+
 void test_db::idx64_lowerbound(uint64_t receiver, uint64_t code, uint64_t action)
 {
    (void)code;(void)action;
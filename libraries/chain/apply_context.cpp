@@ -704,6 +704,69 @@ int apply_context::db_end_i64( uint64_t code, uint64_t scope, uint64_t table ) {
    return keyval_cache.cache_table( *tab );
 }
 
+bool apply_context::copy_row_to_batch( const key_value_object& obj, char*& out, size_t& remaining )const {
+   const size_t row_size = batch_row_header_size + obj.value.size();
+   if( row_size > remaining ) return false;
+
+   const uint64_t primary    = obj.primary_key;
+   const uint32_t value_size = obj.value.size();
+   memcpy( out, &primary, sizeof(primary) );
+   memcpy( out + sizeof(primary), &value_size, sizeof(value_size) );
+   memcpy( out + batch_row_header_size, obj.value.data(), value_size );
+
+   out       += row_size;
+   remaining -= row_size;
+   return true;
+}
+
+int apply_context::db_get_range_i64( int iterator, uint32_t max_rows, char* buffer, size_t buffer_size, int& next ) {
+   next = iterator;
+   if( iterator < -1 || max_rows == 0 ) return 0; // nothing to copy from an end iterator
+
+   const auto& obj = keyval_cache.get( iterator ); // Check for iterator != -1 happens in this call
+   const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+
+   uint32_t copied    = 0;
+   char*    out       = buffer;
+   size_t   remaining = buffer_size;
+
+   // Only the row we stop at is handed an iterator, the rows in between never enter keyval_cache
+   auto itr = idx.iterator_to( obj );
+   for( ; itr != idx.end() && itr->t_id == obj.t_id && copied < max_rows; ++itr ) {
+      if( !copy_row_to_batch( *itr, out, remaining ) ) break;
+      ++copied;
+   }
+
+   if( itr == idx.end() || itr->t_id != obj.t_id )
+      next = keyval_cache.get_end_iterator_by_table_id( obj.t_id );
+   else
+      next = keyval_cache.add( *itr );
+
+   return copied;
+}
+
+int apply_context::db_get_multi_i64( uint64_t code, uint64_t scope, uint64_t table, const uint64_t* ids, size_t ids_count,
+                                     char* buffer, size_t buffer_size ) {
+   const auto* tab = find_table( code, scope, table );
+   if( !tab ) return 0;
+
+   int     copied    = 0;
+   char*   out       = buffer;
+   size_t  remaining = buffer_size;
+
+   for( size_t i = 0; i < ids_count; ++i ) {
+      const key_value_object* obj = db.find<key_value_object, by_scope_primary>( boost::make_tuple( tab->id, ids[i] ) );
+      if( !obj ) continue; // missing rows are skipped, callers match rows by primary key
+
+      EOS_ASSERT( copy_row_to_batch( *obj, out, remaining ), db_api_exception,
+                  "buffer too small to hold requested rows: ${copied} of ${requested} copied",
+                  ("copied",copied)("requested",ids_count) );
+      ++copied;
+   }
+
+   return copied;
+}
+
 uint64_t apply_context::next_global_sequence() {
    const auto& p = control.get_dynamic_global_properties();
    db.modify( p, [&]( auto& dgp ) {
@@ -15,6 +15,8 @@
 #include <boost/tuple/tuple_io.hpp>
 #include <eosio/chain/database_utils.hpp>
 
+#include <array>
+
 
 namespace eosio { namespace chain {
 
@@ -24,8 +26,63 @@ namespace eosio { namespace chain {
       permission_link_index
    >;
 
+   /**
+    * Memoised results of successful authorization checks against the state of the pending block.
+    *
+    * Only successes are recorded, keyed on every input that can influence the outcome. An evaluation is recorded only
+    * if every permission it consulted existed and was last updated before the pending block, so creating a permission
+    * or undoing a failed transaction can never leave a stale entry behind. Modifying or removing a permission drops
+    * everything; changing a permission link drops the minimum permission results and stops recording them for the
+    * rest of the block, since links carry no update time that could be checked instead.
+    */
+   struct authorization_manager::authorization_cache {
+      static constexpr size_t max_entries = 16*1024;
+
+      /**
+       * The key of a satisfaction check: a digest of the (permission, delay) pairs to satisfy, the provided keys and
+       * permissions and max_authority_depth, so that a lookup hashes its inputs instead of copying them.
+       */
+      template<typename Permissions>
+      static digest_type satisfaction_key( const Permissions& permissions,
+                                           const flat_set<public_key_type>& provided_keys,
+                                           const flat_set<permission_level>& provided_permissions,
+                                           uint16_t max_authority_depth ) {
+         digest_type::encoder enc;
+         fc::raw::pack( enc, max_authority_depth );
+         fc::raw::pack( enc, unsigned_int(permissions.size()) );
+         for( const auto& p : permissions ) {
+            fc::raw::pack( enc, p.first );
+            fc::raw::pack( enc, p.second );
+         }
+         fc::raw::pack( enc, unsigned_int(provided_keys.size()) );
+         for( const auto& k : provided_keys )
+            fc::raw::pack( enc, k );
+         fc::raw::pack( enc, unsigned_int(provided_permissions.size()) );
+         for( const auto& p : provided_permissions )
+            fc::raw::pack( enc, p );
+         return enc.result();
+      }
+
+      /// (code, action, declared authorization) triples that passed the minimum permission check
+      using relevance_key = std::tuple<account_name, action_name, permission_level>;
+
+      /// maps to whether every provided key was used in satisfying the permissions
+      map<digest_type, bool>       satisfied;
+      set<relevance_key>           relevant;
+      bool                         links_changed = false;
+
+      bool full()const { return satisfied.size() + relevant.size() >= max_entries; }
+
+      void clear() {
+         satisfied.clear();
+         relevant.clear();
+      }
+   };
+
    authorization_manager::authorization_manager(controller& c, database& d)
-   :_control(c),_db(d){}
+   :_control(c),_db(d),_auth_cache(std::make_unique<authorization_cache>()){}
+
+   authorization_manager::~authorization_manager() = default;
 
    void authorization_manager::add_indices() {
       authorization_index_set::add_indices(_db);
@@ -35,6 +92,16 @@ namespace eosio { namespace chain {
       _db.create<permission_object>([](auto&){}); /// reserve perm 0 (used else where)
    }
 
+   void authorization_manager::reset_authorization_cache() {
+      _auth_cache->clear();
+      _auth_cache->links_changed = false;
+   }
+
+   void authorization_manager::invalidate_linked_permission_cache() {
+      _auth_cache->relevant.clear();
+      _auth_cache->links_changed = true;
+   }
+
    namespace detail {
       template<>
       struct snapshot_row_traits<permission_object> {
@@ -188,6 +255,7 @@ namespace eosio { namespace chain {
    }
 
    void authorization_manager::modify_permission( const permission_object& permission, const authority& auth ) {
+      _auth_cache->clear();
       _db.modify( permission, [&](permission_object& po) {
          po.auth = auth;
          po.last_updated = _control.pending_block_time();
@@ -200,6 +268,7 @@ namespace eosio { namespace chain {
       EOS_ASSERT( range.first == range.second, action_validate_exception,
                   "Cannot remove a permission which has children. Remove the children first.");
 
+      _auth_cache->clear();
       _db.get_mutable_index<permission_usage_index>().remove_object( permission.usage_id._id );
       _db.remove( permission );
    }
@@ -441,8 +510,21 @@ namespace eosio { namespace chain {
 
       auto effective_provided_delay =  (provided_delay >= delay_max_limit) ? fc::microseconds::maximum() : provided_delay;
 
-      auto checker = make_auth_checker( [&](const permission_level& p){ return get_permission(p).auth; },
-                                        _control.get_global_properties().configuration.max_authority_depth,
+      const auto max_authority_depth = _control.get_global_properties().configuration.max_authority_depth;
+      const auto head_time = _control.head_block_time();
+      bool cacheable = true;
+
+      auto checker = make_auth_checker( [&](const permission_level& p){
+                                           try {
+                                              const auto& perm = get_permission(p);
+                                              if( perm.last_updated > head_time ) cacheable = false;
+                                              return perm.auth;
+                                           } catch( const permission_query_exception& ) {
+                                              cacheable = false;
+                                              throw;
+                                           }
+                                        },
+                                        max_authority_depth,
                                         provided_keys,
                                         provided_permissions,
                                         effective_provided_delay,
@@ -478,14 +560,23 @@ namespace eosio { namespace chain {
             checktime();
 
             if( !special_case ) {
-               auto min_permission_name = lookup_minimum_permission(declared_auth.actor, act.account, act.name);
-               if( min_permission_name ) { // since special cases were already handled, it should only be false if the permission is eosio.any
-                  const auto& min_permission = get_permission({declared_auth.actor, *min_permission_name});
-                  EOS_ASSERT( get_permission(declared_auth).satisfies( min_permission,
-                                                                       _db.get_index<permission_index>().indices() ),
-                              irrelevant_auth_exception,
-                              "action declares irrelevant authority '${auth}'; minimum authority is ${min}",
-                              ("auth", declared_auth)("min", permission_level{min_permission.owner, min_permission.name}) );
+               auto relevance = std::make_tuple( act.account, act.name, declared_auth );
+               if( _auth_cache->relevant.find( relevance ) == _auth_cache->relevant.end() ) {
+                  bool relevance_cacheable = true;
+                  auto min_permission_name = lookup_minimum_permission(declared_auth.actor, act.account, act.name);
+                  if( min_permission_name ) { // since special cases were already handled, it should only be false if the permission is eosio.any
+                     const auto& min_permission = get_permission({declared_auth.actor, *min_permission_name});
+                     const auto& declared_permission = get_permission(declared_auth);
+                     EOS_ASSERT( declared_permission.satisfies( min_permission,
+                                                                _db.get_index<permission_index>().indices() ),
+                                 irrelevant_auth_exception,
+                                 "action declares irrelevant authority '${auth}'; minimum authority is ${min}",
+                                 ("auth", declared_auth)("min", permission_level{min_permission.owner, min_permission.name}) );
+                     relevance_cacheable = ( min_permission.last_updated <= head_time
+                                             && declared_permission.last_updated <= head_time );
+                  }
+                  if( relevance_cacheable && !_auth_cache->links_changed && !_auth_cache->full() )
+                     _auth_cache->relevant.emplace( std::move(relevance) );
                }
             }
 
@@ -498,6 +589,12 @@ namespace eosio { namespace chain {
          }
       }
 
+      const auto key = authorization_cache::satisfaction_key( permissions_to_satisfy, provided_keys, provided_permissions,
+                                                              max_authority_depth );
+      auto cached = _auth_cache->satisfied.find( key );
+      if( cached != _auth_cache->satisfied.end() && ( allow_unused_keys || cached->second ) )
+         return;
+
       // Now verify that all the declared authorizations are satisfied:
 
       // Although this can be made parallel (especially for input transactions) with the optimistic assumption that the
@@ -521,6 +618,9 @@ namespace eosio { namespace chain {
 
       }
 
+      if( cacheable && !_auth_cache->full() )
+         _auth_cache->satisfied[key] = checker.all_keys_used();
+
       if( !allow_unused_keys ) {
          EOS_ASSERT( checker.all_keys_used(), tx_irrelevant_sig,
                      "transaction bears irrelevant signatures from these keys: ${keys}",
@@ -542,11 +642,35 @@ namespace eosio { namespace chain {
 
       auto delay_max_limit = fc::seconds( _control.get_global_properties().configuration.max_transaction_delay );
 
-      auto checker = make_auth_checker( [&](const permission_level& p){ return get_permission(p).auth; },
-                                        _control.get_global_properties().configuration.max_authority_depth,
+      auto effective_provided_delay = ( provided_delay >= delay_max_limit ) ? fc::microseconds::maximum() : provided_delay;
+
+      const auto max_authority_depth = _control.get_global_properties().configuration.max_authority_depth;
+      const auto head_time = _control.head_block_time();
+      bool cacheable = true;
+
+      const std::array<pair<permission_level, fc::microseconds>, 1> permissions{{
+         {permission_level{account, permission}, effective_provided_delay}
+      }};
+      const auto key = authorization_cache::satisfaction_key( permissions, provided_keys, provided_permissions,
+                                                              max_authority_depth );
+      auto cached = _auth_cache->satisfied.find( key );
+      if( cached != _auth_cache->satisfied.end() && ( allow_unused_keys || cached->second ) )
+         return;
+
+      auto checker = make_auth_checker( [&](const permission_level& p){
+                                           try {
+                                              const auto& perm = get_permission(p);
+                                              if( perm.last_updated > head_time ) cacheable = false;
+                                              return perm.auth;
+                                           } catch( const permission_query_exception& ) {
+                                              cacheable = false;
+                                              throw;
+                                           }
+                                        },
+                                        max_authority_depth,
                                         provided_keys,
                                         provided_permissions,
-                                        ( provided_delay >= delay_max_limit ) ? fc::microseconds::maximum() : provided_delay,
+                                        effective_provided_delay,
                                         checktime
                                       );
 
@@ -561,6 +685,9 @@ namespace eosio { namespace chain {
                   ("delay_max_limit_ms", delay_max_limit.count()/1000)
                 );
 
+      if( cacheable && !_auth_cache->full() )
+         _auth_cache->satisfied[key] = checker.all_keys_used();
+
       if( !allow_unused_keys ) {
          EOS_ASSERT( checker.all_keys_used(), tx_irrelevant_sig,
                      "irrelevant keys provided: ${keys}",
@@ -13,10 +13,13 @@
 #include <eosio/chain/generated_transaction_object.hpp>
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/reversible_block_object.hpp>
+#include <eosio/chain/recurring_action_object.hpp>
+#include <eosio/chain/protocol_state_object.hpp>
 
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/chain_snapshot.hpp>
+#include <eosio/chain/sha256_batch.hpp>
 
 #include <chainbase/chainbase.hpp>
 #include <fc/io/json.hpp>
@@ -39,7 +42,9 @@ using controller_index_set = index_set<
    block_summary_multi_index,
    transaction_multi_index,
    generated_transaction_multi_index,
-   table_id_multi_index
+   table_id_multi_index,
+   recurring_action_multi_index,
+   protocol_state_multi_index
 >;
 
 using contract_database_index_set = index_set<
@@ -57,11 +62,13 @@ class maybe_session {
 
       maybe_session( maybe_session&& other)
       :_session(move(other._session))
+      ,_usage_session(move(other._usage_session))
       {
       }
 
-      explicit maybe_session(database& db) {
+      maybe_session(database& db, resource_limits_manager& rl) {
          _session = db.start_undo_session(true);
+         _usage_session = rl.start_usage_session();
       }
 
       maybe_session(const maybe_session&) = delete;
@@ -69,16 +76,22 @@ class maybe_session {
       void squash() {
          if (_session)
             _session->squash();
+         if (_usage_session)
+            _usage_session->squash();
       }
 
       void undo() {
          if (_session)
             _session->undo();
+         if (_usage_session)
+            _usage_session->undo();
       }
 
       void push() {
          if (_session)
             _session->push();
+         if (_usage_session)
+            _usage_session->push();
       }
 
       maybe_session& operator = ( maybe_session&& mv ) {
@@ -89,11 +102,19 @@ class maybe_session {
             _session.reset();
          }
 
+         if (mv._usage_session) {
+            _usage_session = move(*mv._usage_session);
+            mv._usage_session.reset();
+         } else {
+            _usage_session.reset();
+         }
+
          return *this;
       };
 
    private:
-      optional<database::session>     _session;
+      optional<database::session>                          _session;
+      optional<resource_limits_manager::usage_session>     _usage_session; ///< in memory resource usage, paired with _session
 };
 
 struct pending_state {
@@ -104,7 +125,8 @@ struct pending_state {
 
    block_state_ptr                    _pending_block_state;
 
-   vector<action_receipt>             _actions;
+   merkle_accumulator                 _action_merkle; ///< action_mroot of the receipts so far, kept as they are added
+   merkle_accumulator                 _trx_merkle;    ///< transaction_mroot of the receipts so far
 
    controller::block_status           _block_status = controller::block_status::incomplete;
 
@@ -155,6 +177,127 @@ struct controller_impl {
       return task->get_future();
    }
 
+   /**
+    *  Recovers the signing keys of a batch of transactions on the thread pool.
+    *
+    *  Rather than one task per transaction, at most one task per pool thread is posted and the batch is striped across
+    *  them, so that the transactions at the front of the batch, which will be needed first, are also recovered first.
+    */
+   void recover_keys_async( const vector<transaction_metadata_ptr>& trxs ) {
+      if( self.skip_auth_check() )
+         return;
+
+      using recovered_keys = pair<chain_id_type, flat_set<public_key_type>>;
+      struct pending_recovery {
+         std::weak_ptr<transaction_metadata>  trx;
+         std::promise<recovered_keys>         keys;
+      };
+
+      auto recoveries = std::make_shared<vector<pending_recovery>>();
+      recoveries->reserve( trxs.size() );
+      for( const auto& mtrx : trxs ) {
+         if( mtrx->signing_keys || mtrx->signing_keys_future.valid() )
+            continue;
+         recoveries->push_back( pending_recovery{ mtrx, std::promise<recovered_keys>() } );
+         mtrx->signing_keys_future = recoveries->back().keys.get_future();
+      }
+      if( recoveries->empty() )
+         return;
+
+      const size_t stride = std::min<size_t>( recoveries->size(), conf.thread_pool_size );
+      for( size_t first = 0; first < stride; ++first ) {
+         boost::asio::post( *thread_pool, [recoveries, first, stride, chain_id = this->chain_id]() {
+            for( size_t i = first; i < recoveries->size(); i += stride ) {
+               auto& r = (*recoveries)[i];
+               try {
+                  auto mtrx = r.trx.lock();
+                  r.keys.set_value( mtrx ? std::make_pair( chain_id, mtrx->trx.get_signature_keys( chain_id ) )
+                                         : std::make_pair( chain_id, flat_set<public_key_type>() ) );
+               } catch( ... ) {
+                  r.keys.set_exception( std::current_exception() );
+               }
+            }
+         } );
+      }
+   }
+
+   /**
+    *  Scheduled transactions that are due in the pending block, unpacked ahead of time on the thread pool and keyed by
+    *  transaction id. An entry is consumed by the push_scheduled_transaction call that retires its transaction.
+    */
+   map<transaction_id_type, std::shared_future<transaction_metadata_ptr>>  prefetched_scheduled_transactions;
+
+   /**
+    *  Copies the packed form of the scheduled transactions due in the pending block out of the database and unpacks
+    *  them on the thread pool, in batches, while the pending block is being started. Entries prefetched for a previous
+    *  block that are still due are kept; all others are dropped.
+    *
+    *  Since the id of a generated transaction is the id of its packed transaction, an entry can never go stale.
+    */
+   void prefetch_scheduled_transactions() {
+      static const size_t max_prefetched = 1024;
+      static const size_t batch_size = 32;
+
+      struct pending_unpack {
+         bytes                                     packed_trx;
+         std::promise<transaction_metadata_ptr>    trx;
+      };
+
+      const auto& idx = db.get_index<generated_transaction_multi_index,by_delay>();
+      const auto pending_time = self.pending_block_time();
+
+      decltype(prefetched_scheduled_transactions) prefetched;
+      auto batch = std::make_shared<vector<pending_unpack>>();
+      auto post_batch = [&]() {
+         if( batch->empty() )
+            return;
+         boost::asio::post( *thread_pool, [batch]() {
+            for( auto& u : *batch ) {
+               try {
+                  signed_transaction dtrx;
+                  fc::datastream<const char*> ds( u.packed_trx.data(), u.packed_trx.size() );
+                  fc::raw::unpack( ds, static_cast<transaction&>(dtrx) );
+                  u.trx.set_value( std::make_shared<transaction_metadata>( dtrx ) );
+               } catch( ... ) {
+                  u.trx.set_exception( std::current_exception() );
+               }
+            }
+         } );
+         batch = std::make_shared<vector<pending_unpack>>();
+      };
+
+      for( auto itr = idx.begin(); itr != idx.end() && itr->delay_until <= pending_time && prefetched.size() < max_prefetched; ++itr ) {
+         auto existing = prefetched_scheduled_transactions.find( itr->trx_id );
+         if( existing != prefetched_scheduled_transactions.end() ) {
+            prefetched.emplace( itr->trx_id, std::move( existing->second ) );
+            continue;
+         }
+         batch->push_back( pending_unpack{ bytes( itr->packed_trx.data(), itr->packed_trx.data() + itr->packed_trx.size() ),
+                                           std::promise<transaction_metadata_ptr>() } );
+         prefetched.emplace( itr->trx_id, batch->back().trx.get_future().share() );
+         if( batch->size() == batch_size )
+            post_batch();
+      }
+      post_batch();
+
+      prefetched_scheduled_transactions = std::move( prefetched );
+   }
+
+   /// @return the prefetched metadata of a scheduled transaction, or an empty pointer if it was not prefetched or failed to unpack
+   transaction_metadata_ptr take_prefetched_scheduled_transaction( const transaction_id_type& id ) {
+      auto itr = prefetched_scheduled_transactions.find( id );
+      if( itr == prefetched_scheduled_transactions.end() )
+         return transaction_metadata_ptr();
+
+      auto prefetched = std::move( itr->second );
+      prefetched_scheduled_transactions.erase( itr );
+      try {
+         return prefetched.get();
+      } catch( ... ) {
+         return transaction_metadata_ptr();
+      }
+   }
+
    void pop_block() {
       auto prev = fork_db.get_block( head->header.previous );
       EOS_ASSERT( prev, block_validate_exception, "attempt to pop beyond last irreversible block" );
@@ -171,6 +314,7 @@ struct controller_impl {
       }
       head = prev;
       db.undo();
+      authorization.reset_authorization_cache();
 
    }
 
@@ -216,6 +360,10 @@ struct controller_impl {
 
    SET_APP_HANDLER( eosio, eosio, canceldelay );
 
+   SET_APP_HANDLER( eosio, eosio, actrecur );
+   SET_APP_HANDLER( eosio, eosio, setrecur );
+   SET_APP_HANDLER( eosio, eosio, delrecur );
+
    fork_db.irreversible.connect( [&]( auto b ) {
                                  on_irreversible(b);
                                  });
@@ -506,8 +654,15 @@ struct controller_impl {
    }
 
    void add_to_snapshot( const snapshot_writer_ptr& snapshot ) const {
-      snapshot->write_section<chain_snapshot_header>([this]( auto &section ){
-         section.add_row(chain_snapshot_header(), db);
+      // until recurring actions are activated the snapshot, and so the integrity hash, keeps the version 1 format
+      const auto* protocol_state = db.find<protocol_state_object>();
+      const bool recurring_actions_activated = protocol_state != nullptr && protocol_state->recurring_actions_activation != 0;
+
+      snapshot->write_section<chain_snapshot_header>([this, recurring_actions_activated]( auto &section ){
+         chain_snapshot_header header;
+         if( !recurring_actions_activated )
+            header.version = 1;
+         section.add_row(header, db);
       });
 
       snapshot->write_section<genesis_state>([this]( auto &section ){
@@ -518,7 +673,7 @@ struct controller_impl {
          section.template add_row<block_header_state>(*fork_db.head(), db);
       });
 
-      controller_index_set::walk_indices([this, &snapshot]( auto utils ){
+      controller_index_set::walk_indices([this, &snapshot, recurring_actions_activated]( auto utils ){
          using value_t = typename decltype(utils)::index_t::value_type;
 
          // skip the table_id_object as its inlined with contract tables section
@@ -526,6 +681,11 @@ struct controller_impl {
             return;
          }
 
+         if ((std::is_same<value_t, recurring_action_object>::value || std::is_same<value_t, protocol_state_object>::value)
+             && !recurring_actions_activated) {
+            return;
+         }
+
          snapshot->write_section<value_t>([this]( auto& section ){
             decltype(utils)::walk(db, [this, &section]( const auto &row ) {
                section.add_row(row, db);
@@ -540,8 +700,8 @@ struct controller_impl {
    }
 
    void read_from_snapshot( const snapshot_reader_ptr& snapshot ) {
-      snapshot->read_section<chain_snapshot_header>([this]( auto &section ){
-         chain_snapshot_header header;
+      chain_snapshot_header header;
+      snapshot->read_section<chain_snapshot_header>([this, &header]( auto &section ){
          section.read_row(header, db);
          header.validate();
       });
@@ -559,7 +719,7 @@ struct controller_impl {
          snapshot_head_block = head->block_num;
       });
 
-      controller_index_set::walk_indices([this, &snapshot]( auto utils ){
+      controller_index_set::walk_indices([this, &snapshot, &header]( auto utils ){
          using value_t = typename decltype(utils)::index_t::value_type;
 
          // skip the table_id_object as its inlined with contract tables section
@@ -567,6 +727,12 @@ struct controller_impl {
             return;
          }
 
+         // version 1 snapshots predate recurring actions
+         if ((std::is_same<value_t, recurring_action_object>::value || std::is_same<value_t, protocol_state_object>::value)
+             && header.version < 2) {
+            return;
+         }
+
          snapshot->read_section<value_t>([this]( auto& section ) {
             bool more = !section.empty();
             while(more) {
@@ -732,16 +898,19 @@ struct controller_impl {
    fc::scoped_exit<std::function<void()>> make_block_restore_point() {
       auto orig_block_transactions_size = pending->_pending_block_state->block->transactions.size();
       auto orig_state_transactions_size = pending->_pending_block_state->trxs.size();
-      auto orig_state_actions_size      = pending->_actions.size();
+      auto orig_action_merkle           = pending->_action_merkle;
+      auto orig_trx_merkle              = pending->_trx_merkle;
 
       std::function<void()> callback = [this,
                                         orig_block_transactions_size,
                                         orig_state_transactions_size,
-                                        orig_state_actions_size]()
+                                        orig_action_merkle,
+                                        orig_trx_merkle]()
       {
          pending->_pending_block_state->block->transactions.resize(orig_block_transactions_size);
          pending->_pending_block_state->trxs.resize(orig_state_transactions_size);
-         pending->_actions.resize(orig_state_actions_size);
+         pending->_action_merkle = orig_action_merkle;
+         pending->_trx_merkle = orig_trx_merkle;
       };
 
       return fc::make_scoped_exit( std::move(callback) );
@@ -779,7 +948,7 @@ struct controller_impl {
          auto restore = make_block_restore_point();
          trace->receipt = push_receipt( gtrx.trx_id, transaction_receipt::soft_fail,
                                         trx_context.billed_cpu_time_us, trace->net_usage );
-         fc::move_append( pending->_actions, move(trx_context.executed) );
+         add_action_receipts( trx_context.executed );
 
          trx_context.squash();
          restore.cancel();
@@ -836,7 +1005,7 @@ struct controller_impl {
    { try {
       maybe_session undo_session;
       if ( !self.skip_db_sessions() )
-         undo_session = maybe_session(db);
+         undo_session = maybe_session(db, resource_limits);
 
       auto gtrx = generated_transaction(gto);
 
@@ -848,14 +1017,17 @@ struct controller_impl {
       // resulting in the GTO being restored and available for a future block to retire.
       remove_scheduled_transaction(gto);
 
-      fc::datastream<const char*> ds( gtrx.packed_trx.data(), gtrx.packed_trx.size() );
-
       EOS_ASSERT( gtrx.delay_until <= self.pending_block_time(), transaction_exception, "this transaction isn't ready",
                  ("gtrx.delay_until",gtrx.delay_until)("pbt",self.pending_block_time())          );
 
-      signed_transaction dtrx;
-      fc::raw::unpack(ds,static_cast<transaction&>(dtrx) );
-      transaction_metadata_ptr trx = std::make_shared<transaction_metadata>( dtrx );
+      transaction_metadata_ptr trx = take_prefetched_scheduled_transaction( gtrx.trx_id );
+      if( !trx ) {
+         fc::datastream<const char*> ds( gtrx.packed_trx.data(), gtrx.packed_trx.size() );
+         signed_transaction dtrx;
+         fc::raw::unpack(ds,static_cast<transaction&>(dtrx) );
+         trx = std::make_shared<transaction_metadata>( dtrx );
+      }
+      const signed_transaction& dtrx = trx->trx;
       trx->accepted = true;
       trx->scheduled = true;
 
@@ -905,7 +1077,7 @@ struct controller_impl {
                                         trx_context.billed_cpu_time_us,
                                         trace->net_usage );
 
-         fc::move_append( pending->_actions, move(trx_context.executed) );
+         add_action_receipts( trx_context.executed );
 
          emit( self.accepted_transaction, trx );
          emit( self.applied_transaction, trace );
@@ -984,6 +1156,23 @@ struct controller_impl {
       return trace;
    } FC_CAPTURE_AND_RETHROW() } /// push_scheduled_transaction
 
+   uint32_t retire_expired_scheduled_transactions( fc::time_point deadline ) {
+      const auto& idx = db.get_index<generated_transaction_multi_index,by_expiration>();
+      const auto pending_time = self.pending_block_time();
+
+      uint32_t retired = 0;
+      auto itr = idx.begin();
+      while( itr != idx.end() && itr->expiration < pending_time && fc::time_point::now() < deadline ) {
+         const auto& gto = *itr;
+         ++itr;
+         if( gto.delay_until > pending_time )
+            continue;
+         push_scheduled_transaction( gto, fc::time_point::maximum(), 0 ); // only pushes an expired receipt
+         ++retired;
+      }
+      return retired;
+   }
+
 
    /**
     *  Adds the transaction receipt to the pending block and returns it.
@@ -998,9 +1187,21 @@ struct controller_impl {
       r.cpu_usage_us         = cpu_usage_us;
       r.net_usage_words      = net_usage_words;
       r.status               = status;
+      pending->_trx_merkle.append( r.digest() );
       return r;
    }
 
+   /**
+    *  Adds the digests of the action receipts of an applied transaction to the pending action_mroot.
+    */
+   void add_action_receipts( const vector<action_receipt>& executed ) {
+      auto digests = batch_digests( executed.size(), [&]( auto& ds, size_t i ) {
+         fc::raw::pack( ds, executed[i] );
+      });
+      for( const auto& d : digests )
+         pending->_action_merkle.append( d );
+   }
+
    /**
     *  This is the entry point for new transactions to the block state. It will check authorization and
     *  determine whether to execute it now or to delay it. Lastly it inserts a transaction receipt into
@@ -1009,7 +1210,8 @@ struct controller_impl {
    transaction_trace_ptr push_transaction( const transaction_metadata_ptr& trx,
                                            fc::time_point deadline,
                                            uint32_t billed_cpu_time_us,
-                                           bool explicit_billed_cpu_time = false )
+                                           bool explicit_billed_cpu_time = false,
+                                           uint64_t checktime_limit = 0 )
    {
       EOS_ASSERT(deadline != fc::time_point(), transaction_exception, "deadline cannot be uninitialized");
 
@@ -1022,6 +1224,7 @@ struct controller_impl {
          trx_context.deadline = deadline;
          trx_context.explicit_billed_cpu_time = explicit_billed_cpu_time;
          trx_context.billed_cpu_time_us = billed_cpu_time_us;
+         trx_context.checktime_limit = checktime_limit;
          trace = trx_context.trace;
          try {
             if( trx->implicit ) {
@@ -1068,7 +1271,7 @@ struct controller_impl {
                trace->receipt = r;
             }
 
-            fc::move_append(pending->_actions, move(trx_context.executed));
+            add_action_receipts( trx_context.executed );
 
             // call the accept signal but only once for this transaction
             if (!trx->accepted) {
@@ -1121,7 +1324,7 @@ struct controller_impl {
          EOS_ASSERT( db.revision() == head->block_num, database_exception, "db revision is not on par with head block",
                      ("db.revision()", db.revision())("controller_head_block", head->block_num)("fork_db_head_block", fork_db.head()->block_num) );
 
-         pending.emplace(maybe_session(db));
+         pending.emplace(maybe_session(db, resource_limits));
       } else {
          pending.emplace(maybe_session());
       }
@@ -1138,6 +1341,9 @@ struct controller_impl {
       //modify state in speculative block only if we are speculative reads mode (other wise we need clean state for head or irreversible reads)
       if ( read_mode == db_read_mode::SPECULATIVE || pending->_block_status != controller::block_status::incomplete ) {
 
+         // unpack the due scheduled transactions on the thread pool while onblock executes
+         prefetch_scheduled_transactions();
+
          const auto& gpo = db.get<global_property_object>();
          if( gpo.proposed_schedule_block_num.valid() && // if there is a proposed schedule that was proposed in a block ...
              ( *gpo.proposed_schedule_block_num <= pending->_pending_block_state->dpos_irreversible_blocknum ) && // ... that has now become irreversible ...
@@ -1176,10 +1382,14 @@ struct controller_impl {
          } catch( ... ) {
          }
 
+         fire_recurring_actions();
+
          clear_expired_input_transactions();
          update_producers_authority();
       }
 
+      authorization.reset_authorization_cache();
+
       guard_pending.cancel();
    } // start_block
 
@@ -1193,31 +1403,42 @@ struct controller_impl {
       static_cast<signed_block_header&>(*p->block) = p->header;
    } /// sign_block
 
-   void apply_block( const signed_block_ptr& b, controller::block_status s ) { try {
+   /**
+    *  @param add_to_fork_db  if true the pending block state becomes the block's state in the fork database, so no
+    *                         separate state needs to be built for it beforehand
+    */
+   void apply_block( const signed_block_ptr& b, controller::block_status s, bool add_to_fork_db = false ) { try {
       try {
          EOS_ASSERT( b->block_extensions.size() == 0, block_validate_exception, "no supported extensions" );
          auto producer_block_id = b->id();
          start_block( b->timestamp, b->confirmed, s , producer_block_id);
 
-         std::vector<transaction_metadata_ptr> packed_transactions;
-         packed_transactions.reserve( b->transactions.size() );
+         vector<const packed_transaction*> packed;
+         vector<signed_transaction> unpacked;
          for( const auto& receipt : b->transactions ) {
             if( receipt.trx.contains<packed_transaction>()) {
                auto& pt = receipt.trx.get<packed_transaction>();
-               auto mtrx = std::make_shared<transaction_metadata>( pt );
-               if( !self.skip_auth_check() ) {
-                  std::weak_ptr<transaction_metadata> mtrx_wp = mtrx;
-                  mtrx->signing_keys_future = async_thread_pool( [chain_id = this->chain_id, mtrx_wp]() {
-                     auto mtrx = mtrx_wp.lock();
-                     return mtrx ?
-                            std::make_pair( chain_id, mtrx->trx.get_signature_keys( chain_id ) ) :
-                            std::make_pair( chain_id, decltype( mtrx->trx.get_signature_keys( chain_id ) ){} );
-                  } );
-               }
-               packed_transactions.emplace_back( std::move( mtrx ) );
+               packed.push_back( &pt );
+               unpacked.emplace_back( pt.get_signed_transaction() );
             }
          }
 
+         // the ids and signed ids of all transactions of the block are hashed as two batches
+         auto ids = batch_digests( unpacked.size(), [&]( auto& ds, size_t i ) {
+            fc::raw::pack( ds, static_cast<const transaction&>(unpacked[i]) );
+         });
+         auto signed_ids = batch_digests( packed.size(), [&]( auto& ds, size_t i ) {
+            fc::raw::pack( ds, *packed[i] );
+         });
+
+         std::vector<transaction_metadata_ptr> packed_transactions;
+         packed_transactions.reserve( packed.size() );
+         for( size_t i = 0; i < packed.size(); ++i ) {
+            packed_transactions.emplace_back( std::make_shared<transaction_metadata>( std::move(unpacked[i]), *packed[i],
+                                                                                      ids[i], signed_ids[i] ) );
+         }
+         recover_keys_async( packed_transactions );
+
          transaction_trace_ptr trace;
 
          size_t packed_idx = 0;
@@ -1269,7 +1490,7 @@ struct controller_impl {
          pending->_pending_block_state->header.producer_signature = b->producer_signature;
          static_cast<signed_block_header&>(*pending->_pending_block_state->block) =  pending->_pending_block_state->header;
 
-         commit_block(false);
+         commit_block(add_to_fork_db);
          return;
       } catch ( const fc::exception& e ) {
          edump((e.to_detail_string()));
@@ -1333,6 +1554,18 @@ struct controller_impl {
          EOS_ASSERT( (s == controller::block_status::irreversible || s == controller::block_status::validated),
                      block_validate_exception, "invalid block status for replay" );
          emit( self.pre_accepted_block, b );
+
+         // An irreversible block needs no fork choice and its signature is not checked, so its header state is only
+         // built once, as the pending block state while it is applied, rather than also beforehand for the fork
+         // database. The id check in apply_block covers every header field that next() would have validated.
+         if( s == controller::block_status::irreversible && read_mode != db_read_mode::IRREVERSIBLE && !conf.force_all_checks ) {
+            EOS_ASSERT( b->previous == head->id, unlinkable_block_exception, "unlinkable block ${id}",
+                        ("id", b->id())("previous", b->previous) );
+            apply_block( b, s, true );
+            emit( self.irreversible_block, head );
+            return;
+         }
+
          const bool skip_validate_signee = !conf.force_all_checks;
          auto new_header_state = fork_db.add( b, skip_validate_signee );
 
@@ -1420,6 +1653,7 @@ struct controller_impl {
                unapplied_transactions[t->signed_id] = t;
          }
          pending.reset();
+         authorization.reset_authorization_cache();
       }
    }
 
@@ -1428,23 +1662,37 @@ struct controller_impl {
       return false;
    }
 
-   void set_action_merkle() {
-      vector<digest_type> action_digests;
-      action_digests.reserve( pending->_actions.size() );
-      for( const auto& a : pending->_actions )
-         action_digests.emplace_back( a.digest() );
+   /**
+    *  Serializes count messages with pack( datastream, i ) into one contiguous buffer and hashes all of them in a
+    *  single batch; pack is called twice per message, once to size it and once to write it.
+    */
+   template<typename Pack>
+   static vector<digest_type> batch_digests( size_t count, Pack&& pack ) {
+      vector<char> buffer;
+      vector<size_t> ends;
+      ends.reserve( count );
+      for( size_t i = 0; i < count; ++i ) {
+         const size_t start = buffer.size();
+         fc::datastream<size_t> size_stream;
+         pack( size_stream, i );
+         buffer.resize( start + size_stream.tellp() );
+         fc::datastream<char*> ds( buffer.data() + start, size_stream.tellp() );
+         pack( ds, i );
+         ends.push_back( buffer.size() );
+      }
 
-      pending->_pending_block_state->header.action_mroot = merkle( move(action_digests) );
+      vector<sha256_batch::message> msgs( count );
+      for( size_t i = 0, start = 0; i < count; start = ends[i++] )
+         msgs[i] = sha256_batch::message{ buffer.data() + start, ends[i] - start };
+      return sha256_batch::hash( msgs );
    }
 
-   void set_trx_merkle() {
-      vector<digest_type> trx_digests;
-      const auto& trxs = pending->_pending_block_state->block->transactions;
-      trx_digests.reserve( trxs.size() );
-      for( const auto& a : trxs )
-         trx_digests.emplace_back( a.digest() );
+   void set_action_merkle() {
+      pending->_pending_block_state->header.action_mroot = pending->_action_merkle.root();
+   }
 
-      pending->_pending_block_state->header.transaction_mroot = merkle( move(trx_digests) );
+   void set_trx_merkle() {
+      pending->_pending_block_state->header.transaction_mroot = pending->_trx_merkle.root();
    }
 
 
@@ -1689,6 +1937,80 @@ struct controller_impl {
    */
 
 
+   /**
+    *  Dispatches the recurring actions that are due in the pending block, oldest first, each as its own implicit
+    *  transaction under the active authority of its contract. Nothing here depends on the clock, so every node fires
+    *  the same actions with the same outcome: each action is billed config::recurring_action_cpu_usage and fails
+    *  after config::recurring_action_checktime_limit checkpoints, and the block fires as many actions as fit in
+    *  config::max_recurring_actions_cpu_usage. The rest stay due and are fired by the following blocks.
+    *
+    *  An entry whose account is no longer privileged is skipped until the account is privileged again.
+    *
+    *  The schedule is advanced whether or not the action succeeds, so a failing action does not retry every block.
+    */
+   void fire_recurring_actions() {
+      const auto* protocol_state = db.find<protocol_state_object>();
+      if( protocol_state == nullptr || protocol_state->recurring_actions_activation == 0 )
+         return;
+
+      const auto& idx = db.get_index<recurring_action_multi_index, by_next_fire>();
+      const auto pending_time = self.pending_block_time();
+
+      for( uint32_t billed = 0; billed + config::recurring_action_cpu_usage <= config::max_recurring_actions_cpu_usage; ) {
+         auto itr = idx.begin();
+         if( itr == idx.end() || itr->next_fire > pending_time )
+            break;
+
+         const auto& recur = *itr;
+         action act;
+         act.account = recur.account;
+         act.name = recur.action;
+         act.authorization = vector<permission_level>{{recur.account, config::active_name}};
+         act.data.assign( recur.data.begin(), recur.data.end() );
+
+         // the next fire is aligned to the interval rather than to this block, so a late block does not shift the schedule
+         const auto interval = fc::milliseconds( recur.interval_ms );
+         auto next_fire = recur.next_fire + interval;
+         if( next_fire <= pending_time )
+            next_fire = pending_time + interval;
+         db.modify( recur, [&]( auto& r ) {
+            r.next_fire = next_fire;
+         });
+
+         if( !db.get<account_object,by_name>( recur.account ).privileged )
+            continue;
+
+         // billing checks are skipped while replaying, so an account which cannot pay is skipped here on every node
+         const auto cpu_limit = resource_limits.get_account_cpu_limit( recur.account );
+         if( cpu_limit >= 0 && cpu_limit < config::recurring_action_cpu_usage )
+            continue;
+
+         billed += config::recurring_action_cpu_usage;
+
+         signed_transaction trx;
+         trx.actions.emplace_back( std::move(act) );
+         trx.set_reference_block( self.head_block_id() );
+         trx.expiration = pending_time + fc::microseconds(999'999); // Round up to nearest second to avoid appearing expired
+
+         try {
+            auto mtrx = std::make_shared<transaction_metadata>( trx );
+            mtrx->implicit = true;
+            auto reset_in_trx_requiring_checks = fc::make_scoped_exit([old_value=in_trx_requiring_checks,this](){
+                  in_trx_requiring_checks = old_value;
+               });
+            in_trx_requiring_checks = true;
+            push_transaction( mtrx, fc::time_point::maximum(), config::recurring_action_cpu_usage, true,
+                              config::recurring_action_checktime_limit );
+         } catch( const boost::interprocess::bad_alloc& e  ) {
+            elog( "recurring action failed due to a bad allocation" );
+            throw;
+         } catch( const fc::exception& e ) {
+            dlog( "recurring action ${a}::${n} failed: ${e}", ("a", trx.actions.front().account)("n", trx.actions.front().name)("e", e.to_string()) );
+         } catch( ... ) {
+         }
+      }
+   }
+
    /**
     *  At the start of each block we notify the system contract with a transaction that passes in
     *  the block header of the prior block (which is currently our head block)
@@ -1746,6 +2068,7 @@ void controller::add_indices() {
 }
 
 void controller::startup( std::function<bool()> shutdown, const snapshot_reader_ptr& snapshot ) {
+   deadline_timer::calibrate(); // before any transaction_context captures its start time
    my->head = my->fork_db.head();
    if( !my->head ) {
       elog( "No head block in fork db, perhaps we need to replay" );
@@ -1794,6 +2117,14 @@ void controller::push_block( std::future<block_state_ptr>& block_state_future )
    my->push_block( block_state_future );
 }
 
+void controller::recover_keys_async( const transaction_metadata_ptr& trx ) {
+   my->recover_keys_async( {trx} );
+}
+
+void controller::recover_keys_async( const vector<transaction_metadata_ptr>& trxs ) {
+   my->recover_keys_async( trxs );
+}
+
 transaction_trace_ptr controller::push_transaction( const transaction_metadata_ptr& trx, fc::time_point deadline, uint32_t billed_cpu_time_us ) {
    validate_db_available_size();
    EOS_ASSERT( get_read_mode() != chain::db_read_mode::READ_ONLY, transaction_type_exception, "push transaction not allowed in read-only mode" );
@@ -1807,6 +2138,12 @@ transaction_trace_ptr controller::push_scheduled_transaction( const transaction_
    return my->push_scheduled_transaction( trxid, deadline, billed_cpu_time_us, billed_cpu_time_us > 0 );
 }
 
+uint32_t controller::retire_expired_scheduled_transactions( fc::time_point deadline ) {
+   validate_db_available_size();
+   EOS_ASSERT( my->pending, block_validate_exception, "it is not valid to retire scheduled transactions when no pending block exists" );
+   return my->retire_expired_scheduled_transactions( deadline );
+}
+
 const flat_set<account_name>& controller::get_actor_whitelist() const {
    return my->conf.actor_whitelist;
 }
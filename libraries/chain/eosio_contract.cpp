@@ -17,6 +17,8 @@
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/contract_types.hpp>
 #include <eosio/chain/producer_object.hpp>
+#include <eosio/chain/recurring_action_object.hpp>
+#include <eosio/chain/protocol_state_object.hpp>
 
 #include <eosio/chain/wasm_interface.hpp>
 #include <eosio/chain/abi_serializer.hpp>
@@ -343,6 +345,8 @@ void apply_eosio_linkauth(apply_context& context) {
       auto link_key = boost::make_tuple(requirement.account, requirement.code, requirement.type);
       auto link = db.find<permission_link_object, by_action_name>(link_key);
 
+      context.control.get_mutable_authorization_manager().invalidate_linked_permission_cache();
+
       if( link ) {
          EOS_ASSERT(link->required_permission != requirement.requirement, action_validate_exception,
                     "Attempting to update required authority, but new requirement is same as old");
@@ -382,6 +386,7 @@ void apply_eosio_unlinkauth(apply_context& context) {
       -(int64_t)(config::billable_size_v<permission_link_object>)
    );
 
+   context.control.get_mutable_authorization_manager().invalidate_linked_permission_cache();
    db.remove(*link);
 }
 
@@ -394,4 +399,105 @@ void apply_eosio_canceldelay(apply_context& context) {
    context.cancel_deferred_transaction(transaction_id_to_sender_id(trx_id), account_name());
 }
 
+static void assert_recurring_actions_activated( const apply_context& context ) {
+   const auto* state = context.db.find<protocol_state_object>();
+   EOS_ASSERT( state != nullptr && state->recurring_actions_activation != 0, action_validate_exception,
+               "recurring actions have not been activated" );
+}
+
+/**
+ *  Activates recurring actions, which change the state and the snapshot format. Requires the authority of eosio,
+ *  which on a live chain means a supermajority of the producers.
+ */
+void apply_eosio_actrecur(apply_context& context) {
+   auto& db = context.db;
+   context.require_authorization(config::system_account_name);
+
+   const auto activation = context.control.head_block_num() + 1;
+   const auto* state = db.find<protocol_state_object>();
+   if( state == nullptr ) {
+      db.create<protocol_state_object>([&]( auto& s ) {
+         s.recurring_actions_activation = activation;
+      });
+   } else {
+      EOS_ASSERT( state->recurring_actions_activation == 0, action_validate_exception,
+                  "recurring actions are already activated" );
+      db.modify( *state, [&]( auto& s ) {
+         s.recurring_actions_activation = activation;
+      });
+   }
+}
+
+/**
+ *  Recurring actions are dispatched at the start of every block with a fixed budget that does not depend on the clock,
+ *  so a long running action holds up the block; only privileged accounts, whose code is trusted by the producers, may
+ *  schedule them.
+ */
+void apply_eosio_setrecur(apply_context& context) {
+   assert_recurring_actions_activated(context);
+
+   auto& db = context.db;
+   auto  act = context.act.data_as<setrecur>();
+   context.require_authorization(act.account);
+
+   const auto& account = db.get<account_object,by_name>(act.account);
+   EOS_ASSERT( account.privileged, action_validate_exception,
+               "only privileged accounts can schedule recurring actions" );
+   EOS_ASSERT( act.interval_ms >= static_cast<uint32_t>(config::block_interval_ms), action_validate_exception,
+               "recurring action interval must be at least one block interval" );
+   EOS_ASSERT( act.data.size() <= context.control.get_global_properties().configuration.max_inline_action_size,
+               action_validate_exception, "recurring action data exceeds maximum size" );
+
+   const auto next_fire = context.control.pending_block_time() + fc::milliseconds(act.interval_ms);
+
+   const auto& idx = db.get_index<recurring_action_multi_index, by_account_action>();
+   auto itr = idx.find( boost::make_tuple(act.account, act.action) );
+   if( itr == idx.end() ) {
+      uint32_t existing = 0;
+      for( auto i = idx.lower_bound( boost::make_tuple(act.account) ); i != idx.end() && i->account == act.account; ++i )
+         ++existing;
+      EOS_ASSERT( existing < config::max_recurring_actions_per_account, action_validate_exception,
+                  "account already has the maximum number of recurring actions" );
+
+      db.create<recurring_action_object>([&]( auto& r ) {
+         r.account     = act.account;
+         r.action      = act.action;
+         r.interval_ms = act.interval_ms;
+         r.next_fire   = next_fire;
+         r.data.assign( act.data.data(), act.data.size() );
+      });
+
+      context.add_ram_usage( act.account, (int64_t)(config::billable_size_v<recurring_action_object> + act.data.size()) );
+   } else {
+      int64_t old_size = (int64_t)itr->data.size();
+      int64_t new_size = (int64_t)act.data.size();
+
+      db.modify( *itr, [&]( auto& r ) {
+         r.interval_ms = act.interval_ms;
+         r.next_fire   = next_fire;
+         r.data.assign( act.data.data(), act.data.size() );
+      });
+
+      if( new_size != old_size )
+         context.add_ram_usage( act.account, new_size - old_size );
+   }
+}
+
+void apply_eosio_delrecur(apply_context& context) {
+   assert_recurring_actions_activated(context);
+
+   auto& db = context.db;
+   auto  act = context.act.data_as<delrecur>();
+   context.require_authorization(act.account);
+
+   const auto* recur = db.find<recurring_action_object, by_account_action>( boost::make_tuple(act.account, act.action) );
+   EOS_ASSERT( recur != nullptr, action_validate_exception,
+               "recurring action '${action}' of account '${account}' does not exist",
+               ("account", act.account)("action", act.action) );
+
+   context.add_ram_usage( act.account, -(int64_t)(config::billable_size_v<recurring_action_object> + recur->data.size()) );
+
+   db.remove(*recur);
+}
+
 } } // namespace eosio::chain
@@ -151,6 +151,26 @@ abi_def eosio_contract_abi(const abi_def& eosio_system_abi)
          }
    });
 
+   eos_abi.structs.emplace_back( struct_def {
+      "actrecur", "", {}
+   });
+
+   eos_abi.structs.emplace_back( struct_def {
+      "setrecur", "", {
+         {"account", "account_name"},
+         {"action", "action_name"},
+         {"interval_ms", "uint32"},
+         {"data", "bytes"}
+      }
+   });
+
+   eos_abi.structs.emplace_back( struct_def {
+      "delrecur", "", {
+         {"account", "account_name"},
+         {"action", "action_name"}
+      }
+   });
+
    eos_abi.structs.emplace_back( struct_def {
       "setcode", "", {
          {"account", "account_name"},
@@ -232,6 +252,9 @@ abi_def eosio_contract_abi(const abi_def& eosio_system_abi)
    eos_abi.actions.push_back( action_def{name("canceldelay"), "canceldelay",""} );
    eos_abi.actions.push_back( action_def{name("onerror"), "onerror",""} );
    eos_abi.actions.push_back( action_def{name("onblock"), "onblock",""} );
+   eos_abi.actions.push_back( action_def{name("actrecur"), "actrecur",""} );
+   eos_abi.actions.push_back( action_def{name("setrecur"), "setrecur",""} );
+   eos_abi.actions.push_back( action_def{name("delrecur"), "delrecur",""} );
 
    return eos_abi;
 }
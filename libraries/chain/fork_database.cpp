@@ -1,51 +1,248 @@
 #include <eosio/chain/fork_database.hpp>
 #include <eosio/chain/exceptions.hpp>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
-#include <boost/multi_index/composite_key.hpp>
 #include <fc/io/fstream.hpp>
-#include <fstream>
+#include <fc/scoped_exit.hpp>
+#include <cstdio>
+#include <unistd.h>
 
 namespace eosio { namespace chain {
-   using boost::multi_index_container;
-   using namespace boost::multi_index;
-
-
-   struct by_block_id;
-   struct by_block_num;
-   struct by_lib_block_num;
-   struct by_prev;
-   typedef multi_index_container<
-      block_state_ptr,
-      indexed_by<
-         hashed_unique< tag<by_block_id>, member<block_header_state, block_id_type, &block_header_state::id>, std::hash<block_id_type>>,
-         ordered_non_unique< tag<by_prev>, const_mem_fun<block_header_state, const block_id_type&, &block_header_state::prev> >,
-         ordered_non_unique< tag<by_block_num>,
-            composite_key< block_state,
-               member<block_header_state,uint32_t,&block_header_state::block_num>,
-               member<block_state,bool,&block_state::in_current_chain>
-            >,
-            composite_key_compare< std::less<uint32_t>, std::greater<bool> >
-         >,
-         ordered_non_unique< tag<by_lib_block_num>,
-            composite_key< block_header_state,
-                member<block_header_state,uint32_t,&block_header_state::dpos_irreversible_blocknum>,
-                member<block_header_state,uint32_t,&block_header_state::bft_irreversible_blocknum>,
-                member<block_header_state,uint32_t,&block_header_state::block_num>
-            >,
-            composite_key_compare< std::greater<uint32_t>, std::greater<uint32_t>, std::greater<uint32_t> >
-         >
-      >
-   > fork_multi_index_type;
 
+   /**
+    *  The fork database is persisted as a log of the operations applied to it rather than as one dump written on
+    *  close. Every record is its size, a one byte type and its payload; the log starts with a magic number so that a
+    *  legacy dump can still be read. Once the log holds enough records for blocks that have since been pruned it is
+    *  compacted into one add record per live block.
+    *
+    *  Each record is flushed as soon as it is written and the log is synced to disk whenever the last irreversible
+    *  block advances, so a crash loses at most the tail of the log, which ends in a truncated record that is dropped
+    *  when the log is loaded.
+    */
+   namespace {
+      const uint32_t fork_db_log_magic   = 0x31424446; ///< "FDB1"
+
+      enum fork_db_record_type : uint8_t {
+         add_record          = 1, ///< block_state
+         remove_record       = 2, ///< block id; removes the block and every block built on it
+         update_record       = 3, ///< block id, validated, in_current_chain
+         confirmation_record = 4, ///< header_confirmation
+         prune_record        = 5, ///< block id
+         head_record         = 6  ///< block id
+      };
+
+      const uint32_t min_fork_db_log_records_before_compaction = 256;
+   }
 
    struct fork_database_impl {
-      fork_multi_index_type index;
-      block_state_ptr       head;
+      /**
+       *  Blocks are stored by height in a ring of small vectors indexed by block number modulo the capacity, each
+       *  vector holding the competing blocks of one height in the order they were added. A block id embeds its
+       *  block number, so looking up an id only scans the blocks of that one height.
+       */
+      vector<branch_type>   ring;
+      uint32_t              first_num = 0;     ///< lowest block number stored, meaningful only if size > 0
+      uint32_t              last_num = 0;      ///< highest block number stored, meaningful only if size > 0
+      size_t                size = 0;
+
+      block_state_ptr       head; ///< kept up to date by every change, so that head() is a pure read from any thread
+
       fc::path              datadir;
+      FILE*                 log = nullptr;
+      uint32_t              log_records = 0;
+      bool                  logging = false;
+      vector<char>          record; ///< buffer a record is packed into before it is written
+
+      branch_type* slot( uint32_t num ) {
+         if( size == 0 || num < first_num || num > last_num )
+            return nullptr;
+         return &ring[num & (ring.size() - 1)];
+      }
+
+      const branch_type* slot( uint32_t num )const {
+         return const_cast<fork_database_impl*>(this)->slot( num );
+      }
+
+      block_state_ptr find( const block_id_type& id )const {
+         if( const auto* s = slot( block_header::num_from_id( id ) ) ) {
+            for( const auto& b : *s )
+               if( b->id == id ) return b;
+         }
+         return block_state_ptr();
+      }
+
+      /// the children of a block are the blocks one height above it that link to it
+      template<typename F>
+      void for_each_child( const block_id_type& id, F&& f ) {
+         if( auto* s = slot( block_header::num_from_id( id ) + 1 ) ) {
+            for( const auto& b : *s )
+               if( b->header.previous == id ) f( b );
+         }
+      }
+
+      void reserve( uint32_t lo, uint32_t hi ) {
+         size_t capacity = std::max<size_t>( ring.size(), 16 );
+         while( capacity <= hi - lo )
+            capacity *= 2;
+         if( capacity == ring.size() )
+            return;
+
+         vector<branch_type> grown( capacity );
+         if( size > 0 ) {
+            for( uint32_t n = first_num; n <= last_num; ++n )
+               grown[n & (capacity - 1)] = std::move( ring[n & (ring.size() - 1)] );
+         }
+         ring = std::move( grown );
+      }
+
+      bool insert( const block_state_ptr& s ) {
+         auto num = s->block_num;
+         if( size == 0 ) {
+            reserve( num, num );
+            first_num = last_num = num;
+         } else {
+            auto lo = std::min( first_num, num );
+            auto hi = std::max( last_num, num );
+            reserve( lo, hi );
+            first_num = lo;
+            last_num = hi;
+         }
+
+         auto& s_blocks = ring[num & (ring.size() - 1)];
+         for( const auto& b : s_blocks )
+            if( b->id == s->id ) return false;
+         s_blocks.push_back( s );
+         ++size;
+         return true;
+      }
+
+      void erase( const block_id_type& id ) {
+         auto* s = slot( block_header::num_from_id( id ) );
+         if( !s ) return;
+
+         auto itr = std::find_if( s->begin(), s->end(), [&]( const auto& b ) { return b->id == id; } );
+         if( itr == s->end() ) return;
+         s->erase( itr );
+         --size;
+
+         if( head && head->id == id )
+            head.reset();
+
+         // keep first_num and last_num on occupied heights
+         while( size > 0 && ring[first_num & (ring.size() - 1)].empty() ) ++first_num;
+         while( size > 0 && ring[last_num & (ring.size() - 1)].empty() ) --last_num;
+      }
+
+      /// the block at height num that prune treats as irreversible: the one in the current chain, else the first added
+      block_state_ptr oldest_at( uint32_t num )const {
+         const auto* s = slot( num );
+         if( !s || s->empty() ) return block_state_ptr();
+         for( const auto& b : *s )
+            if( b->in_current_chain ) return b;
+         return s->front();
+      }
+
+      /// head is the block with the greatest (dpos lib, bft lib, block number); ties go to the block added first
+      static bool better_head( const block_state_ptr& a, const block_state_ptr& b ) {
+         return std::tie( a->dpos_irreversible_blocknum, a->bft_irreversible_blocknum, a->block_num )
+              > std::tie( b->dpos_irreversible_blocknum, b->bft_irreversible_blocknum, b->block_num );
+      }
+
+      void recompute_head() {
+         head.reset();
+         for( uint32_t n = first_num; size > 0 && n <= last_num; ++n ) {
+            for( const auto& b : ring[n & (ring.size() - 1)] )
+               if( !head || better_head( b, head ) ) head = b;
+         }
+      }
+
+      template<typename... Args>
+      void append_record( FILE* f, fork_db_record_type type, const Args&... args ) {
+         const uint8_t t = type;
+         fc::datastream<size_t> size_ds;
+         fc::raw::pack( size_ds, t );
+         (void)std::initializer_list<int>{ (fc::raw::pack( size_ds, args ), 0)... };
+         const uint32_t len = size_ds.tellp();
+
+         record.resize( sizeof(len) + len );
+         fc::datastream<char*> ds( record.data(), record.size() );
+         fc::raw::pack( ds, len );
+         fc::raw::pack( ds, t );
+         (void)std::initializer_list<int>{ (fc::raw::pack( ds, args ), 0)... };
+
+         EOS_ASSERT( fwrite( record.data(), 1, record.size(), f ) == record.size(), fork_database_exception,
+                     "unable to write to the fork database log" );
+      }
+
+      template<typename... Args>
+      void write_record( fork_db_record_type type, const Args&... args ) {
+         if( !logging ) return;
+         append_record( log, type, args... );
+         EOS_ASSERT( fflush( log ) == 0, fork_database_exception, "unable to flush the fork database log" );
+         ++log_records;
+      }
+
+      /// called when the last irreversible block advances
+      void sync_log() {
+         if( log )
+            ::fsync( fileno( log ) );
+      }
+
+      static FILE* open_file( const fc::path& p, bool truncate ) {
+         FILE* f = fopen( p.generic_string().c_str(), truncate ? "wb" : "ab" );
+         EOS_ASSERT( f != nullptr, fork_database_exception, "unable to open fork database log ${p}", ("p", p.generic_string()) );
+         return f;
+      }
+
+      static void write_magic( FILE* f ) {
+         EOS_ASSERT( fwrite( &fork_db_log_magic, 1, sizeof(fork_db_log_magic), f ) == sizeof(fork_db_log_magic),
+                     fork_database_exception, "unable to write to the fork database log" );
+      }
+
+      void open_log( bool truncate ) {
+         log = open_file( datadir / config::forkdb_filename, truncate );
+         if( truncate ) {
+            write_magic( log );
+            fflush( log );
+         }
+         logging = true;
+      }
+
+      void close_log() {
+         logging = false;
+         if( log ) {
+            fclose( log );
+            log = nullptr;
+         }
+      }
+
+      /// rewrites the log as one add record per live block, lowest height first, followed by the head
+      void compact_log() {
+         close_log();
+
+         auto fork_db_dat = datadir / config::forkdb_filename;
+         auto fork_db_tmp = datadir / (string(config::forkdb_filename) + ".tmp");
+         {
+            FILE* out = open_file( fork_db_tmp, true );
+            auto close_out = fc::make_scoped_exit( [out]() { fclose( out ); } );
+            write_magic( out );
+            for( uint32_t n = first_num; size > 0 && n <= last_num; ++n ) {
+               for( const auto& b : ring[n & (ring.size() - 1)] )
+                  append_record( out, add_record, *b );
+            }
+            if( head )
+               append_record( out, head_record, head->id );
+            EOS_ASSERT( fflush( out ) == 0 && ::fsync( fileno( out ) ) == 0, fork_database_exception,
+                        "unable to write the compacted fork database log" );
+         }
+         fc::rename( fork_db_tmp, fork_db_dat );
+
+         log_records = size;
+         open_log( false );
+      }
+
+      void maybe_compact_log() {
+         if( logging && log_records > 2 * size + min_fork_db_log_records_before_compaction )
+            compact_log();
+      }
    };
 
 
@@ -61,47 +258,135 @@ namespace eosio { namespace chain {
          fc::read_file_contents( fork_db_dat, content );
 
          fc::datastream<const char*> ds( content.data(), content.size() );
-         unsigned_int size; fc::raw::unpack( ds, size );
-         for( uint32_t i = 0, n = size.value; i < n; ++i ) {
-            block_state s;
-            fc::raw::unpack( ds, s );
-            set( std::make_shared<block_state>( move( s ) ) );
-         }
-         block_id_type head_id;
-         fc::raw::unpack( ds, head_id );
+         uint32_t magic = 0;
+         if( content.size() >= sizeof(magic) )
+            fc::raw::unpack( ds, magic );
+
+         if( magic == fork_db_log_magic ) {
+            optional<block_id_type> head_id;
+            bool truncated = false;
+            while( ds.remaining() ) {
+               uint32_t len = 0;
+               if( ds.remaining() >= sizeof(len) )
+                  fc::raw::unpack( ds, len );
+               if( len == 0 || ds.remaining() < len ) {
+                  wlog( "fork database log ends with a truncated record, ignoring it" );
+                  truncated = true;
+                  break;
+               }
+               fc::datastream<const char*> rec( ds.pos(), len );
+               ds.skip( len );
+
+               uint8_t type = 0;
+               fc::raw::unpack( rec, type );
+               block_id_type id;
+               switch( type ) {
+                  case add_record: {
+                     block_state s;
+                     fc::raw::unpack( rec, s );
+                     auto bsp = std::make_shared<block_state>( move( s ) );
+                     if( my->size == 0 )
+                        set( bsp );
+                     else
+                        add( bsp, true );
+                     break;
+                  }
+                  case remove_record:
+                     fc::raw::unpack( rec, id );
+                     remove( id );
+                     break;
+                  case update_record: {
+                     bool validated = false, in_current_chain = false;
+                     fc::raw::unpack( rec, id );
+                     fc::raw::unpack( rec, validated );
+                     fc::raw::unpack( rec, in_current_chain );
+                     if( auto b = my->find( id ) ) {
+                        b->validated = validated;
+                        b->in_current_chain = in_current_chain;
+                     }
+                     break;
+                  }
+                  case confirmation_record: {
+                     header_confirmation c;
+                     fc::raw::unpack( rec, c );
+                     if( my->find( c.block_id ) )
+                        add( c );
+                     break;
+                  }
+                  case prune_record:
+                     fc::raw::unpack( rec, id );
+                     if( auto b = my->find( id ) )
+                        prune( b );
+                     break;
+                  case head_record:
+                     fc::raw::unpack( rec, id );
+                     head_id = id;
+                     break;
+                  default:
+                     EOS_THROW( fork_database_exception, "unknown fork database record type ${t}", ("t", type) );
+               }
+               if( type != head_record )
+                  head_id.reset();
+               ++my->log_records;
+            }
+
+            if( head_id ) {
+               auto h = my->find( *head_id );
+               if( h ) {
+                  my->head = h;
+               }
+            }
+            if( truncated )
+               my->compact_log();
+            else
+               my->open_log( false );
+         } else {
+            // legacy dump written in one piece on close
+            ds = fc::datastream<const char*>( content.data(), content.size() );
+            unsigned_int size; fc::raw::unpack( ds, size );
+            for( uint32_t i = 0, n = size.value; i < n; ++i ) {
+               block_state s;
+               fc::raw::unpack( ds, s );
+               set( std::make_shared<block_state>( move( s ) ) );
+            }
+            block_id_type head_id;
+            fc::raw::unpack( ds, head_id );
 
-         my->head = get_block( head_id );
+            my->head = get_block( head_id );
 
-         fc::remove( fork_db_dat );
+            my->compact_log();
+         }
+      } else {
+         my->open_log( true );
       }
    }
 
    void fork_database::close() {
-      if( my->index.size() == 0 ) return;
+      if( my->size == 0 ) {
+         my->close_log();
+         return;
+      }
 
-      auto fork_db_dat = my->datadir / config::forkdb_filename;
-      std::ofstream out( fork_db_dat.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
-      uint32_t num_blocks_in_fork_db = my->index.size();
-      fc::raw::pack( out, unsigned_int{num_blocks_in_fork_db} );
-      for( const auto& s : my->index ) {
-         fc::raw::pack( out, *s );
+      if( my->logging ) {
+         if( my->head )
+            my->write_record( head_record, my->head->id );
+         my->sync_log();
+         my->close_log();
       }
-      if( my->head )
-         fc::raw::pack( out, my->head->id );
-      else
-         fc::raw::pack( out, block_id_type() );
 
       /// we don't normally indicate the head block as irreversible
       /// we cannot normally prune the lib if it is the head block because
       /// the next block needs to build off of the head block. We are exiting
       /// now so we can prune this block as irreversible before exiting.
       auto lib    = my->head->dpos_irreversible_blocknum;
-      auto oldest = *my->index.get<by_block_num>().begin();
+      auto oldest = my->oldest_at( my->first_num );
       if( oldest->block_num <= lib ) {
          prune( oldest );
       }
 
-      my->index.clear();
+      my->ring.clear();
+      my->size = 0;
+      my->head.reset();
    }
 
    fork_database::~fork_database() {
@@ -109,13 +394,15 @@ namespace eosio { namespace chain {
    }
 
    void fork_database::set( block_state_ptr s ) {
-      auto result = my->index.insert( s );
-      EOS_ASSERT( s->id == s->header.id(), fork_database_exception, 
+      EOS_ASSERT( s->id == s->header.id(), fork_database_exception,
                   "block state id (${id}) is different from block state header id (${hid})", ("id", string(s->id))("hid", string(s->header.id())) );
 
          //FC_ASSERT( s->block_num == s->header.block_num() );
 
-      EOS_ASSERT( result.second, fork_database_exception, "unable to insert block state, duplicate state detected" );
+      auto inserted = my->insert( s );
+      EOS_ASSERT( inserted, fork_database_exception, "unable to insert block state, duplicate state detected" );
+      my->write_record( add_record, *s );
+
       if( !my->head ) {
          my->head =  s;
       } else if( my->head->block_num < s->block_num ) {
@@ -128,23 +415,34 @@ namespace eosio { namespace chain {
       EOS_ASSERT( my->head, fork_db_block_not_found, "no head block set" );
 
       if( !skip_validate_previous ) {
-         auto prior = my->index.find( n->block->previous );
-         EOS_ASSERT( prior != my->index.end(), unlinkable_block_exception,
+         EOS_ASSERT( my->find( n->block->previous ), unlinkable_block_exception,
                      "unlinkable block", ("id", n->block->id())("previous", n->block->previous) );
       }
 
-      auto inserted = my->index.insert(n);
-      EOS_ASSERT( inserted.second, fork_database_exception, "duplicate block added?" );
+      auto inserted = my->insert(n);
+      EOS_ASSERT( inserted, fork_database_exception, "duplicate block added?" );
+      my->write_record( add_record, *n );
 
-      my->head = *my->index.get<by_lib_block_num>().begin();
+      if( fork_database_impl::better_head( n, my->head ) )
+         my->head = n;
 
       auto lib    = my->head->dpos_irreversible_blocknum;
-      auto oldest = *my->index.get<by_block_num>().begin();
+      auto oldest = my->oldest_at( my->first_num );
 
       if( oldest->block_num < lib ) {
-         prune( oldest );
+         {
+            // not logged, replaying the add record prunes the same blocks
+            bool logging = my->logging;
+            my->logging = false;
+            auto restore_logging = fc::make_scoped_exit( [&]() { my->logging = logging; } );
+            prune( oldest );
+         }
+         if( my->logging )
+            my->sync_log();
       }
 
+      my->maybe_compact_log();
+
       return n;
    }
 
@@ -152,14 +450,12 @@ namespace eosio { namespace chain {
       EOS_ASSERT( b, fork_database_exception, "attempt to add null block" );
       EOS_ASSERT( my->head, fork_db_block_not_found, "no head block set" );
 
-      const auto& by_id_idx = my->index.get<by_block_id>();
-      auto existing = by_id_idx.find( b->id() );
-      EOS_ASSERT( existing == by_id_idx.end(), fork_database_exception, "we already know about this block" );
+      EOS_ASSERT( !my->find( b->id() ), fork_database_exception, "we already know about this block" );
 
-      auto prior = by_id_idx.find( b->previous );
-      EOS_ASSERT( prior != by_id_idx.end(), unlinkable_block_exception, "unlinkable block", ("id", string(b->id()))("previous", string(b->previous)) );
+      auto prior = my->find( b->previous );
+      EOS_ASSERT( prior, unlinkable_block_exception, "unlinkable block", ("id", string(b->id()))("previous", string(b->previous)) );
 
-      auto result = std::make_shared<block_state>( **prior, move(b), skip_validate_signee );
+      auto result = std::make_shared<block_state>( *prior, move(b), skip_validate_signee );
       EOS_ASSERT( result, fork_database_exception , "fail to add new block state" );
       return add(result, true);
    }
@@ -196,8 +492,8 @@ namespace eosio { namespace chain {
          result.second.push_back(second_branch);
          first_branch = get_block( first_branch->header.previous );
          second_branch = get_block( second_branch->header.previous );
-         EOS_ASSERT( first_branch && second_branch, fork_db_block_not_found, 
-                     "either block ${fid} or ${sid} does not exist", 
+         EOS_ASSERT( first_branch && second_branch, fork_db_block_not_found,
+                     "either block ${fid} or ${sid} does not exist",
                      ("fid", string(first_branch->header.previous))("sid", string(second_branch->header.previous)) );
       }
 
@@ -211,22 +507,18 @@ namespace eosio { namespace chain {
 
    /// remove all of the invalid forks built of this id including this id
    void fork_database::remove( const block_id_type& id ) {
+      my->write_record( remove_record, id );
+
       vector<block_id_type> remove_queue{id};
 
       for( uint32_t i = 0; i < remove_queue.size(); ++i ) {
-         auto itr = my->index.find( remove_queue[i] );
-         if( itr != my->index.end() )
-            my->index.erase(itr);
-
-         auto& previdx = my->index.get<by_prev>();
-         auto  previtr = previdx.lower_bound(remove_queue[i]);
-         while( previtr != previdx.end() && (*previtr)->header.previous == remove_queue[i] ) {
-            remove_queue.push_back( (*previtr)->id );
-            ++previtr;
-         }
+         my->erase( remove_queue[i] );
+         my->for_each_child( remove_queue[i], [&]( const block_state_ptr& b ) {
+            remove_queue.push_back( b->id );
+         });
       }
-      //wdump((my->index.size()));
-      my->head = *my->index.get<by_lib_block_num>().begin();
+      if( !my->head )
+         my->recompute_head();
    }
 
    void fork_database::set_validity( const block_state_ptr& h, bool valid ) {
@@ -235,6 +527,7 @@ namespace eosio { namespace chain {
       } else {
          /// remove older than irreversible and mark block as valid
          h->validated = true;
+         my->write_record( update_record, h->id, h->validated, h->in_current_chain );
       }
    }
 
@@ -242,65 +535,61 @@ namespace eosio { namespace chain {
       if( h->in_current_chain == in_current_chain )
          return;
 
-      auto& by_id_idx = my->index.get<by_block_id>();
-      auto itr = by_id_idx.find( h->id );
-      EOS_ASSERT( itr != by_id_idx.end(), fork_db_block_not_found, "could not find block in fork database" );
+      auto b = my->find( h->id );
+      EOS_ASSERT( b, fork_db_block_not_found, "could not find block in fork database" );
 
-      by_id_idx.modify( itr, [&]( auto& bsp ) { // Need to modify this way rather than directly so that Boost MultiIndex can re-sort
-         bsp->in_current_chain = in_current_chain;
-      });
+      b->in_current_chain = in_current_chain;
+      my->write_record( update_record, b->id, b->validated, b->in_current_chain );
    }
 
    void fork_database::prune( const block_state_ptr& h ) {
+      my->write_record( prune_record, h->id );
+
+      bool logging = my->logging;
+      my->logging = false;
+      auto restore_logging = fc::make_scoped_exit( [&]() { my->logging = logging; } );
+
       auto num = h->block_num;
 
-      auto& by_bn = my->index.get<by_block_num>();
-      auto bni = by_bn.begin();
-      while( bni != by_bn.end() && (*bni)->block_num < num ) {
-         prune( *bni );
-         bni = by_bn.begin();
+      while( my->size > 0 && my->first_num < num ) {
+         prune( my->oldest_at( my->first_num ) );
       }
 
-      auto itr = my->index.find( h->id );
-      if( itr != my->index.end() ) {
-         irreversible(*itr);
-         my->index.erase(itr);
+      if( my->find( h->id ) ) {
+         irreversible(h);
+         my->erase( h->id );
       }
 
-      auto& numidx = my->index.get<by_block_num>();
-      auto nitr = numidx.lower_bound( num );
-      while( nitr != numidx.end() && (*nitr)->block_num == num ) {
-         auto itr_to_remove = nitr;
-         ++nitr;
-         auto id = (*itr_to_remove)->id;
-         remove( id );
+      if( auto* s = my->slot( num ) ) {
+         auto siblings = *s;
+         for( const auto& b : siblings )
+            remove( b->id );
       }
+
+      if( !my->head )
+         my->recompute_head();
+
+      if( logging )
+         my->sync_log();
    }
 
    block_state_ptr   fork_database::get_block(const block_id_type& id)const {
-      auto itr = my->index.find( id );
-      if( itr != my->index.end() )
-         return *itr;
-      return block_state_ptr();
+      return my->find( id );
    }
 
    block_state_ptr   fork_database::get_block_in_current_chain_by_num( uint32_t n )const {
-      const auto& numidx = my->index.get<by_block_num>();
-      auto nitr = numidx.lower_bound( n );
-      // following asserts removed so null can be returned
-      //FC_ASSERT( nitr != numidx.end() && (*nitr)->block_num == n,
-      //           "could not find block in fork database with block number ${block_num}", ("block_num", n) );
-      //FC_ASSERT( (*nitr)->in_current_chain == true,
-      //           "block (with block number ${block_num}) found in fork database is not in the current chain", ("block_num", n) );
-      if( nitr == numidx.end() || (*nitr)->block_num != n || (*nitr)->in_current_chain != true )
-         return block_state_ptr();
-      return *nitr;
+      if( const auto* s = my->slot( n ) ) {
+         for( const auto& b : *s )
+            if( b->in_current_chain ) return b;
+      }
+      return block_state_ptr();
    }
 
    void fork_database::add( const header_confirmation& c ) {
       auto b = get_block( c.block_id );
       EOS_ASSERT( b, fork_db_block_not_found, "unable to find block id ${id}", ("id",c.block_id));
       b->add_confirmation( c );
+      my->write_record( confirmation_record, c );
 
       if( b->bft_irreversible_blocknum < b->block_num &&
          b->confirmations.size() >= ((b->active_schedule.producers.size() * 2) / 3 + 1) ) {
@@ -316,12 +605,9 @@ namespace eosio { namespace chain {
     *  This will require a search over all forks
     */
    void fork_database::set_bft_irreversible( block_id_type id ) {
-      auto& idx = my->index.get<by_block_id>();
-      auto itr = idx.find(id);
-      uint32_t block_num = (*itr)->block_num;
-      idx.modify( itr, [&]( auto& bsp ) {
-           bsp->bft_irreversible_blocknum = bsp->block_num;
-      });
+      auto b = my->find( id );
+      uint32_t block_num = b->block_num;
+      b->bft_irreversible_blocknum = b->block_num;
 
       /** to prevent stack-overflow, we perform a bredth-first traversal of the
        * fork database. At each stage we iterate over the leafs from the prior stage
@@ -333,18 +619,12 @@ namespace eosio { namespace chain {
          vector<block_id_type> updated;
 
          for( const auto& i : in ) {
-            auto& pidx = my->index.get<by_prev>();
-            auto pitr  = pidx.lower_bound( i );
-            auto epitr = pidx.upper_bound( i );
-            while( pitr != epitr ) {
-               pidx.modify( pitr, [&]( auto& bsp ) {
-                 if( bsp->bft_irreversible_blocknum < block_num ) {
-                    bsp->bft_irreversible_blocknum = block_num;
-                    updated.push_back( bsp->id );
-                 }
-               });
-               ++pitr;
-            }
+            my->for_each_child( i, [&]( const block_state_ptr& bsp ) {
+               if( bsp->bft_irreversible_blocknum < block_num ) {
+                  bsp->bft_irreversible_blocknum = block_num;
+                  updated.push_back( bsp->id );
+               }
+            });
          }
          return updated;
       };
@@ -353,6 +633,8 @@ namespace eosio { namespace chain {
       while( queue.size() ) {
          queue = update( queue );
       }
+
+      my->recompute_head();
    }
 
 } } /// eosio::chain
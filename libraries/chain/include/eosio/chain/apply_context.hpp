@@ -443,6 +443,75 @@ class apply_context {
                secondary_key_helper_t::get(secondary, obj.secondary_key);
             }
 
+            /// Size of one (secondary, primary) pair written by get_range_secondary
+            static constexpr size_t range_pair_size = sizeof(secondary_key_type) + sizeof(uint64_t);
+
+            /**
+             * Copies up to max_rows (secondary, primary) pairs into buffer, walking the secondary index from
+             * iterator forwards (or backwards when reverse is set, in which case iterator may be an end iterator).
+             * Only the row we stop at is handed an iterator, the rows in between never enter itr_cache.
+             *
+             * @param next - set to the iterator of the first row not copied, the end iterator of the table when
+             *               walking forwards past the last row, or -1 when walking backwards past the first row
+             * @return the number of pairs copied
+             */
+            int get_range_secondary( int iterator, uint32_t max_rows, bool reverse, char* buffer, size_t buffer_size, int& next ) {
+               next = iterator;
+               if( max_rows == 0 ) return 0;
+
+               const auto& idx = context.db.get_index<typename chainbase::get_index_type<ObjectType>::type, by_secondary>();
+
+               table_id_object::id_type t_id;
+               auto itr = idx.end();
+               if( iterator < -1 ) { // is end iterator
+                  if( !reverse ) return 0;
+                  auto tab = itr_cache.find_table_by_end_iterator(iterator);
+                  EOS_ASSERT( tab, invalid_table_iterator, "not a valid end iterator" );
+                  t_id = tab->id;
+                  itr  = idx.upper_bound(tab->id);
+               } else {
+                  const auto& obj = itr_cache.get(iterator); // Check for iterator != -1 happens in this call
+                  t_id = obj.t_id;
+                  itr  = idx.iterator_to(obj);
+                  if( reverse ) ++itr; // when walking backwards itr is kept one past the next row to copy
+               }
+
+               uint32_t copied = 0;
+               char*    out    = buffer;
+               size_t   remaining = buffer_size;
+
+               auto copy_pair = [&]( const ObjectType& o ) {
+                  if( remaining < range_pair_size ) return false;
+                  memcpy( out, &o.secondary_key, sizeof(secondary_key_type) );
+                  memcpy( out + sizeof(secondary_key_type), &o.primary_key, sizeof(uint64_t) );
+                  out       += range_pair_size;
+                  remaining -= range_pair_size;
+                  return true;
+               };
+
+               if( !reverse ) {
+                  for( ; itr != idx.end() && itr->t_id == t_id && copied < max_rows; ++itr ) {
+                     if( !copy_pair( *itr ) ) break;
+                     ++copied;
+                  }
+                  if( itr == idx.end() || itr->t_id != t_id )
+                     next = itr_cache.get_end_iterator_by_table_id(t_id);
+                  else
+                     next = itr_cache.add(*itr);
+               } else {
+                  for( ; itr != idx.begin() && std::prev(itr)->t_id == t_id && copied < max_rows; --itr ) {
+                     if( !copy_pair( *std::prev(itr) ) ) break;
+                     ++copied;
+                  }
+                  if( itr == idx.begin() || std::prev(itr)->t_id != t_id )
+                     next = -1; // cannot decrement past beginning iterator of index
+                  else
+                     next = itr_cache.add(*std::prev(itr));
+               }
+
+               return copied;
+            }
+
          private:
             apply_context&              context;
             iterator_cache<ObjectType>  itr_cache;
@@ -551,8 +620,20 @@ class apply_context {
       int  db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
       int  db_end_i64( uint64_t code, uint64_t scope, uint64_t table );
 
+      /**
+       * Batched reads: rows are written back to back into `buffer`, each one as a
+       * uint64_t primary key and a uint32_t value size followed by the packed row.
+       */
+      static constexpr size_t batch_row_header_size = sizeof(uint64_t) + sizeof(uint32_t);
+
+      int  db_get_range_i64( int iterator, uint32_t max_rows, char* buffer, size_t buffer_size, int& next );
+      int  db_get_multi_i64( uint64_t code, uint64_t scope, uint64_t table, const uint64_t* ids, size_t ids_count,
+                             char* buffer, size_t buffer_size );
+
    private:
 
+      bool copy_row_to_batch( const key_value_object& obj, char*& out, size_t& remaining )const;
+
       const table_id_object* find_table( name code, name scope, name table );
       const table_id_object& find_or_create_table( name code, name scope, name table, const account_name &payer );
       void                   remove_table( const table_id_object& tid );
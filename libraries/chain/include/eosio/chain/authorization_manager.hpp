@@ -10,6 +10,7 @@
 
 #include <utility>
 #include <functional>
+#include <memory>
 
 namespace eosio { namespace chain {
 
@@ -25,6 +26,7 @@ namespace eosio { namespace chain {
          using permission_id_type = permission_object::id_type;
 
          explicit authorization_manager(controller& c, chainbase::database& d);
+         ~authorization_manager();
 
          void add_indices();
          void initialize_database();
@@ -116,11 +118,29 @@ namespace eosio { namespace chain {
                                                     )const;
 
 
+         /**
+          *  @brief Forget all memoised authorization results and allow new ones to be recorded
+          *
+          *  Results are only reused against the state they were recorded in, so the controller calls this whenever
+          *  the pending block is started or aborted and whenever a block is popped.
+          */
+         void reset_authorization_cache();
+
+         /**
+          *  @brief Forget memoised minimum permission results and stop recording new ones until the next reset
+          *
+          *  Must be called whenever a permission link is created, modified or removed.
+          */
+         void invalidate_linked_permission_cache();
+
          static std::function<void()> _noop_checktime;
 
       private:
-         const controller&    _control;
-         chainbase::database& _db;
+         struct authorization_cache;
+
+         const controller&                      _control;
+         chainbase::database&                   _db;
+         std::unique_ptr<authorization_cache>   _auth_cache;
 
          void             check_updateauth_authorization( const updateauth& update, const vector<permission_level>& auths )const;
          void             check_deleteauth_authorization( const deleteauth& del, const vector<permission_level>& auths )const;
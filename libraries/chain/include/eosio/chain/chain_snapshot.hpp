@@ -12,10 +12,11 @@ struct chain_snapshot_header {
    /**
     * Version history
     *   1: initial version
+    *   2: adds the recurring_action_object and protocol_state_object sections, written once recurring actions are activated
     */
 
    static constexpr uint32_t minimum_compatible_version = 1;
-   static constexpr uint32_t current_version = 1;
+   static constexpr uint32_t current_version = 2;
 
    uint32_t version = current_version;
 
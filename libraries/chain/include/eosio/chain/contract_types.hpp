@@ -37,6 +37,44 @@ struct contracthost {
    }
 };
 
+struct actrecur {
+   static account_name get_account() {
+      return config::system_account_name;
+   }
+
+   static action_name get_name() {
+      return N(actrecur);
+   }
+};
+
+struct setrecur {
+   account_name                     account;
+   action_name                      action;
+   uint32_t                         interval_ms = 0;
+   bytes                            data;
+
+   static account_name get_account() {
+      return config::system_account_name;
+   }
+
+   static action_name get_name() {
+      return N(setrecur);
+   }
+};
+
+struct delrecur {
+   account_name                     account;
+   action_name                      action;
+
+   static account_name get_account() {
+      return config::system_account_name;
+   }
+
+   static action_name get_name() {
+      return N(delrecur);
+   }
+};
+
 struct setcode {
    account_name                     account;
    uint8_t                          vmtype = 0;
@@ -171,6 +209,9 @@ struct onerror {
 
 FC_REFLECT( eosio::chain::newaccount                       , (creator)(name)(owner)(active) )
 FC_REFLECT( eosio::chain::contracthost                      , (account)(contract_host) )
+FC_REFLECT_EMPTY( eosio::chain::actrecur )
+FC_REFLECT( eosio::chain::setrecur                         , (account)(action)(interval_ms)(data) )
+FC_REFLECT( eosio::chain::delrecur                         , (account)(action) )
 FC_REFLECT( eosio::chain::setcode                          , (account)(vmtype)(vmversion)(code) )
 FC_REFLECT( eosio::chain::setabi                           , (account)(abi) )
 FC_REFLECT( eosio::chain::updateauth                       , (account)(permission)(parent)(auth) )
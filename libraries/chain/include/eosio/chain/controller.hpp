@@ -125,6 +125,13 @@ namespace eosio { namespace chain {
           */
          vector<transaction_id_type> get_scheduled_transactions() const;
 
+         /**
+          *  Starts recovering the signing keys of transactions on the controller thread pool, so that they are
+          *  already available by the time the transactions are pushed. Does nothing if authorization checks are skipped.
+          */
+         void recover_keys_async( const transaction_metadata_ptr& trx );
+         void recover_keys_async( const vector<transaction_metadata_ptr>& trxs );
+
          /**
           *
           */
@@ -136,6 +143,15 @@ namespace eosio { namespace chain {
           */
          transaction_trace_ptr push_scheduled_transaction( const transaction_id_type& scheduled, fc::time_point deadline, uint32_t billed_cpu_time_us = 0 );
 
+         /**
+          * Retires every scheduled transaction that has expired by the pending block time with an expired receipt,
+          * walking the expiration index rather than pushing each transaction id individually. Stops early once
+          * the deadline has passed.
+          *
+          * @return the number of transactions retired
+          */
+         uint32_t retire_expired_scheduled_transactions( fc::time_point deadline );
+
          void finalize_block();
          void sign_block( const std::function<signature_type( const digest_type& )>& signer_callback );
          void commit_block();
@@ -32,6 +32,10 @@ namespace eosio { namespace chain {
    void apply_eosio_setabi(apply_context&);
 
    void apply_eosio_canceldelay(apply_context&);
+
+   void apply_eosio_actrecur(apply_context&);
+   void apply_eosio_setrecur(apply_context&);
+   void apply_eosio_delrecur(apply_context&);
    ///@}  end action handlers
 
 } } /// namespace eosio::chain
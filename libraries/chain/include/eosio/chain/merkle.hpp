@@ -19,4 +19,25 @@ namespace eosio { namespace chain {
     */
    digest_type merkle( vector<digest_type> ids );
 
+   /**
+    *  Maintains merkle() of a growing list of digests one append at a time.
+    *
+    *  Only the roots of the complete subtrees are kept, so an append costs one pair hash amortized and root() costs
+    *  one pair hash per level; unlike incremental_merkle the root is not recomputed on every append. The
+    *  accumulator is a handful of digests and is copied to take a restore point.
+    */
+   class merkle_accumulator {
+      public:
+         void append( const digest_type& leaf );
+
+         /// the same digest merkle() returns for all leaves appended so far
+         digest_type root()const;
+
+         uint64_t size()const { return _leaf_count; }
+
+      private:
+         uint64_t              _leaf_count = 0;
+         vector<digest_type>   _subtree_roots; ///< one per set bit of _leaf_count, the tallest subtree first
+   };
+
 } } /// eosio::chain
@@ -0,0 +1,42 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <eosio/chain/types.hpp>
+
+#include "multi_index_includes.hpp"
+
+namespace eosio { namespace chain {
+
+   /**
+    * @class protocol_state_object
+    * @brief Records which protocol upgrades have been activated by the producers
+    * @ingroup object
+    * @ingroup implementation
+    *
+    * The object does not exist until the first upgrade is activated, so the state, snapshots and integrity hash of a
+    * chain are unchanged until then.
+    */
+   class protocol_state_object : public chainbase::object<protocol_state_object_type, protocol_state_object>
+   {
+      OBJECT_CTOR(protocol_state_object)
+
+      id_type          id;
+      block_num_type   recurring_actions_activation = 0; ///< first block which fires recurring actions, 0 while not activated
+   };
+
+   using protocol_state_multi_index = chainbase::shared_multi_index_container<
+      protocol_state_object,
+      indexed_by<
+         ordered_unique<tag<by_id>,
+            BOOST_MULTI_INDEX_MEMBER(protocol_state_object, protocol_state_object::id_type, id)
+         >
+      >
+   >;
+
+}}
+
+CHAINBASE_SET_INDEX_TYPE(eosio::chain::protocol_state_object, eosio::chain::protocol_state_multi_index)
+
+FC_REFLECT(eosio::chain::protocol_state_object, (recurring_actions_activation))
@@ -0,0 +1,64 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+#include <eosio/chain/database_utils.hpp>
+#include <eosio/chain/config.hpp>
+
+#include "multi_index_includes.hpp"
+
+namespace eosio { namespace chain {
+   /**
+    * An action that the controller dispatches to a contract every interval_ms, at the start of the first block
+    * whose time is at or after next_fire, under the active authority of the contract. This replaces contracts
+    * re-scheduling a deferred transaction from inside every tick of a loop.
+    *
+    * The by_next_fire index is the timer wheel: finding the due entries of a block costs O(due entries).
+    */
+   class recurring_action_object : public chainbase::object<recurring_action_object_type, recurring_action_object>
+   {
+         OBJECT_CTOR(recurring_action_object, (data) )
+
+         id_type                       id;
+         account_name                  account;
+         action_name                   action;
+         uint32_t                      interval_ms = 0;
+         time_point                    next_fire;
+         shared_blob                   data;
+   };
+
+   struct by_account_action;
+   struct by_next_fire;
+
+   using recurring_action_multi_index = chainbase::shared_multi_index_container<
+      recurring_action_object,
+      indexed_by<
+         ordered_unique< tag<by_id>, BOOST_MULTI_INDEX_MEMBER(recurring_action_object, recurring_action_object::id_type, id)>,
+         ordered_unique< tag<by_account_action>,
+            composite_key< recurring_action_object,
+               BOOST_MULTI_INDEX_MEMBER( recurring_action_object, account_name, account),
+               BOOST_MULTI_INDEX_MEMBER( recurring_action_object, action_name, action)
+            >
+         >,
+         ordered_unique< tag<by_next_fire>,
+            composite_key< recurring_action_object,
+               BOOST_MULTI_INDEX_MEMBER( recurring_action_object, time_point, next_fire),
+               BOOST_MULTI_INDEX_MEMBER( recurring_action_object, recurring_action_object::id_type, id)
+            >
+         >
+      >
+   >;
+
+   namespace config {
+      template<>
+      struct billable_size<recurring_action_object> {
+         static const uint64_t overhead = overhead_per_row_per_index_ram_bytes * 3;  ///< overhead for 3x indices internal-key, account/action, next_fire
+         static const uint64_t value = 36 + 4 + overhead; ///< 36 bytes for our constant size fields, 4 bytes for a varint for data size
+      };
+   }
+} } // eosio::chain
+
+CHAINBASE_SET_INDEX_TYPE(eosio::chain::recurring_action_object, eosio::chain::recurring_action_multi_index)
+
+FC_REFLECT(eosio::chain::recurring_action_object, (account)(action)(interval_ms)(next_fire)(data))
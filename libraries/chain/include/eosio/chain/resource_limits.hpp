@@ -35,12 +35,41 @@ namespace eosio { namespace chain { namespace resource_limits {
       int64_t max = 0; ///< max per window under current congestion
    };
 
+   /**
+    * Net and cpu usage of accounts, as well as the usage of the pending block, is accumulated in memory while a
+    * block is built and only written back to chainbase by process_block_usage. This spares every transaction
+    * the undo copies of the resource_usage_objects it bills.
+    *
+    * The in memory state has its own undo stack: every chainbase undo session that may contain usage updates
+    * must be paired with a usage_session which is squashed, undone or pushed together with it.
+    */
    class resource_limits_manager {
       public:
-         explicit resource_limits_manager(chainbase::database& db)
-         :_db(db)
-         {
-         }
+         class usage_session {
+            public:
+               usage_session( usage_session&& mv );
+               ~usage_session();
+
+               usage_session( const usage_session& ) = delete;
+               usage_session& operator = ( const usage_session& ) = delete;
+               usage_session& operator = ( usage_session&& mv );
+
+               /// merge the changes into the enclosing session
+               void squash();
+               /// revert the changes made since the session was started
+               void undo();
+               /// keep the changes and close the session
+               void push();
+
+            private:
+               friend class resource_limits_manager;
+               explicit usage_session( resource_limits_manager& rl ):_rl(&rl){}
+
+               resource_limits_manager* _rl;
+         };
+
+         explicit resource_limits_manager(chainbase::database& db);
+         ~resource_limits_manager();
 
          void add_indices();
          void initialize_database();
@@ -78,8 +107,15 @@ namespace eosio { namespace chain { namespace resource_limits {
 
          int64_t get_account_ram_usage( const account_name& name ) const;
 
+         usage_session start_usage_session();
+
       private:
-         chainbase::database& _db;
+         struct usage_cache;
+
+         void flush_pending_usage();
+
+         chainbase::database&          _db;
+         std::unique_ptr<usage_cache>  _usage_cache;
    };
 } } } /// eosio::chain
 
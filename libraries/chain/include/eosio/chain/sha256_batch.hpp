@@ -0,0 +1,51 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+namespace eosio { namespace chain {
+
+   /**
+    *  Computes many independent SHA-256 digests in one call.
+    *
+    *  The implementation is picked once per process from the cpu: batches are hashed 8 messages at a time in the
+    *  lanes of AVX2 registers, and single messages with the SHA extensions, when the cpu has them; otherwise a
+    *  portable implementation is used. Every backend produces exactly the digests fc::sha256::hash would.
+    */
+   namespace sha256_batch {
+
+      struct message {
+         const char*  data = nullptr;
+         size_t       size = 0;
+      };
+
+      /// out[i] = sha256( msgs[i] ) for i in [0, count)
+      void hash( const message* msgs, size_t count, digest_type* out );
+
+      inline vector<digest_type> hash( const vector<message>& msgs ) {
+         vector<digest_type> result( msgs.size() );
+         hash( msgs.data(), msgs.size(), result.data() );
+         return result;
+      }
+
+      /**
+       *  out[i] = sha256( in[2*i] || in[2*i+1] ) for i in [0, pair_count), the hashing of one merkle tree level.
+       *  out may be the same array as in.
+       */
+      void hash_pairs( const digest_type* in, size_t pair_count, digest_type* out );
+
+      /// the backend in use: "auto", "sha-ni", "avx2" or "portable"
+      const char* backend();
+
+      /**
+       *  overrides the backend chosen at startup; for tests and benchmarks only, while no other thread is hashing.
+       *  Returns false if the backend is not supported by this cpu.
+       */
+      bool set_backend( const string& name );
+
+   }
+
+} } /// eosio::chain
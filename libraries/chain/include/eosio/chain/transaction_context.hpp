@@ -1,10 +1,19 @@
 #pragma once
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/trace.hpp>
-#include <signal.h>
+#include <eosio/chain/resource_limits.hpp>
+#include <atomic>
+#include <chrono>
+#include <map>
 
 namespace eosio { namespace chain {
 
+   /**
+    * Per-transaction deadline flag. A shared watchdog thread sets `expired` once the armed deadline has
+    * passed, so checktime() only has to load the flag of its own transaction and any number of transactions
+    * can be executing on different threads at once. Falls back to polling fc::time_point::now() when the
+    * watchdog wakes up too late to be useful on this machine.
+    */
    struct deadline_timer {
          deadline_timer();
          ~deadline_timer();
@@ -12,10 +21,31 @@ namespace eosio { namespace chain {
          void start(fc::time_point tp);
          void stop();
 
-         static volatile sig_atomic_t expired;
+         struct calibration {
+            bool     use_watchdog = false;     ///< false when checktime() polls the clock
+            int      timer_overhead_us = 0;    ///< timers are armed this much before their deadline
+            double   polled_check_ns = 0;      ///< cost of a checktime() which reads the clock
+            double   flagged_check_ns = 0;     ///< cost of a checktime() which loads the flag
+         };
+
+         /**
+          * Measures the watchdog's wake-up latency the first time it is called, which takes about half a second;
+          * until then checktime() polls the clock. Called from controller::startup().
+          */
+         static const calibration& calibrate();
+
+         std::atomic<bool> expired{false};
       private:
-         static void timer_expired(int);
-         static bool initialized;
+         friend class deadline_watchdog;
+
+         struct calibration_t {};
+         explicit deadline_timer(calibration_t) {}
+
+         using armed_map = std::multimap<std::chrono::steady_clock::time_point, deadline_timer*>;
+
+         // protected by the watchdog mutex
+         bool                 is_armed = false;
+         armed_map::iterator  armed_itr; ///< valid while is_armed
    };
 
    class transaction_context {
@@ -81,6 +111,7 @@ namespace eosio { namespace chain {
          const signed_transaction&     trx;
          transaction_id_type           id;
          optional<chainbase::database::session>  undo_session;
+         optional<resource_limits::resource_limits_manager::usage_session>  usage_session; ///< paired with undo_session
          transaction_trace_ptr         trace;
          fc::time_point                start;
 
@@ -103,6 +134,10 @@ namespace eosio { namespace chain {
          fc::microseconds              leeway = fc::microseconds(3000);
          int64_t                       billed_cpu_time_us = 0;
          bool                          explicit_billed_cpu_time = false;
+         /// when nonzero, the transaction fails on this many calls of checktime(), one per wasm loop iteration and
+         /// host function checkpoint, rather than at a deadline, and is not subject to greylisting, so it fails
+         /// identically on every node
+         uint64_t                      checktime_limit = 0;
 
       private:
          bool                          is_initialized = false;
@@ -126,6 +161,7 @@ namespace eosio { namespace chain {
          fc::microseconds              billing_timer_duration_limit;
 
          deadline_timer                _deadline_timer;
+         mutable uint64_t              checktime_calls = 0;
    };
 
 } }
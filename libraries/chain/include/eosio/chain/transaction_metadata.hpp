@@ -39,6 +39,11 @@ class transaction_metadata {
          signed_id = digest_type::hash(packed_trx);
       }
 
+      /// for callers that have already unpacked ptrx into t and computed both ids, e.g. in a batch
+      transaction_metadata( signed_transaction&& t, const packed_transaction& ptrx,
+                            const transaction_id_type& id, const transaction_id_type& signed_id )
+      :id(id), signed_id(signed_id), trx( std::move(t) ), packed_trx(ptrx) {}
+
       const flat_set<public_key_type>& recover_keys( const chain_id_type& chain_id ) {
          // Unlikely for more than one chain_id to be used in one nodeos instance
          if( !signing_keys || signing_keys->first != chain_id ) {
@@ -172,6 +172,8 @@ namespace eosio { namespace chain {
       account_history_object_type,              ///< Defined by history_plugin
       action_history_object_type,               ///< Defined by history_plugin
       reversible_block_object_type,
+      recurring_action_object_type,
+      protocol_state_object_type,
       OBJECT_TYPE_COUNT ///< Sentry value which contains the number of different object types
    };
 
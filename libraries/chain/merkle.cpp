@@ -1,4 +1,5 @@
 #include <eosio/chain/merkle.hpp>
+#include <eosio/chain/sha256_batch.hpp>
 #include <fc/io/raw.hpp>
 
 namespace eosio { namespace chain {
@@ -39,14 +40,55 @@ digest_type merkle(vector<digest_type> ids) {
       if( ids.size() % 2 )
          ids.push_back(ids.back());
 
-      for (int i = 0; i < ids.size() / 2; i++) {
-         ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+      // a level is hashed as one batch of independent 64 byte messages, canonical left || canonical right
+      const size_t pairs = ids.size() / 2;
+      for( size_t i = 0; i < pairs; ++i ) {
+         ids[2 * i]._hash[0]     &= 0xFFFFFFFFFFFFFF7FULL;
+         ids[(2 * i) + 1]._hash[0] |= 0x0000000000000080ULL;
       }
+      sha256_batch::hash_pairs( ids.data(), pairs, ids.data() );
 
-      ids.resize(ids.size() / 2);
+      ids.resize( pairs );
    }
 
    return ids.front();
 }
 
+static digest_type hash_canonical_pair( const digest_type& l, const digest_type& r ) {
+   digest_type pair[2] = { make_canonical_left(l), make_canonical_right(r) };
+   sha256_batch::hash_pairs( pair, 1, pair );
+   return pair[0];
+}
+
+void merkle_accumulator::append( const digest_type& leaf ) {
+   digest_type node = leaf;
+   // every trailing set bit of the count is a complete subtree of the same height as node, merge them
+   for( uint64_t count = _leaf_count; count & 1; count >>= 1 ) {
+      node = hash_canonical_pair( _subtree_roots.back(), node );
+      _subtree_roots.pop_back();
+   }
+   _subtree_roots.push_back( node );
+   ++_leaf_count;
+}
+
+digest_type merkle_accumulator::root()const {
+   if( _leaf_count == 0 ) return digest_type();
+
+   // fold the subtrees from the shortest up; merkle() duplicates the last node of an odd level, which raises the
+   // shorter subtree by pairing it with itself until it is as tall as its left neighbour
+   auto itr = _subtree_roots.rbegin();
+   digest_type node = *itr;
+   uint32_t height = 0; // subtree heights are the positions of the set bits of _leaf_count
+   while( !((_leaf_count >> height) & 1) ) ++height;
+   uint32_t left_height = height + 1;
+   for( ++itr; itr != _subtree_roots.rend(); ++itr ) {
+      while( !((_leaf_count >> left_height) & 1) ) ++left_height;
+      for( ; height < left_height; ++height )
+         node = hash_canonical_pair( node, node );
+      node = hash_canonical_pair( *itr, node );
+      left_height = ++height;
+   }
+   return node;
+}
+
 } } // eosio::chain
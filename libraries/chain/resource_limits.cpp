@@ -6,6 +6,8 @@
 #include <boost/tuple/tuple_io.hpp>
 #include <eosio/chain/database_utils.hpp>
 #include <algorithm>
+#include <deque>
+#include <map>
 
 namespace eosio { namespace chain { namespace resource_limits {
 
@@ -47,6 +49,147 @@ void resource_limits_state_object::update_virtual_net_limit( const resource_limi
    virtual_net_limit = update_elastic_limit(virtual_net_limit, average_block_net_usage.average(), cfg.net_limit_parameters);
 }
 
+struct resource_limits_manager::usage_cache {
+   struct account_usage {
+      usage_accumulator net_usage;
+      usage_accumulator cpu_usage;
+   };
+
+   struct undo_level {
+      /// state of each account touched since the level was started, empty if it was not cached yet
+      std::map<account_name, optional<account_usage>> old_accounts;
+      uint64_t old_block_cpu_usage = 0;
+      uint64_t old_block_net_usage = 0;
+   };
+
+   std::map<account_name, account_usage> accounts;
+   uint64_t                              block_cpu_usage = 0; ///< added to resource_limits_state_object::pending_cpu_usage
+   uint64_t                              block_net_usage = 0; ///< added to resource_limits_state_object::pending_net_usage
+   std::deque<undo_level>                undo_stack;
+
+   account_usage& modify( const chainbase::database& db, const account_name& a ) {
+      auto itr = accounts.find( a );
+      bool cached = (itr != accounts.end());
+      if( !undo_stack.empty() ) {
+         // emplace keeps the first recorded state of the account in this level
+         undo_stack.back().old_accounts.emplace( a, cached ? optional<account_usage>(itr->second) : optional<account_usage>() );
+      }
+      if( !cached ) {
+         const auto& usage = db.get<resource_usage_object,by_owner>( a );
+         itr = accounts.emplace( a, account_usage{ usage.net_usage, usage.cpu_usage } ).first;
+      }
+      return itr->second;
+   }
+
+   const usage_accumulator& net_usage( const chainbase::database& db, const account_name& a )const {
+      auto itr = accounts.find( a );
+      if( itr != accounts.end() ) return itr->second.net_usage;
+      return db.get<resource_usage_object,by_owner>( a ).net_usage;
+   }
+
+   const usage_accumulator& cpu_usage( const chainbase::database& db, const account_name& a )const {
+      auto itr = accounts.find( a );
+      if( itr != accounts.end() ) return itr->second.cpu_usage;
+      return db.get<resource_usage_object,by_owner>( a ).cpu_usage;
+   }
+};
+
+resource_limits_manager::resource_limits_manager(chainbase::database& db)
+:_db(db)
+,_usage_cache(std::make_unique<usage_cache>())
+{
+}
+
+resource_limits_manager::~resource_limits_manager() {}
+
+resource_limits_manager::usage_session resource_limits_manager::start_usage_session() {
+   auto& c = *_usage_cache;
+   c.undo_stack.emplace_back();
+   c.undo_stack.back().old_block_cpu_usage = c.block_cpu_usage;
+   c.undo_stack.back().old_block_net_usage = c.block_net_usage;
+   return usage_session( *this );
+}
+
+resource_limits_manager::usage_session::usage_session( usage_session&& mv )
+:_rl(mv._rl)
+{
+   mv._rl = nullptr;
+}
+
+resource_limits_manager::usage_session& resource_limits_manager::usage_session::operator = ( usage_session&& mv ) {
+   if( this != &mv ) {
+      undo();
+      _rl = mv._rl;
+      mv._rl = nullptr;
+   }
+   return *this;
+}
+
+resource_limits_manager::usage_session::~usage_session() {
+   undo();
+}
+
+void resource_limits_manager::usage_session::squash() {
+   if( !_rl ) return;
+   auto& stack = _rl->_usage_cache->undo_stack;
+   if( stack.size() > 1 ) {
+      auto& prev = stack[stack.size() - 2];
+      for( auto& a : stack.back().old_accounts )
+         prev.old_accounts.emplace( a.first, std::move(a.second) );
+   }
+   stack.pop_back();
+   _rl = nullptr;
+}
+
+void resource_limits_manager::usage_session::undo() {
+   if( !_rl ) return;
+   auto& c = *_rl->_usage_cache;
+   auto& level = c.undo_stack.back();
+   for( auto& a : level.old_accounts ) {
+      if( a.second )
+         c.accounts[a.first] = *a.second;
+      else
+         c.accounts.erase( a.first );
+   }
+   c.block_cpu_usage = level.old_block_cpu_usage;
+   c.block_net_usage = level.old_block_net_usage;
+   c.undo_stack.pop_back();
+   _rl = nullptr;
+}
+
+void resource_limits_manager::usage_session::push() {
+   if( !_rl ) return;
+   _rl->_usage_cache->undo_stack.pop_back();
+   _rl = nullptr;
+}
+
+void resource_limits_manager::flush_pending_usage() {
+   auto& c = *_usage_cache;
+   for( const auto& a : c.accounts ) {
+      const auto& usage = _db.get<resource_usage_object,by_owner>( a.first );
+      _db.modify( usage, [&]( auto& bu ){
+         bu.net_usage = a.second.net_usage;
+         bu.cpu_usage = a.second.cpu_usage;
+      });
+   }
+
+   const auto& state = _db.get<resource_limits_state_object>();
+   _db.modify(state, [&](resource_limits_state_object& rls){
+      rls.pending_cpu_usage += c.block_cpu_usage;
+      rls.pending_net_usage += c.block_net_usage;
+   });
+
+   // chainbase now holds the usage, undoing an enclosing session restores it from there
+   c.accounts.clear();
+   c.block_cpu_usage = 0;
+   c.block_net_usage = 0;
+   for( auto& level : c.undo_stack ) {
+      level.old_accounts.clear();
+      level.old_block_cpu_usage = 0;
+      level.old_block_net_usage = 0;
+   }
+}
+
 void resource_limits_manager::add_indices() {
    resource_index_set::add_indices(_db);
 }
@@ -111,11 +254,9 @@ void resource_limits_manager::set_block_parameters(const elastic_limit_parameter
 void resource_limits_manager::update_account_usage(const flat_set<account_name>& accounts, uint32_t time_slot ) {
    const auto& config = _db.get<resource_limits_config_object>();
    for( const auto& a : accounts ) {
-      const auto& usage = _db.get<resource_usage_object,by_owner>( a );
-      _db.modify( usage, [&]( auto& bu ){
-          bu.net_usage.add( 0, time_slot, config.account_net_usage_average_window );
-          bu.cpu_usage.add( 0, time_slot, config.account_cpu_usage_average_window );
-      });
+      auto& bu = _usage_cache->modify( _db, a );
+      bu.net_usage.add( 0, time_slot, config.account_net_usage_average_window );
+      bu.cpu_usage.add( 0, time_slot, config.account_cpu_usage_average_window );
    }
 }
 
@@ -125,16 +266,14 @@ void resource_limits_manager::add_transaction_usage(const flat_set<account_name>
 
    for( const auto& a : accounts ) {
 
-      const auto& usage = _db.get<resource_usage_object,by_owner>( a );
       int64_t unused;
       int64_t net_weight;
       int64_t cpu_weight;
       get_account_limits( a, unused, net_weight, cpu_weight );
 
-      _db.modify( usage, [&]( auto& bu ){
-          bu.net_usage.add( net_usage, time_slot, config.account_net_usage_average_window );
-          bu.cpu_usage.add( cpu_usage, time_slot, config.account_cpu_usage_average_window );
-      });
+      auto& usage = _usage_cache->modify( _db, a );
+      usage.net_usage.add( net_usage, time_slot, config.account_net_usage_average_window );
+      usage.cpu_usage.add( cpu_usage, time_slot, config.account_cpu_usage_average_window );
 
       if( cpu_weight >= 0 && state.total_cpu_weight > 0 ) {
          uint128_t window_size = config.account_cpu_usage_average_window;
@@ -176,13 +315,11 @@ void resource_limits_manager::add_transaction_usage(const flat_set<account_name>
    }
 
    // account for this transaction in the block and do not exceed those limits either
-   _db.modify(state, [&](resource_limits_state_object& rls){
-      rls.pending_cpu_usage += cpu_usage;
-      rls.pending_net_usage += net_usage;
-   });
+   _usage_cache->block_cpu_usage += cpu_usage;
+   _usage_cache->block_net_usage += net_usage;
 
-   EOS_ASSERT( state.pending_cpu_usage <= config.cpu_limit_parameters.max, block_resource_exhausted, "Block has insufficient cpu resources" );
-   EOS_ASSERT( state.pending_net_usage <= config.net_limit_parameters.max, block_resource_exhausted, "Block has insufficient net resources" );
+   EOS_ASSERT( state.pending_cpu_usage + _usage_cache->block_cpu_usage <= config.cpu_limit_parameters.max, block_resource_exhausted, "Block has insufficient cpu resources" );
+   EOS_ASSERT( state.pending_net_usage + _usage_cache->block_net_usage <= config.net_limit_parameters.max, block_resource_exhausted, "Block has insufficient net resources" );
 }
 
 void resource_limits_manager::add_pending_ram_usage( const account_name account, int64_t ram_delta ) {
@@ -324,6 +461,8 @@ void resource_limits_manager::process_account_limit_updates() {
 }
 
 void resource_limits_manager::process_block_usage(uint32_t block_num) {
+   flush_pending_usage();
+
    const auto& s = _db.get<resource_limits_state_object>();
    const auto& config = _db.get<resource_limits_config_object>();
    _db.modify(s, [&](resource_limits_state_object& state){
@@ -354,13 +493,13 @@ uint64_t resource_limits_manager::get_virtual_block_net_limit() const {
 uint64_t resource_limits_manager::get_block_cpu_limit() const {
    const auto& state = _db.get<resource_limits_state_object>();
    const auto& config = _db.get<resource_limits_config_object>();
-   return config.cpu_limit_parameters.max - state.pending_cpu_usage;
+   return config.cpu_limit_parameters.max - (state.pending_cpu_usage + _usage_cache->block_cpu_usage);
 }
 
 uint64_t resource_limits_manager::get_block_net_limit() const {
    const auto& state = _db.get<resource_limits_state_object>();
    const auto& config = _db.get<resource_limits_config_object>();
-   return config.net_limit_parameters.max - state.pending_net_usage;
+   return config.net_limit_parameters.max - (state.pending_net_usage + _usage_cache->block_net_usage);
 }
 
 int64_t resource_limits_manager::get_account_cpu_limit( const account_name& name, bool elastic ) const {
@@ -371,7 +510,7 @@ int64_t resource_limits_manager::get_account_cpu_limit( const account_name& name
 account_resource_limit resource_limits_manager::get_account_cpu_limit_ex( const account_name& name, bool elastic) const {
 
    const auto& state = _db.get<resource_limits_state_object>();
-   const auto& usage = _db.get<resource_usage_object, by_owner>(name);
+   const auto& cpu_usage = _usage_cache->cpu_usage(_db, name);
    const auto& config = _db.get<resource_limits_config_object>();
 
    int64_t cpu_weight, x, y;
@@ -390,7 +529,7 @@ account_resource_limit resource_limits_manager::get_account_cpu_limit_ex( const
    uint128_t all_user_weight = (uint128_t)state.total_cpu_weight;
 
    auto max_user_use_in_window = (virtual_cpu_capacity_in_window * user_weight) / all_user_weight;
-   auto cpu_used_in_window  = impl::integer_divide_ceil((uint128_t)usage.cpu_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
+   auto cpu_used_in_window  = impl::integer_divide_ceil((uint128_t)cpu_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
 
    if( max_user_use_in_window <= cpu_used_in_window )
       arl.available = 0;
@@ -410,7 +549,7 @@ int64_t resource_limits_manager::get_account_net_limit( const account_name& name
 account_resource_limit resource_limits_manager::get_account_net_limit_ex( const account_name& name, bool elastic) const {
    const auto& config = _db.get<resource_limits_config_object>();
    const auto& state  = _db.get<resource_limits_state_object>();
-   const auto& usage  = _db.get<resource_usage_object, by_owner>(name);
+   const auto& net_usage = _usage_cache->net_usage(_db, name);
 
    int64_t net_weight, x, y;
    get_account_limits( name, x, net_weight, y );
@@ -429,7 +568,7 @@ account_resource_limit resource_limits_manager::get_account_net_limit_ex( const
 
 
    auto max_user_use_in_window = (virtual_network_capacity_in_window * user_weight) / all_user_weight;
-   auto net_used_in_window  = impl::integer_divide_ceil((uint128_t)usage.net_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
+   auto net_used_in_window  = impl::integer_divide_ceil((uint128_t)net_usage.value_ex * window_size, (uint128_t)config::rate_limiting_precision);
 
    if( max_user_use_in_window <= net_used_in_window )
       arl.available = 0;
@@ -0,0 +1,389 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#include <eosio/chain/sha256_batch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EOSIO_SHA256_BATCH_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace eosio { namespace chain { namespace sha256_batch {
+
+namespace {
+
+   const uint32_t initial_state[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+   };
+
+   alignas(16) const uint32_t round_constants[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+   };
+
+   inline uint32_t load_be32( const uint8_t* p ) {
+      return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+   }
+
+   inline void store_digest( const uint32_t state[8], digest_type& out ) {
+      auto* p = reinterpret_cast<uint8_t*>( out.data() );
+      for( int i = 0; i < 8; ++i ) {
+         p[4*i]   = uint8_t(state[i] >> 24);
+         p[4*i+1] = uint8_t(state[i] >> 16);
+         p[4*i+2] = uint8_t(state[i] >> 8);
+         p[4*i+3] = uint8_t(state[i]);
+      }
+   }
+
+   /// number of 64 byte blocks in the padded message
+   inline size_t block_count( size_t size ) {
+      return (size + 9 + 63) / 64;
+   }
+
+   /// block k of the padded message, the message itself for every block but the last one or two
+   inline const uint8_t* padded_block( const message& m, size_t k, uint8_t buf[64] ) {
+      const size_t offset = k * 64;
+      if( offset + 64 <= m.size )
+         return reinterpret_cast<const uint8_t*>( m.data ) + offset;
+
+      memset( buf, 0, 64 );
+      if( offset < m.size )
+         memcpy( buf, m.data + offset, m.size - offset );
+      if( m.size >= offset && m.size < offset + 64 )
+         buf[m.size - offset] = 0x80;
+      if( k == block_count( m.size ) - 1 ) {
+         const uint64_t bits = uint64_t(m.size) * 8;
+         for( int i = 0; i < 8; ++i )
+            buf[63 - i] = uint8_t(bits >> (8 * i));
+      }
+      return buf;
+   }
+
+   // ------------------------------------------------------------------------------------------------------------
+   // portable
+
+   inline uint32_t rotr( uint32_t x, int n ) { return (x >> n) | (x << (32 - n)); }
+
+   void compress_portable( uint32_t state[8], const uint8_t* block ) {
+      uint32_t w[64];
+      for( int t = 0; t < 16; ++t )
+         w[t] = load_be32( block + 4*t );
+      for( int t = 16; t < 64; ++t ) {
+         uint32_t s0 = rotr(w[t-15], 7) ^ rotr(w[t-15], 18) ^ (w[t-15] >> 3);
+         uint32_t s1 = rotr(w[t-2], 17) ^ rotr(w[t-2], 19) ^ (w[t-2] >> 10);
+         w[t] = w[t-16] + s0 + w[t-7] + s1;
+      }
+
+      uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+      uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+      for( int t = 0; t < 64; ++t ) {
+         uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + round_constants[t] + w[t];
+         uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+         h = g; g = f; f = e; e = d + t1;
+         d = c; c = b; b = a; a = t1 + t2;
+      }
+      state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+      state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+   }
+
+   template<typename Compress>
+   void hash_one( Compress&& compress, const message& m, digest_type& out ) {
+      uint32_t state[8];
+      memcpy( state, initial_state, sizeof(state) );
+      uint8_t buf[64];
+      for( size_t k = 0, n = block_count( m.size ); k < n; ++k )
+         compress( state, padded_block( m, k, buf ) );
+      store_digest( state, out );
+   }
+
+   void hash_portable( const message* msgs, size_t count, digest_type* out ) {
+      for( size_t i = 0; i < count; ++i )
+         hash_one( compress_portable, msgs[i], out[i] );
+   }
+
+#ifdef EOSIO_SHA256_BATCH_X86
+   // ------------------------------------------------------------------------------------------------------------
+   // SHA extensions, one message at a time
+
+   __attribute__((target("sha,sse4.1,ssse3")))
+   void compress_shani( uint32_t state[8], const uint8_t* block ) {
+      const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+
+      __m128i tmp    = _mm_loadu_si128( reinterpret_cast<const __m128i*>(&state[0]) );
+      __m128i state1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>(&state[4]) );
+      tmp    = _mm_shuffle_epi32( tmp, 0xB1 );          // CDAB
+      state1 = _mm_shuffle_epi32( state1, 0x1B );       // EFGH
+      __m128i state0 = _mm_alignr_epi8( tmp, state1, 8 ); // ABEF
+      state1 = _mm_blend_epi16( state1, tmp, 0xF0 );    // CDGH
+
+      const __m128i abef_save = state0;
+      const __m128i cdgh_save = state1;
+
+      __m128i w[4];
+      for( int i = 0; i < 16; ++i ) {
+         __m128i& wi = w[i & 3];
+         if( i < 4 ) {
+            wi = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>(block + 16*i) ), byte_swap );
+         } else {
+            // w[i] = msg2( msg1(w[i-4], w[i-3]) + w[i-1:i-2 shifted by one word], w[i-1] )
+            __m128i t = _mm_sha256msg1_epu32( w[i & 3], w[(i + 1) & 3] );
+            t  = _mm_add_epi32( t, _mm_alignr_epi8( w[(i + 3) & 3], w[(i + 2) & 3], 4 ) );
+            wi = _mm_sha256msg2_epu32( t, w[(i + 3) & 3] );
+         }
+         __m128i msg = _mm_add_epi32( wi, _mm_load_si128( reinterpret_cast<const __m128i*>(&round_constants[4*i]) ) );
+         state1 = _mm_sha256rnds2_epu32( state1, state0, msg );
+         msg    = _mm_shuffle_epi32( msg, 0x0E );
+         state0 = _mm_sha256rnds2_epu32( state0, state1, msg );
+      }
+
+      state0 = _mm_add_epi32( state0, abef_save );
+      state1 = _mm_add_epi32( state1, cdgh_save );
+
+      tmp    = _mm_shuffle_epi32( state0, 0x1B );       // FEBA
+      state1 = _mm_shuffle_epi32( state1, 0xB1 );       // DCHG
+      state0 = _mm_blend_epi16( tmp, state1, 0xF0 );    // DCBA
+      state1 = _mm_alignr_epi8( state1, tmp, 8 );       // ABEF
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(&state[0]), state0 );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(&state[4]), state1 );
+   }
+
+   void hash_shani( const message* msgs, size_t count, digest_type* out ) {
+      for( size_t i = 0; i < count; ++i )
+         hash_one( compress_shani, msgs[i], out[i] );
+   }
+
+   // ------------------------------------------------------------------------------------------------------------
+   // AVX2, 8 messages at a time, one per 32 bit lane
+
+   #define EOSIO_AVX2_ROTR(x, n) _mm256_or_si256( _mm256_srli_epi32( (x), (n) ), _mm256_slli_epi32( (x), 32 - (n) ) )
+
+   /**
+    *  Hashes up to 8 messages. Messages with fewer blocks than the longest one have their state frozen by a lane
+    *  mask once they are done, so callers group messages of similar length.
+    */
+   __attribute__((target("avx2")))
+   void hash8_avx2( const message* const* msgs, size_t count, digest_type* const* out ) {
+      size_t blocks[8] = {};
+      size_t max_blocks = 0;
+      for( size_t l = 0; l < count; ++l ) {
+         blocks[l] = block_count( msgs[l]->size );
+         max_blocks = std::max( max_blocks, blocks[l] );
+      }
+
+      __m256i state[8];
+      for( int i = 0; i < 8; ++i )
+         state[i] = _mm256_set1_epi32( int(initial_state[i]) );
+
+      alignas(32) uint32_t words[16][8];
+      uint8_t bufs[8][64];
+      for( size_t k = 0; k < max_blocks; ++k ) {
+         alignas(32) uint32_t active[8];
+         for( size_t l = 0; l < 8; ++l ) {
+            const bool live = l < count && k < blocks[l];
+            active[l] = live ? 0xFFFFFFFF : 0;
+            if( live ) {
+               const uint8_t* block = padded_block( *msgs[l], k, bufs[l] );
+               for( int t = 0; t < 16; ++t )
+                  words[t][l] = load_be32( block + 4*t );
+            } else {
+               for( int t = 0; t < 16; ++t )
+                  words[t][l] = 0;
+            }
+         }
+
+         __m256i w[16];
+         for( int t = 0; t < 16; ++t )
+            w[t] = _mm256_load_si256( reinterpret_cast<const __m256i*>(words[t]) );
+
+         __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+         __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+         for( int t = 0; t < 64; ++t ) {
+            __m256i wt;
+            if( t < 16 ) {
+               wt = w[t];
+            } else {
+               const __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+               const __m256i s0 = _mm256_xor_si256( _mm256_xor_si256( EOSIO_AVX2_ROTR(w15, 7), EOSIO_AVX2_ROTR(w15, 18) ),
+                                                    _mm256_srli_epi32( w15, 3 ) );
+               const __m256i s1 = _mm256_xor_si256( _mm256_xor_si256( EOSIO_AVX2_ROTR(w2, 17), EOSIO_AVX2_ROTR(w2, 19) ),
+                                                    _mm256_srli_epi32( w2, 10 ) );
+               wt = _mm256_add_epi32( _mm256_add_epi32( w[t & 15], s0 ), _mm256_add_epi32( w[(t - 7) & 15], s1 ) );
+               w[t & 15] = wt;
+            }
+
+            const __m256i S1  = _mm256_xor_si256( _mm256_xor_si256( EOSIO_AVX2_ROTR(e, 6), EOSIO_AVX2_ROTR(e, 11) ), EOSIO_AVX2_ROTR(e, 25) );
+            const __m256i ch  = _mm256_xor_si256( _mm256_and_si256( e, f ), _mm256_andnot_si256( e, g ) );
+            const __m256i t1  = _mm256_add_epi32( _mm256_add_epi32( h, S1 ),
+                                                  _mm256_add_epi32( ch, _mm256_add_epi32( _mm256_set1_epi32( int(round_constants[t]) ), wt ) ) );
+            const __m256i S0  = _mm256_xor_si256( _mm256_xor_si256( EOSIO_AVX2_ROTR(a, 2), EOSIO_AVX2_ROTR(a, 13) ), EOSIO_AVX2_ROTR(a, 22) );
+            const __m256i maj = _mm256_xor_si256( _mm256_and_si256( a, b ), _mm256_and_si256( c, _mm256_xor_si256( a, b ) ) );
+            const __m256i t2  = _mm256_add_epi32( S0, maj );
+            h = g; g = f; f = e; e = _mm256_add_epi32( d, t1 );
+            d = c; c = b; b = a; a = _mm256_add_epi32( t1, t2 );
+         }
+
+         const __m256i mask = _mm256_load_si256( reinterpret_cast<const __m256i*>(active) );
+         const __m256i working[8] = { a, b, c, d, e, f, g, h };
+         for( int i = 0; i < 8; ++i )
+            state[i] = _mm256_blendv_epi8( state[i], _mm256_add_epi32( state[i], working[i] ), mask );
+      }
+
+      alignas(32) uint32_t lanes[8][8];
+      for( int i = 0; i < 8; ++i )
+         _mm256_store_si256( reinterpret_cast<__m256i*>(lanes[i]), state[i] );
+      for( size_t l = 0; l < count; ++l ) {
+         uint32_t s[8];
+         for( int i = 0; i < 8; ++i )
+            s[i] = lanes[i][l];
+         store_digest( s, *out[l] );
+      }
+   }
+
+   #undef EOSIO_AVX2_ROTR
+
+   void hash_avx2( const message* msgs, size_t count, digest_type* out ) {
+      // group messages of similar length so that few lanes idle
+      vector<size_t> order( count );
+      std::iota( order.begin(), order.end(), 0 );
+      std::stable_sort( order.begin(), order.end(), [&]( size_t x, size_t y ) { return msgs[x].size < msgs[y].size; } );
+
+      const message* group[8];
+      digest_type*   results[8];
+      for( size_t i = 0; i < count; i += 8 ) {
+         const size_t n = std::min<size_t>( 8, count - i );
+         for( size_t l = 0; l < n; ++l ) {
+            group[l]   = &msgs[order[i + l]];
+            results[l] = &out[order[i + l]];
+         }
+         hash8_avx2( group, n, results );
+      }
+   }
+
+   struct cpu_features {
+      bool sha  = false;
+      bool avx2 = false;
+
+      cpu_features() {
+         unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+         if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+            return;
+         const bool ssse3   = ecx & (1u << 9);
+         const bool sse41   = ecx & (1u << 19);
+         const bool osxsave = ecx & (1u << 27);
+         const bool avx     = ecx & (1u << 28);
+
+         if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+            return;
+         sha = ssse3 && sse41 && (ebx & (1u << 29));
+
+         if( osxsave && avx ) {
+            uint32_t xcr0_lo = 0, xcr0_hi = 0;
+            __asm__( "xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0) );
+            avx2 = (xcr0_lo & 0x6) == 0x6 && (ebx & (1u << 5));
+         }
+      }
+   };
+
+   const cpu_features& cpu() {
+      static const cpu_features features;
+      return features;
+   }
+
+   /// AVX2 lanes outrun the SHA extensions on a full batch, but not on a handful of messages
+   void hash_auto( const message* msgs, size_t count, digest_type* out ) {
+      const size_t min_avx2_batch = 4;
+      if( cpu().avx2 && (count >= min_avx2_batch || !cpu().sha) )
+         hash_avx2( msgs, count, out );
+      else if( cpu().sha )
+         hash_shani( msgs, count, out );
+      else
+         hash_portable( msgs, count, out );
+   }
+#endif
+
+   using batch_function = void (*)( const message*, size_t, digest_type* );
+
+   struct backend_entry {
+      const char*     name;
+      batch_function  fn;
+      bool            supported;
+   };
+
+   const vector<backend_entry>& backends() {
+      static const vector<backend_entry> result = []() {
+         vector<backend_entry> r;
+#ifdef EOSIO_SHA256_BATCH_X86
+         r.push_back( backend_entry{ "auto", hash_auto, cpu().sha || cpu().avx2 } );
+         r.push_back( backend_entry{ "sha-ni", hash_shani, cpu().sha } );
+         r.push_back( backend_entry{ "avx2", hash_avx2, cpu().avx2 } );
+#endif
+         r.push_back( backend_entry{ "portable", hash_portable, true } );
+         return r;
+      }();
+      return result;
+   }
+
+   /// the first supported backend, "portable" being always supported
+   const backend_entry* default_backend() {
+      for( const auto& b : backends() )
+         if( b.supported ) return &b;
+      return &backends().back();
+   }
+
+   /// chosen once, before the first hash; only set_backend replaces it afterwards
+   std::atomic<const backend_entry*>& selected() {
+      static std::atomic<const backend_entry*> entry( default_backend() );
+      return entry;
+   }
+
+} // anonymous namespace
+
+void hash( const message* msgs, size_t count, digest_type* out ) {
+   selected().load( std::memory_order_acquire )->fn( msgs, count, out );
+}
+
+void hash_pairs( const digest_type* in, size_t pair_count, digest_type* out ) {
+   // batches are bounded so that in-place hashing never overwrites a pair that has not been read yet
+   const size_t batch = 64;
+   message msgs[batch];
+   digest_type results[batch];
+   static_assert( sizeof(digest_type) == 32, "pairs of digests must be contiguous 64 byte messages" );
+   for( size_t i = 0; i < pair_count; i += batch ) {
+      const size_t n = std::min( batch, pair_count - i );
+      for( size_t j = 0; j < n; ++j ) {
+         msgs[j].data = in[2 * (i + j)].data();
+         msgs[j].size = 2 * sizeof(digest_type);
+      }
+      hash( msgs, n, results );
+      std::copy( results, results + n, out + i );
+   }
+}
+
+const char* backend() {
+   return selected().load( std::memory_order_acquire )->name;
+}
+
+bool set_backend( const string& name ) {
+   for( const auto& b : backends() ) {
+      if( name == b.name && b.supported ) {
+         selected().store( &b, std::memory_order_release );
+         return true;
+      }
+   }
+   return false;
+}
+
+} } } /// eosio::chain::sha256_batch
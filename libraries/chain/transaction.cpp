@@ -6,6 +6,8 @@
 #include <fc/bitutil.hpp>
 #include <fc/smart_ref_impl.hpp>
 #include <algorithm>
+#include <array>
+#include <mutex>
 
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/multi_index_container.hpp>
@@ -25,9 +27,9 @@ namespace eosio { namespace chain {
 using namespace boost::multi_index;
 
 struct cached_pub_key {
-   transaction_id_type trx_id;
+   digest_type     digest;
    public_key_type pub_key;
-   signature_type sig;
+   signature_type  sig;
    cached_pub_key(const cached_pub_key&) = delete;
    cached_pub_key() = delete;
    cached_pub_key& operator=(const cached_pub_key&) = delete;
@@ -48,6 +50,58 @@ typedef multi_index_container<
    >
 > recovery_cache_type;
 
+/**
+ * Recovered public keys, shared by every thread that recovers signatures.
+ *
+ * The cache is split into independently locked shards so that the threads recovering the transactions of one block in
+ * parallel rarely wait for each other. Each shard evicts its least recently used entries beyond its capacity.
+ */
+class shared_recovery_cache {
+   public:
+      static constexpr size_t shard_count    = 16;
+      static constexpr size_t shard_capacity = 1024;
+
+      optional<public_key_type> find( const signature_type& sig, const digest_type& digest ) {
+         auto& s = shard_for( sig );
+         std::lock_guard<std::mutex> g( s.mtx );
+         auto& by_sig_idx = s.entries.get<by_sig>();
+         auto it = by_sig_idx.find( sig );
+         if( it == by_sig_idx.end() || it->digest != digest )
+            return optional<public_key_type>();
+         s.entries.relocate( s.entries.end(), s.entries.project<0>( it ) );
+         return it->pub_key;
+      }
+
+      void insert( const signature_type& sig, const digest_type& digest, const public_key_type& pub_key ) {
+         auto& s = shard_for( sig );
+         std::lock_guard<std::mutex> g( s.mtx );
+         auto& by_sig_idx = s.entries.get<by_sig>();
+         auto it = by_sig_idx.find( sig );
+         if( it != by_sig_idx.end() ) // same signature over a different digest; keep the latest
+            by_sig_idx.erase( it );
+         s.entries.emplace_back( cached_pub_key{digest, pub_key, sig} );
+         while( s.entries.size() > shard_capacity )
+            s.entries.pop_front();
+      }
+
+   private:
+      struct shard {
+         std::mutex           mtx;
+         recovery_cache_type  entries;
+      };
+
+      shard& shard_for( const signature_type& sig ) {
+         return _shards[ boost::hash<signature_type>()( sig ) % shard_count ];
+      }
+
+      std::array<shard, shard_count> _shards;
+};
+
+static shared_recovery_cache& get_recovery_cache() {
+   static shared_recovery_cache cache;
+   return cache;
+}
+
 void transaction_header::set_reference_block( const block_id_type& reference_block ) {
    ref_block_num    = fc::endian_reverse_u32(reference_block._hash[0]);
    ref_block_prefix = reference_block._hash[1];
@@ -86,23 +140,21 @@ flat_set<public_key_type> transaction::get_signature_keys( const vector<signatur
 { try {
    using boost::adaptors::transformed;
 
-   constexpr size_t recovery_cache_size = 1000;
-   static thread_local recovery_cache_type recovery_cache;
    const digest_type digest = sig_digest(chain_id, cfd);
 
    flat_set<public_key_type> recovered_pub_keys;
    for(const signature_type& sig : signatures) {
+      optional<public_key_type> cached;
+      if( use_cache )
+         cached = get_recovery_cache().find( sig, digest );
+
       public_key_type recov;
-      if( use_cache ) {
-         recovery_cache_type::index<by_sig>::type::iterator it = recovery_cache.get<by_sig>().find( sig );
-         if( it == recovery_cache.get<by_sig>().end() || it->trx_id != id()) {
-            recov = public_key_type( sig, digest );
-            recovery_cache.emplace_back(cached_pub_key{id(), recov, sig} ); //could fail on dup signatures; not a problem
-         } else {
-            recov = it->pub_key;
-         }
+      if( cached ) {
+         recov = *cached;
       } else {
          recov = public_key_type( sig, digest );
+         if( use_cache )
+            get_recovery_cache().insert( sig, digest, recov );
       }
       bool successful_insertion = false;
       std::tie(std::ignore, successful_insertion) = recovered_pub_keys.insert(recov);
@@ -112,11 +164,6 @@ flat_set<public_key_type> transaction::get_signature_keys( const vector<signatur
                );
    }
 
-   if( use_cache ) {
-      while ( recovery_cache.size() > recovery_cache_size )
-         recovery_cache.erase( recovery_cache.begin() );
-   }
-
    return recovered_pub_keys;
 } FC_CAPTURE_AND_RETHROW() }
 
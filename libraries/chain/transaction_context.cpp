@@ -17,134 +17,210 @@
 #include <boost/accumulators/statistics/weighted_variance.hpp>
 #pragma pop_macro("N")
 
+#include <boost/core/ignore_unused.hpp>
+
 #include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace eosio { namespace chain {
 
 namespace bacc = boost::accumulators;
 
-   struct deadline_timer_verify {
-      deadline_timer_verify() {
-         //keep longest first in list. You're effectively going to take test_intervals[0]*sizeof(test_intervals[0])
-         //time to do the the "calibration"
-         int test_intervals[] = {50000, 10000, 5000, 1000, 500, 100, 50, 10};
-
-         struct sigaction act;
-         sigemptyset(&act.sa_mask);
-         act.sa_handler = timer_hit;
-         act.sa_flags = 0;
-         if(sigaction(SIGALRM, &act, NULL))
-            return;
-
-         sigset_t alrm;
-         sigemptyset(&alrm);
-         sigaddset(&alrm, SIGALRM);
-         int dummy;
-
-         for(int& interval : test_intervals) {
-            unsigned int loops = test_intervals[0]/interval;
-
-            for(unsigned int i = 0; i < loops; ++i) {
-               struct itimerval enable = {{0, 0}, {0, interval}};
-               hit = 0;
-               auto start = std::chrono::high_resolution_clock::now();
-               if(setitimer(ITIMER_REAL, &enable, NULL))
+   /**
+    * Single thread shared by all deadline_timers which flips their `expired` flag once their deadline passes.
+    *
+    * calibrate() measures the wake-up latency of the watchdog: timers are then armed that much earlier so that most
+    * of them expire before their deadline. Until it has run, or if the latency is too high to be useful, every timer
+    * is treated as already expired which makes checktime() poll the clock.
+    */
+   class deadline_watchdog {
+      public:
+         static deadline_watchdog& instance() {
+            static deadline_watchdog watchdog;
+            return watchdog;
+         }
+
+         ~deadline_watchdog() {
+            {
+               std::lock_guard<std::mutex> g(mtx);
+               shutdown = true;
+            }
+            cv.notify_one();
+            if( thread.joinable() )
+               thread.join();
+         }
+
+         void arm( deadline_timer& t, fc::time_point tp ) {
+            if( !use_watchdog.load(std::memory_order_acquire) ) {
+               t.expired = true;
+               return;
+            }
+            schedule( t, tp - fc::microseconds(timer_overhead) );
+         }
+
+         void disarm( deadline_timer& t ) {
+            std::lock_guard<std::mutex> g(mtx);
+            remove_locked( t );
+         }
+
+         const deadline_timer::calibration& calibrate() {
+            std::call_once( calibrated, [this]{
+               result = measure();
+
+               #define TIMER_STATS_FORMAT "min:${min}us max:${max}us mean:${mean}us stddev:${stddev}us, checktime cost polled:${polled}ns watchdog:${flag}ns"
+               #define TIMER_STATS \
+                  ("min", bacc::min(samples))("max", bacc::max(samples)) \
+                  ("mean", (int)bacc::mean(samples))("stddev", (int)sqrt(bacc::variance(samples))) \
+                  ("t", result.timer_overhead_us)("polled", result.polled_check_ns)("flag", result.flagged_check_ns)
+
+               if(result.use_watchdog)
+                  ilog("Using ${t}us watchdog deadline timer for checktime: " TIMER_STATS_FORMAT, TIMER_STATS);
+               else
+                  wlog("Using polled checktime; watchdog deadline timer too inaccurate: " TIMER_STATS_FORMAT, TIMER_STATS);
+
+               timer_overhead = result.timer_overhead_us;
+               use_watchdog.store( result.use_watchdog, std::memory_order_release );
+            });
+            return result;
+         }
+
+      private:
+         using clock = std::chrono::steady_clock;
+
+         deadline_watchdog()
+         :thread( [this]{ run(); } )
+         {}
+
+         /// hands t to the watchdog thread, which expires it at wake_at
+         void schedule( deadline_timer& t, fc::time_point wake_at ) {
+            fc::microseconds x = wake_at - fc::time_point::now();
+            bool notify = false;
+            {
+               std::lock_guard<std::mutex> g(mtx);
+               remove_locked( t );
+               if( x.count() <= 0 ) {
+                  t.expired = true;
                   return;
-               while(!hit) {}
-               auto end = std::chrono::high_resolution_clock::now();
-               int timer_slop = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() - interval;
-
-               //since more samples are run for the shorter expirations, weigh the longer expirations accordingly. This
-               //helps to make a few results more fair. Two such examples: AWS c4&i5 xen instances being rather stable
-               //down to 100us but then struggling with 50us and 10us. MacOS having performance that seems to correlate
-               //with expiry length; that is, long expirations have high error, short expirations have low error.
-               //That said, for these platforms, a tighter tolerance may possibly be achieved by taking performance
-               //metrics in mulitple bins and appliying the slop based on which bin a deadline resides in. Not clear
-               //if that's worth the extra complexity at this point.
-               samples(timer_slop, bacc::weight = interval/(float)test_intervals[0]);
+               }
+               t.expired = false;
+               t.armed_itr = armed.emplace( clock::now() + std::chrono::microseconds(x.count()), &t );
+               t.is_armed = true;
+               notify = (t.armed_itr == armed.begin());
             }
+            if( notify )
+               cv.notify_one(); // new earliest deadline, watchdog has to sleep less
          }
-         timer_overhead = bacc::mean(samples) + sqrt(bacc::variance(samples))*2; //target 95% of expirations before deadline
-         use_deadline_timer = timer_overhead < 1000;
 
-         act.sa_handler = SIG_DFL;
-         sigaction(SIGALRM, &act, NULL);
-      }
+         void remove_locked( deadline_timer& t ) {
+            if( !t.is_armed )
+               return;
+            t.is_armed = false;
+            armed.erase( t.armed_itr );
+         }
 
-      static void timer_hit(int) {
-         hit = 1;
-      }
-      static volatile sig_atomic_t hit;
+         void run() {
+            std::unique_lock<std::mutex> lock(mtx);
+            while( !shutdown ) {
+               if( armed.empty() ) {
+                  cv.wait( lock );
+                  continue;
+               }
+               auto now = clock::now();
+               while( !armed.empty() && armed.begin()->first <= now ) {
+                  auto* t = armed.begin()->second;
+                  t->is_armed = false;
+                  t->expired = true;
+                  armed.erase( armed.begin() );
+               }
+               if( !armed.empty() )
+                  cv.wait_until( lock, armed.begin()->first );
+            }
+         }
+
+         deadline_timer::calibration measure() {
+            //keep longest first in list. You're effectively going to take test_intervals[0]*sizeof(test_intervals[0])
+            //time to do the the "calibration"
+            int test_intervals[] = {50000, 10000, 5000, 1000, 500, 100, 50, 10};
+
+            deadline_timer::calibration r;
+            deadline_timer t{deadline_timer::calibration_t()};
+            for(int& interval : test_intervals) {
+               unsigned int loops = test_intervals[0]/interval;
+
+               for(unsigned int i = 0; i < loops; ++i) {
+                  auto start = std::chrono::high_resolution_clock::now();
+                  schedule( t, fc::time_point::now() + fc::microseconds(interval) );
+                  while(!t.expired) {}
+                  auto end = std::chrono::high_resolution_clock::now();
+                  int timer_slop = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() - interval;
+
+                  //since more samples are run for the shorter expirations, weigh the longer expirations accordingly
+                  samples(timer_slop, bacc::weight = interval/(float)test_intervals[0]);
+               }
+            }
+            r.timer_overhead_us = bacc::mean(samples) + sqrt(bacc::variance(samples))*2; //target 95% of expirations before deadline
+            r.use_watchdog = r.timer_overhead_us < 1000;
+
+            // cost of a single checktime() in each mode, in nanoseconds
+            const int checks = 100000;
+            auto start = std::chrono::high_resolution_clock::now();
+            fc::time_point latest;
+            for( int i = 0; i < checks; ++i )
+               latest = std::max( latest, fc::time_point::now() );
+            auto mid = std::chrono::high_resolution_clock::now();
+            int flags = 0;
+            for( int i = 0; i < checks; ++i )
+               flags += t.expired.load( std::memory_order_relaxed );
+            auto end = std::chrono::high_resolution_clock::now();
+            r.polled_check_ns  = std::chrono::duration_cast<std::chrono::nanoseconds>(mid-start).count() / (double)checks;
+            r.flagged_check_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end-mid).count() / (double)checks;
+            boost::ignore_unused( latest, flags );
+            return r;
+         }
 
-      bacc::accumulator_set<int, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::variance>, float> samples;
-      bool use_deadline_timer = false;
-      int timer_overhead;
+         std::atomic<bool>                           use_watchdog{false};
+         std::atomic<int>                            timer_overhead{0};
+         std::once_flag                              calibrated;
+         deadline_timer::calibration                 result;
+         bacc::accumulator_set<int, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::variance>, float> samples;
+
+         std::mutex                                  mtx;
+         std::condition_variable                     cv;
+         deadline_timer::armed_map                   armed;
+         bool                                        shutdown = false;
+         std::thread                                 thread;
    };
-   volatile sig_atomic_t deadline_timer_verify::hit;
-   static deadline_timer_verify deadline_timer_verification;
 
    deadline_timer::deadline_timer() {
-      if(initialized)
-         return;
-      initialized = true;
-
-      #define TIMER_STATS_FORMAT "min:${min}us max:${max}us mean:${mean}us stddev:${stddev}us"
-      #define TIMER_STATS \
-         ("min", bacc::min(deadline_timer_verification.samples))("max", bacc::max(deadline_timer_verification.samples)) \
-         ("mean", (int)bacc::mean(deadline_timer_verification.samples))("stddev", (int)sqrt(bacc::variance(deadline_timer_verification.samples))) \
-         ("t", deadline_timer_verification.timer_overhead)
-
-      if(deadline_timer_verification.use_deadline_timer) {
-         struct sigaction act;
-         act.sa_handler = timer_expired;
-         sigemptyset(&act.sa_mask);
-         act.sa_flags = 0;
-         if(sigaction(SIGALRM, &act, NULL) == 0) {
-            ilog("Using ${t}us deadline timer for checktime: " TIMER_STATS_FORMAT, TIMER_STATS);
-            return;
-         }
-      }
+      deadline_watchdog::instance();
+   }
 
-      wlog("Using polled checktime; deadline timer too inaccurate: " TIMER_STATS_FORMAT, TIMER_STATS);
-      deadline_timer_verification.use_deadline_timer = false; //set in case sigaction() fails above
+   const deadline_timer::calibration& deadline_timer::calibrate() {
+      return deadline_watchdog::instance().calibrate();
    }
 
    void deadline_timer::start(fc::time_point tp) {
       if(tp == fc::time_point::maximum()) {
-         expired = 0;
+         stop();
+         expired = false;
          return;
       }
-      if(!deadline_timer_verification.use_deadline_timer) {
-         expired = 1;
-         return;
-      }
-      microseconds x = tp.time_since_epoch() - fc::time_point::now().time_since_epoch();
-      if(x.count() <= deadline_timer_verification.timer_overhead)
-         expired = 1;
-      else {
-         struct itimerval enable = {{0, 0}, {0, (int)x.count()-deadline_timer_verification.timer_overhead}};
-         expired = 0;
-         expired |= !!setitimer(ITIMER_REAL, &enable, NULL);
-      }
+      deadline_watchdog::instance().arm(*this, tp);
    }
 
    void deadline_timer::stop() {
       if(expired)
          return;
-      struct itimerval disable = {{0, 0}, {0, 0}};
-      setitimer(ITIMER_REAL, &disable, NULL);
+      deadline_watchdog::instance().disarm(*this);
    }
 
    deadline_timer::~deadline_timer() {
       stop();
    }
 
-   void deadline_timer::timer_expired(int) {
-      expired = 1;
-   }
-   volatile sig_atomic_t deadline_timer::expired = 0;
-   bool deadline_timer::initialized = false;
-
    transaction_context::transaction_context( controller& c,
                                              const signed_transaction& t,
                                              const transaction_id_type& trx_id,
@@ -153,6 +229,7 @@ namespace bacc = boost::accumulators;
    ,trx(t)
    ,id(trx_id)
    ,undo_session()
+   ,usage_session()
    ,trace(std::make_shared<transaction_trace>())
    ,start(s)
    ,net_usage(trace->net_usage)
@@ -160,6 +237,7 @@ namespace bacc = boost::accumulators;
    {
       if (!c.skip_db_sessions()) {
          undo_session = c.mutable_db().start_undo_session(true);
+         usage_session = c.get_mutable_resource_limits_manager().start_usage_session();
       }
       trace->id = id;
       trace->block_num = c.pending_block_state()->block_num;
@@ -232,7 +310,7 @@ namespace bacc = boost::accumulators;
       int64_t account_net_limit = 0;
       int64_t account_cpu_limit = 0;
       bool greylisted_net = false, greylisted_cpu = false;
-      std::tie( account_net_limit, account_cpu_limit, greylisted_net, greylisted_cpu) = max_bandwidth_billed_accounts_can_pay();
+      std::tie( account_net_limit, account_cpu_limit, greylisted_net, greylisted_cpu) = max_bandwidth_billed_accounts_can_pay( checktime_limit > 0 );
       net_limit_due_to_greylist |= greylisted_net;
       cpu_limit_due_to_greylist |= greylisted_cpu;
 
@@ -268,8 +346,13 @@ namespace bacc = boost::accumulators;
 
       checktime(); // Fail early if deadline has already been exceeded
 
-      if(control.skip_trx_checks())
-         _deadline_timer.expired = 0;
+      EOS_ASSERT( checktime_limit == 0 || explicit_billed_cpu_time, transaction_exception,
+                  "a checktime limit requires an explicitly billed cpu time" );
+
+      if( checktime_limit > 0 )
+         _deadline_timer.expired = true; // every checktime() counts against the limit, even when replaying
+      else if(control.skip_trx_checks())
+         _deadline_timer.expired = false;
       else
          _deadline_timer.start(_deadline);
 
@@ -370,7 +453,7 @@ namespace bacc = boost::accumulators;
       int64_t account_net_limit = 0;
       int64_t account_cpu_limit = 0;
       bool greylisted_net = false, greylisted_cpu = false;
-      std::tie( account_net_limit, account_cpu_limit, greylisted_net, greylisted_cpu) = max_bandwidth_billed_accounts_can_pay();
+      std::tie( account_net_limit, account_cpu_limit, greylisted_net, greylisted_cpu) = max_bandwidth_billed_accounts_can_pay( checktime_limit > 0 );
       net_limit_due_to_greylist |= greylisted_net;
       cpu_limit_due_to_greylist |= greylisted_cpu;
 
@@ -406,10 +489,12 @@ namespace bacc = boost::accumulators;
 
    void transaction_context::squash() {
       if (undo_session) undo_session->squash();
+      if (usage_session) usage_session->squash();
    }
 
    void transaction_context::undo() {
       if (undo_session) undo_session->undo();
+      if (usage_session) usage_session->undo();
    }
 
    void transaction_context::check_net_usage()const {
@@ -433,8 +518,13 @@ namespace bacc = boost::accumulators;
    }
 
    void transaction_context::checktime()const {
-      if(BOOST_LIKELY(_deadline_timer.expired == false))
+      if(BOOST_LIKELY(_deadline_timer.expired.load(std::memory_order_relaxed) == false))
          return;
+      if( checktime_limit > 0 ) {
+         EOS_ASSERT( ++checktime_calls <= checktime_limit, deadline_exception,
+                     "checktime limit of ${limit} exceeded", ("limit", checktime_limit) );
+         return;
+      }
       auto now = fc::time_point::now();
       if( BOOST_UNLIKELY( now > _deadline ) ) {
          // edump((now-start)(now-pseudo_start));
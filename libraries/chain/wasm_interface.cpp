@@ -1256,6 +1256,38 @@ class database_api : public context_aware_api {
       DB_API_METHOD_WRAPPERS_FLOAT_SECONDARY(idx_long_double, float128_t)
 };
 
+#define DB_API_METHOD_WRAPPERS_BATCH_SECONDARY(IDX)\
+      int db_##IDX##_get_range( int iterator, uint32_t max_rows, uint32_t reverse, array_ptr<char> buffer, size_t buffer_size, int& next ) {\
+         return context.IDX.get_range_secondary(iterator, max_rows, reverse != 0, buffer, buffer_size, next);\
+      }
+
+/**
+ * Batched row reads, which copy many rows of a table across the wasm boundary in one call.
+ * Restricted to privileged contracts since they are not part of the base contract API.
+ */
+class database_batch_api : public context_aware_api {
+   public:
+      database_batch_api( apply_context& ctx )
+      :context_aware_api(ctx)
+      {
+         EOS_ASSERT( context.privileged, unaccessible_api, "${code} does not have permission to call this API", ("code",context.receiver) );
+      }
+
+      int db_get_range_i64( int itr, uint32_t max_rows, array_ptr<char> buffer, size_t buffer_size, int& next ) {
+         return context.db_get_range_i64( itr, max_rows, buffer, buffer_size, next );
+      }
+      int db_get_multi_i64( uint64_t code, uint64_t scope, uint64_t table, array_ptr<const uint64_t> ids, size_t ids_count,
+                            array_ptr<char> buffer, size_t buffer_size ) {
+         return context.db_get_multi_i64( code, scope, table, ids, ids_count, buffer, buffer_size );
+      }
+
+      DB_API_METHOD_WRAPPERS_BATCH_SECONDARY(idx64)
+      DB_API_METHOD_WRAPPERS_BATCH_SECONDARY(idx128)
+      DB_API_METHOD_WRAPPERS_BATCH_SECONDARY(idx256)
+      DB_API_METHOD_WRAPPERS_BATCH_SECONDARY(idx_double)
+      DB_API_METHOD_WRAPPERS_BATCH_SECONDARY(idx_long_double)
+};
+
 class memory_api : public context_aware_api {
    public:
       memory_api( apply_context& ctx )
@@ -1738,6 +1770,20 @@ REGISTER_INTRINSICS( database_api,
    DB_SECONDARY_INDEX_METHODS_SIMPLE(idx_long_double)
 );
 
+#define DB_SECONDARY_INDEX_METHODS_BATCH(IDX) \
+   (db_##IDX##_get_range,      int(int,int,int,int,int,int))
+
+REGISTER_INTRINSICS( database_batch_api,
+   (db_get_range_i64,    int(int,int,int,int,int))
+   (db_get_multi_i64,    int(int64_t,int64_t,int64_t,int,int,int,int))
+
+   DB_SECONDARY_INDEX_METHODS_BATCH(idx64)
+   DB_SECONDARY_INDEX_METHODS_BATCH(idx128)
+   DB_SECONDARY_INDEX_METHODS_BATCH(idx256)
+   DB_SECONDARY_INDEX_METHODS_BATCH(idx_double)
+   DB_SECONDARY_INDEX_METHODS_BATCH(idx_long_double)
+);
+
 REGISTER_INTRINSICS(crypto_api,
    (assert_recover_key,     void(int, int, int, int, int) )
    (recover_key,            int(int, int, int, int, int)  )
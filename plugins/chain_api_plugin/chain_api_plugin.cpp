@@ -68,10 +68,39 @@ struct async_result_visitor : public fc::visitor<std::string> {
    }\
 }
 
+// responds with the result of call_name ## _packed, bytes packed with fc::raw
+#define CALL_PACKED(api_name, api_handle, api_namespace, call_name, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle](string, string body, url_response_callback cb) mutable { \
+          api_handle.validate(); \
+          try { \
+             if (body.empty()) body = "{}"; \
+             auto result = api_handle.call_name ## _packed(fc::json::from_string(body).as<api_namespace::call_name ## _params>()); \
+             cb(http_response_code, std::string(result.begin(), result.end())); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+       }}
+
+// responds with the json string returned by call_name ## _json, without going through a variant
+#define CALL_JSON(api_name, api_handle, api_namespace, call_name, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle](string, string body, url_response_callback cb) mutable { \
+          api_handle.validate(); \
+          try { \
+             if (body.empty()) body = "{}"; \
+             cb(http_response_code, api_handle.call_name ## _json(fc::json::from_string(body).as<api_namespace::call_name ## _params>())); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+       }}
+
 #define CHAIN_RO_CALL(call_name, http_response_code) CALL(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
 #define CHAIN_RW_CALL(call_name, http_response_code) CALL(chain, rw_api, chain_apis::read_write, call_name, http_response_code)
 #define CHAIN_RO_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, ro_api, chain_apis::read_only, call_name, call_result, http_response_code)
 #define CHAIN_RW_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, rw_api, chain_apis::read_write, call_name, call_result, http_response_code)
+#define CHAIN_RO_CALL_PACKED(call_name, http_response_code) CALL_PACKED(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
+#define CHAIN_RO_CALL_JSON(call_name, http_response_code) CALL_JSON(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
 
 void chain_api_plugin::plugin_startup() {
    ilog( "starting chain_api_plugin" );
@@ -82,9 +111,9 @@ void chain_api_plugin::plugin_startup() {
    auto& _http_plugin = app().get_plugin<http_plugin>();
    ro_api.set_shorten_abi_errors( !_http_plugin.verbose_errors() );
 
+   // calls that only read chain state run concurrently on the http read-only threads
    _http_plugin.add_api({
       CHAIN_RO_CALL(get_info, 200l),
-      CHAIN_RO_CALL(get_block, 200),
       CHAIN_RO_CALL(get_block_header_state, 200),
       CHAIN_RO_CALL(get_account, 200),
       CHAIN_RO_CALL(get_code, 200),
@@ -102,11 +131,27 @@ void chain_api_plugin::plugin_startup() {
       CHAIN_RO_CALL(abi_json_to_bin, 200),
       CHAIN_RO_CALL(abi_bin_to_json, 200),
       CHAIN_RO_CALL(get_required_keys, 200),
-      CHAIN_RO_CALL(get_transaction_id, 200),
+      CHAIN_RO_CALL(get_transaction_id, 200)
+   }, handler_thread::read_only);
+
+   _http_plugin.add_api({
+      CHAIN_RO_CALL_JSON(get_block, 200), // may read the block log, whose file stream is not shared between threads
       CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202),
       CHAIN_RW_CALL_ASYNC(push_transaction, chain_apis::read_write::push_transaction_results, 202),
       CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202)
    });
+
+   // Accept: application/octet-stream selects these, which skip the conversion to variants and json
+   _http_plugin.add_binary_api({
+      CHAIN_RO_CALL_PACKED(get_block_header_state, 200),
+      CHAIN_RO_CALL_PACKED(get_table_rows, 200),
+      CHAIN_RO_CALL_PACKED(get_abi, 200),
+      CHAIN_RO_CALL_PACKED(get_raw_code_and_abi, 200)
+   }, handler_thread::read_only);
+
+   _http_plugin.add_binary_api({
+      CHAIN_RO_CALL_PACKED(get_block, 200)
+   });
 }
 
 void chain_api_plugin::plugin_shutdown() {}
@@ -26,6 +26,7 @@
 #include <fc/variant.hpp>
 #include <signal.h>
 #include <cstdlib>
+#include <mutex>
 
 namespace eosio {
 
@@ -136,6 +137,49 @@ using boost::signals2::scoped_connection;
       NEXT(e.dynamic_copy_exception());\
    }
 
+namespace chain_apis {
+
+/**
+ *  The serialized get_block responses of the most recent irreversible blocks, which never change.
+ *
+ *  The packed form depends only on the block. The json form also depends on the abis of the contracts whose actions
+ *  the block contains, so an entry records the abi_sequence of each of those contracts and its json is only served
+ *  while none of them has set a new abi. Entries are immutable once stored and are shared with the threads serving them.
+ */
+class block_response_cache {
+   public:
+      struct entry {
+         block_id_type                           id;
+         optional<string>                        json;
+         optional<bytes>                         packed;
+         vector<pair<account_name,uint64_t>>     abi_sequences; ///< of the contracts whose abis json was produced with
+      };
+      using entry_ptr = std::shared_ptr<const entry>;
+
+      explicit block_response_cache( uint32_t max_blocks ) : max_blocks( max_blocks ) {}
+
+      entry_ptr find( uint32_t block_num )const {
+         std::lock_guard<std::mutex> g( mtx );
+         auto itr = entries.find( block_num );
+         return itr != entries.end() ? itr->second : entry_ptr();
+      }
+
+      /// clients poll recent blocks, so the oldest block is evicted first
+      void store( uint32_t block_num, entry_ptr e ) {
+         std::lock_guard<std::mutex> g( mtx );
+         entries[block_num] = std::move( e );
+         while( entries.size() > max_blocks )
+            entries.erase( entries.begin() );
+      }
+
+   private:
+      const uint32_t                   max_blocks;
+      mutable std::mutex               mtx;
+      std::map<uint32_t, entry_ptr>    entries; ///< guarded by mtx
+};
+
+} // namespace chain_apis
+
 
 class chain_plugin_impl {
 public:
@@ -165,6 +209,8 @@ public:
    fc::optional<vm_type>            wasm_runtime;
    fc::microseconds                 abi_serializer_max_time_ms;
    fc::optional<bfs::path>          snapshot_path;
+   std::shared_ptr<chain_apis::block_response_cache> block_cache;
+   bool                             precompute_block_cache = false;
 
 
    // retained references to channels for easy publication
@@ -220,6 +266,10 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the reverseible blocks database drops below this size (in MiB).")
          ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
           "Number of worker threads in controller thread pool")
+         ("get-block-cache-size", bpo::value<uint32_t>()->default_value(512),
+          "Number of recent irreversible blocks whose get_block responses are kept in memory; 0 disables the cache")
+         ("get-block-cache-precompute", bpo::bool_switch()->default_value(false),
+          "Serialize the get_block responses of every block as it becomes irreversible, instead of on first request")
          ("contracts-console", bpo::bool_switch()->default_value(false),
           "print contract's output to console")
          ("actor-whitelist", boost::program_options::value<vector<string>>()->composing()->multitoken(),
@@ -403,6 +453,11 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       if(options.count("abi-serializer-max-time-ms"))
          my->abi_serializer_max_time_ms = fc::microseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
 
+      if( options.at( "get-block-cache-size" ).as<uint32_t>() > 0 ) {
+         my->block_cache = std::make_shared<chain_apis::block_response_cache>( options.at( "get-block-cache-size" ).as<uint32_t>() );
+         my->precompute_block_cache = options.at( "get-block-cache-precompute" ).as<bool>();
+      }
+
       my->chain_config->blocks_dir = my->blocks_dir;
       my->chain_config->state_dir = app().data_dir() / config::default_state_dir_name;
       my->chain_config->read_only = my->readonly;
@@ -678,6 +733,13 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       } );
 
       my->irreversible_block_connection = my->chain->irreversible_block.connect( [this]( const block_state_ptr& blk ) {
+         if( my->precompute_block_cache ) {
+            try {
+               get_read_only_api().cache_irreversible_block( blk->block );
+            } catch( const fc::exception& e ) {
+               dlog( "unable to cache get_block of block ${n}: ${e}", ("n", blk->block_num)("e", e.to_detail_string()) );
+            }
+         }
          my->irreversible_block_channel.publish( blk );
       } );
 
@@ -976,6 +1038,10 @@ fc::microseconds chain_plugin::get_abi_serializer_max_time() const {
    return my->abi_serializer_max_time_ms;
 }
 
+chain_apis::read_only chain_plugin::get_read_only_api() const {
+   return chain_apis::read_only(chain(), get_abi_serializer_max_time(), my->block_cache);
+}
+
 void chain_plugin::log_guard_exception(const chain::guard_exception&e ) const {
    if (e.code() == chain::database_guard_exception::code_value) {
       elog("Database has reached an unsafe level of usage, shutting down to avoid corrupting the database.  "
@@ -1141,65 +1207,97 @@ string get_table_type( const abi_def& abi, const name& table_name ) {
    EOS_ASSERT( false, chain::contract_table_query_exception, "Table ${table} is not specified in the ABI", ("table",table_name) );
 }
 
-read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
-
+template <typename RowFn>
+bool read_only::walk_table_rows( const read_only::get_table_rows_params& p, const abi_def& abi, RowFn&& on_row )const {
    bool primary = false;
    auto table_with_index = get_table_index_name( p, primary );
    if( primary ) {
       EOS_ASSERT( p.table == table_with_index, chain::contract_table_query_exception, "Invalid table name ${t}", ( "t", p.table ));
       auto table_type = get_table_type( abi, p.table );
       if( table_type == KEYi64 || p.key_type == "i64" || p.key_type == "name" ) {
-         return get_table_rows_ex<key_value_index>(p,abi);
+         return walk_table_rows_ex<key_value_index>(p, on_row);
       }
       EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi));
    } else {
       EOS_ASSERT( !p.key_type.empty(), chain::contract_table_query_exception, "key type required for non-primary index" );
 
       if (p.key_type == chain_apis::i64 || p.key_type == "name") {
-         return get_table_rows_by_seckey<index64_index, uint64_t>(p, abi, [](uint64_t v)->uint64_t {
+         return walk_table_rows_by_seckey<index64_index, uint64_t>(p, [](uint64_t v)->uint64_t {
             return v;
-         });
+         }, on_row);
       }
       else if (p.key_type == chain_apis::i128) {
-         return get_table_rows_by_seckey<index128_index, uint128_t>(p, abi, [](uint128_t v)->uint128_t {
+         return walk_table_rows_by_seckey<index128_index, uint128_t>(p, [](uint128_t v)->uint128_t {
             return v;
-         });
+         }, on_row);
       }
       else if (p.key_type == chain_apis::i256) {
          if ( p.encode_type == chain_apis::hex) {
             using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+            return walk_table_rows_by_seckey<conv::index_type, conv::input_type>(p, conv::function(), on_row);
          }
          using  conv = keytype_converter<chain_apis::i256>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return walk_table_rows_by_seckey<conv::index_type, conv::input_type>(p, conv::function(), on_row);
       }
       else if (p.key_type == chain_apis::float64) {
-         return get_table_rows_by_seckey<index_double_index, double>(p, abi, [](double v)->float64_t {
+         return walk_table_rows_by_seckey<index_double_index, double>(p, [](double v)->float64_t {
             float64_t f = *(float64_t *)&v;
             return f;
-         });
+         }, on_row);
       }
       else if (p.key_type == chain_apis::float128) {
-         return get_table_rows_by_seckey<index_long_double_index, double>(p, abi, [](double v)->float128_t{
+         return walk_table_rows_by_seckey<index_long_double_index, double>(p, [](double v)->float128_t{
             float64_t f = *(float64_t *)&v;
             float128_t f128;
             f64_to_f128M(f, &f128);
             return f128;
-         });
+         }, on_row);
       }
       else if (p.key_type == chain_apis::sha256) {
          using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return walk_table_rows_by_seckey<conv::index_type, conv::input_type>(p, conv::function(), on_row);
       }
       else if(p.key_type == chain_apis::ripemd160) {
          using  conv = keytype_converter<chain_apis::ripemd160,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return walk_table_rows_by_seckey<conv::index_type, conv::input_type>(p, conv::function(), on_row);
       }
       EOS_ASSERT(false, chain::contract_table_query_exception,  "Unsupported secondary index type: ${t}", ("t", p.key_type));
    }
 }
 
+read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
+   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
+
+   read_only::get_table_rows_result result;
+   abi_serializer abis;
+   abis.set_abi(abi, abi_serializer_max_time);
+   result.more = walk_table_rows( p, abi, [&]( const vector<char>& data, const name& payer ) {
+      fc::variant data_var;
+      if( p.json ) {
+         data_var = abis.binary_to_variant( abis.get_table_type(p.table), data, abi_serializer_max_time, shorten_abi_errors );
+      } else {
+         data_var = fc::variant( data );
+      }
+
+      if( p.show_payer && *p.show_payer ) {
+         result.rows.emplace_back( fc::mutable_variant_object("data", std::move(data_var))("payer", payer) );
+      } else {
+         result.rows.emplace_back( std::move(data_var) );
+      }
+   });
+   return result;
+}
+
+bytes read_only::get_table_rows_packed( const read_only::get_table_rows_params& p )const {
+   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
+
+   read_only::get_table_rows_packed_result result;
+   result.more = walk_table_rows( p, abi, [&]( const vector<char>& data, const name& payer ) {
+      result.rows.emplace_back( table_row_packed{ bytes( data.begin(), data.end() ), payer } );
+   });
+   return fc::raw::pack( result );
+}
+
 read_only::get_table_by_scope_result read_only::get_table_by_scope( const read_only::get_table_by_scope_params& p )const {
    read_only::get_table_by_scope_result result;
    const auto& d = db.db();
@@ -1479,7 +1577,7 @@ read_only::get_scheduled_transactions( const read_only::get_scheduled_transactio
    return result;
 }
 
-fc::variant read_only::get_block(const read_only::get_block_params& params) const {
+static signed_block_ptr fetch_requested_block( const controller& db, const read_only::get_block_params& params ) {
    signed_block_ptr block;
    EOS_ASSERT(!params.block_num_or_id.empty() && params.block_num_or_id.size() <= 64, chain::block_id_type_exception, "Invalid Block number or ID, must be greater than 0 and less than 64 characters" );
    try {
@@ -1491,9 +1589,12 @@ fc::variant read_only::get_block(const read_only::get_block_params& params) cons
    } EOS_RETHROW_EXCEPTIONS(chain::block_id_type_exception, "Invalid block ID: ${block_num_or_id}", ("block_num_or_id", params.block_num_or_id))
 
    EOS_ASSERT( block, unknown_block_exception, "Could not find block: ${block}", ("block", params.block_num_or_id));
+   return block;
+}
 
+static fc::variant block_to_variant( const signed_block_ptr& block, const read_only* ro, const fc::microseconds& abi_serializer_max_time ) {
    fc::variant pretty_output;
-   abi_serializer::to_variant(*block, pretty_output, make_resolver(this, abi_serializer_max_time), abi_serializer_max_time);
+   abi_serializer::to_variant(*block, pretty_output, make_resolver(ro, abi_serializer_max_time), abi_serializer_max_time);
 
    uint32_t ref_block_prefix = block->id()._hash[1];
 
@@ -1503,7 +1604,123 @@ fc::variant read_only::get_block(const read_only::get_block_params& params) cons
            ("ref_block_prefix", ref_block_prefix);
 }
 
-fc::variant read_only::get_block_header_state(const get_block_header_state_params& params) const {
+fc::variant read_only::get_block(const read_only::get_block_params& params) const {
+   return block_to_variant( fetch_requested_block( db, params ), this, abi_serializer_max_time );
+}
+
+using requested_block = pair<uint32_t, optional<block_id_type>>;
+
+/// the block number, and the id if one was given, of a get_block request for an irreversible block
+static optional<requested_block> requested_irreversible_block( const controller& db, const read_only::get_block_params& params ) {
+   requested_block result;
+   try {
+      if( params.block_num_or_id.size() == 64 ) {
+         result.second = fc::variant(params.block_num_or_id).as<block_id_type>();
+         result.first = block_header::num_from_id( *result.second );
+      } else {
+         result.first = fc::to_uint64( params.block_num_or_id );
+      }
+   } catch( ... ) {
+      return {}; // left to the uncached path to report
+   }
+   if( result.first == 0 || result.first > db.last_irreversible_block_num() )
+      return {};
+   return result;
+}
+
+/// abi_sequence of a contract, or max() for an account which does not exist
+static uint64_t current_abi_sequence( const controller& db, account_name contract ) {
+   const auto* seq = db.db().find<account_sequence_object,by_name>( contract );
+   return seq ? seq->abi_sequence : std::numeric_limits<uint64_t>::max();
+}
+
+static vector<pair<account_name,uint64_t>> current_abi_sequences( const controller& db, const signed_block& block ) {
+   flat_set<account_name> contracts;
+   for( const auto& receipt : block.transactions ) {
+      if( receipt.trx.contains<packed_transaction>() ) {
+         const auto trx = receipt.trx.get<packed_transaction>().get_transaction();
+         for( const auto& a : trx.context_free_actions ) contracts.insert( a.account );
+         for( const auto& a : trx.actions ) contracts.insert( a.account );
+      }
+   }
+
+   vector<pair<account_name,uint64_t>> result;
+   result.reserve( contracts.size() );
+   for( const auto& c : contracts )
+      result.emplace_back( c, current_abi_sequence( db, c ) );
+   return result;
+}
+
+static bool abis_unchanged( const controller& db, const vector<pair<account_name,uint64_t>>& abi_sequences ) {
+   for( const auto& s : abi_sequences ) {
+      if( current_abi_sequence( db, s.first ) != s.second ) return false;
+   }
+   return true;
+}
+
+/// the cached entry of an irreversible block request, if any
+static block_response_cache::entry_ptr find_cached_block( const block_response_cache& cache, const requested_block& requested ) {
+   auto cached = cache.find( requested.first );
+   if( cached && requested.second && *requested.second != cached->id )
+      return {};
+   return cached;
+}
+
+string read_only::get_block_json(const read_only::get_block_params& params) const {
+   auto requested = block_cache ? requested_irreversible_block( db, params ) : optional<requested_block>();
+   block_response_cache::entry_ptr cached;
+   if( requested ) {
+      cached = find_cached_block( *block_cache, *requested );
+      if( cached && cached->json && abis_unchanged( db, cached->abi_sequences ) )
+         return *cached->json;
+   }
+
+   auto block = fetch_requested_block( db, params );
+   string json = fc::json::to_string( block_to_variant( block, this, abi_serializer_max_time ) );
+
+   if( requested ) {
+      auto e = std::make_shared<block_response_cache::entry>();
+      e->id = block->id();
+      e->json = json;
+      e->abi_sequences = current_abi_sequences( db, *block );
+      if( cached ) e->packed = cached->packed;
+      block_cache->store( block->block_num(), std::move( e ) );
+   }
+   return json;
+}
+
+bytes read_only::get_block_packed(const read_only::get_block_params& params) const {
+   auto requested = block_cache ? requested_irreversible_block( db, params ) : optional<requested_block>();
+   block_response_cache::entry_ptr cached;
+   if( requested ) {
+      cached = find_cached_block( *block_cache, *requested );
+      if( cached && cached->packed )
+         return *cached->packed;
+   }
+
+   auto block = fetch_requested_block( db, params );
+   bytes packed = fc::raw::pack( *block );
+
+   if( requested ) {
+      auto e = cached ? std::make_shared<block_response_cache::entry>( *cached ) : std::make_shared<block_response_cache::entry>();
+      e->id = block->id();
+      e->packed = packed;
+      block_cache->store( block->block_num(), std::move( e ) );
+   }
+   return packed;
+}
+
+void read_only::cache_irreversible_block(const chain::signed_block_ptr& block) const {
+   if( !block_cache ) return;
+   auto e = std::make_shared<block_response_cache::entry>();
+   e->id = block->id();
+   e->json = fc::json::to_string( block_to_variant( block, this, abi_serializer_max_time ) );
+   e->packed = fc::raw::pack( *block );
+   e->abi_sequences = current_abi_sequences( db, *block );
+   block_cache->store( block->block_num(), std::move( e ) );
+}
+
+static block_state_ptr fetch_requested_block_state( const controller& db, const read_only::get_block_header_state_params& params ) {
    block_state_ptr b;
    optional<uint64_t> block_num;
    std::exception_ptr e;
@@ -1520,12 +1737,21 @@ fc::variant read_only::get_block_header_state(const get_block_header_state_param
    }
 
    EOS_ASSERT( b, unknown_block_exception, "Could not find reversible block: ${block}", ("block", params.block_num_or_id));
+   return b;
+}
+
+fc::variant read_only::get_block_header_state(const get_block_header_state_params& params) const {
+   block_state_ptr b = fetch_requested_block_state( db, params );
 
    fc::variant vo;
    fc::to_variant( static_cast<const block_header_state&>(*b), vo );
    return vo;
 }
 
+bytes read_only::get_block_header_state_packed(const get_block_header_state_params& params) const {
+   return fc::raw::pack( static_cast<const block_header_state&>(*fetch_requested_block_state( db, params )) );
+}
+
 void read_write::push_block(const read_write::push_block_params& params, next_function<read_write::push_block_results> next) {
    try {
       app().get_method<incoming::methods::block_sync>()(std::make_shared<signed_block>(params));
@@ -1617,6 +1843,11 @@ read_only::get_abi_results read_only::get_abi( const get_abi_params& params )con
    return result;
 }
 
+bytes read_only::get_abi_packed( const get_abi_params& params )const {
+   const auto& accnt = db.db().get<account_object,by_name>( params.account_name );
+   return bytes( accnt.abi.begin(), accnt.abi.end() );
+}
+
 read_only::get_code_results read_only::get_code( const get_code_params& params )const {
    get_code_results result;
    result.account_name = params.account_name;
@@ -1663,6 +1894,10 @@ read_only::get_raw_code_and_abi_results read_only::get_raw_code_and_abi( const g
    return result;
 }
 
+bytes read_only::get_raw_code_and_abi_packed( const get_raw_code_and_abi_params& params)const {
+   return fc::raw::pack( get_raw_code_and_abi( params ) );
+}
+
 read_only::get_raw_abi_results read_only::get_raw_abi( const get_raw_abi_params& params )const {
    get_raw_abi_results result;
    result.account_name = params.account_name;
@@ -42,6 +42,7 @@ namespace eosio {
    using chain::action_name;
    using chain::abi_def;
    using chain::abi_serializer;
+   using chain::bytes;
 
 namespace chain_apis {
 struct empty{};
@@ -69,16 +70,20 @@ uint64_t convert_to_type(const string& str, const string& desc);
 template<>
 double convert_to_type(const string& str, const string& desc);
 
+class block_response_cache;
+
 class read_only {
    const controller& db;
    const fc::microseconds abi_serializer_max_time;
    bool  shorten_abi_errors = true;
+   std::shared_ptr<block_response_cache> block_cache; ///< may be null
 
 public:
    static const string KEYi64;
 
-   read_only(const controller& db, const fc::microseconds& abi_serializer_max_time)
-      : db(db), abi_serializer_max_time(abi_serializer_max_time) {}
+   read_only(const controller& db, const fc::microseconds& abi_serializer_max_time,
+             std::shared_ptr<block_response_cache> block_cache = nullptr)
+      : db(db), abi_serializer_max_time(abi_serializer_max_time), block_cache(std::move(block_cache)) {}
 
    void validate() const {}
 
@@ -202,7 +207,11 @@ public:
    get_code_results get_code( const get_code_params& params )const;
    get_code_hash_results get_code_hash( const get_code_hash_params& params )const;
    get_abi_results get_abi( const get_abi_params& params )const;
+   /// the abi of the account as stored, a packed abi_def or empty
+   bytes get_abi_packed( const get_abi_params& params )const;
    get_raw_code_and_abi_results get_raw_code_and_abi( const get_raw_code_and_abi_params& params)const;
+   /// get_raw_code_and_abi_results packed with fc::raw
+   bytes get_raw_code_and_abi_packed( const get_raw_code_and_abi_params& params)const;
    get_raw_abi_results get_raw_abi( const get_raw_abi_params& params)const;
 
 
@@ -251,12 +260,19 @@ public:
    };
 
    fc::variant get_block(const get_block_params& params) const;
+   /// get_block as json, answered from the block response cache when the block is irreversible
+   string get_block_json(const get_block_params& params) const;
+   /// the block packed with fc::raw, for clients that accept application/octet-stream
+   bytes get_block_packed(const get_block_params& params) const;
+   /// adds the json and packed get_block responses of an irreversible block to the block response cache
+   void cache_irreversible_block(const chain::signed_block_ptr& block) const;
 
    struct get_block_header_state_params {
       string block_num_or_id;
    };
 
    fc::variant get_block_header_state(const get_block_header_state_params& params) const;
+   bytes get_block_header_state_packed(const get_block_header_state_params& params) const;
 
    struct get_table_rows_params {
       bool        json = false;
@@ -281,6 +297,19 @@ public:
 
    get_table_rows_result get_table_rows( const get_table_rows_params& params )const;
 
+   struct table_row_packed {
+      bytes                data;
+      name                 payer;
+   };
+
+   struct get_table_rows_packed_result {
+      vector<table_row_packed> rows; ///< the rows as stored, json and show_payer are ignored
+      bool                     more = false;
+   };
+
+   /// get_table_rows_packed_result packed with fc::raw
+   bytes get_table_rows_packed( const get_table_rows_params& params )const;
+
    struct get_table_by_scope_params {
       name        code; // mandatory
       name        table = 0; // optional, act as filter
@@ -389,15 +418,17 @@ public:
 
    static uint64_t get_table_index_name(const read_only::get_table_rows_params& p, bool& primary);
 
-   template <typename IndexType, typename SecKeyType, typename ConvFn>
-   read_only::get_table_rows_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, const abi_def& abi, ConvFn conv )const {
-      read_only::get_table_rows_result result;
+   /**
+    *  Calls on_row( data, payer ) for every row in the range requested by p, in the order of a secondary index, and
+    *  returns true if more rows follow.
+    */
+   template <typename IndexType, typename SecKeyType, typename ConvFn, typename RowFn>
+   bool walk_table_rows_by_seckey( const read_only::get_table_rows_params& p, ConvFn conv, RowFn&& on_row )const {
+      bool more = false;
       const auto& d = db.db();
 
       uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer_max_time);
       bool primary = false;
       const uint64_t table_with_index = get_table_index_name(p, primary);
       const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
@@ -437,7 +468,7 @@ public:
          }
 
          if( upper_bound_lookup_tuple < lower_bound_lookup_tuple )
-            return result;
+            return more;
 
          auto walk_table_row_range = [&]( auto itr, auto end_itr ) {
             auto cur_time = fc::time_point::now();
@@ -447,24 +478,12 @@ public:
                const auto* itr2 = d.find<chain::key_value_object, chain::by_scope_primary>( boost::make_tuple(t_id->id, itr->primary_key) );
                if( itr2 == nullptr ) continue;
                copy_inline_row(*itr2, data);
-
-               fc::variant data_var;
-               if( p.json ) {
-                  data_var = abis.binary_to_variant( abis.get_table_type(p.table), data, abi_serializer_max_time, shorten_abi_errors );
-               } else {
-                  data_var = fc::variant( data );
-               }
-
-               if( p.show_payer && *p.show_payer ) {
-                  result.rows.emplace_back( fc::mutable_variant_object("data", std::move(data_var))("payer", itr->payer) );
-               } else {
-                  result.rows.emplace_back( std::move(data_var) );
-               }
+               on_row( data, itr->payer );
 
                ++count;
             }
             if( itr != end_itr ) {
-               result.more = true;
+               more = true;
             }
          };
 
@@ -476,18 +495,20 @@ public:
             walk_table_row_range( lower, upper );
          }
       }
-      return result;
+      return more;
    }
 
-   template <typename IndexType>
-   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_def& abi )const {
-      read_only::get_table_rows_result result;
+   /**
+    *  Calls on_row( data, payer ) for every row in the range requested by p, in primary key order, and returns true
+    *  if more rows follow.
+    */
+   template <typename IndexType, typename RowFn>
+   bool walk_table_rows_ex( const read_only::get_table_rows_params& p, RowFn&& on_row )const {
+      bool more = false;
       const auto& d = db.db();
 
       uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer_max_time);
       const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
       if( t_id != nullptr ) {
          const auto& idx = d.get_index<IndexType, chain::by_scope_primary>();
@@ -515,7 +536,7 @@ public:
          }
 
          if( upper_bound_lookup_tuple < lower_bound_lookup_tuple  )
-            return result;
+            return more;
 
          auto walk_table_row_range = [&]( auto itr, auto end_itr ) {
             auto cur_time = fc::time_point::now();
@@ -523,22 +544,10 @@ public:
             vector<char> data;
             for( unsigned int count = 0; cur_time <= end_time && count < p.limit && itr != end_itr; ++count, ++itr, cur_time = fc::time_point::now() ) {
                copy_inline_row(*itr, data);
-
-               fc::variant data_var;
-               if( p.json ) {
-                  data_var = abis.binary_to_variant( abis.get_table_type(p.table), data, abi_serializer_max_time, shorten_abi_errors );
-               } else {
-                  data_var = fc::variant( data );
-               }
-
-               if( p.show_payer && *p.show_payer ) {
-                  result.rows.emplace_back( fc::mutable_variant_object("data", std::move(data_var))("payer", itr->payer) );
-               } else {
-                  result.rows.emplace_back( std::move(data_var) );
-               }
+               on_row( data, itr->payer );
             }
             if( itr != end_itr ) {
-               result.more = true;
+               more = true;
             }
          };
 
@@ -550,9 +559,13 @@ public:
             walk_table_row_range( lower, upper );
          }
       }
-      return result;
+      return more;
    }
 
+   /// dispatches p to the walker of the index and key type it requests
+   template <typename RowFn>
+   bool walk_table_rows( const read_only::get_table_rows_params& p, const abi_def& abi, RowFn&& on_row )const;
+
    chain::symbol extract_core_symbol()const;
 
    friend struct resolver_factory<read_only>;
@@ -657,7 +670,7 @@ public:
    void plugin_startup();
    void plugin_shutdown();
 
-   chain_apis::read_only get_read_only_api() const { return chain_apis::read_only(chain(), get_abi_serializer_max_time()); }
+   chain_apis::read_only get_read_only_api() const;
    chain_apis::read_write get_read_write_api() { return chain_apis::read_write(chain(), get_abi_serializer_max_time()); }
 
    void accept_block( const chain::signed_block_ptr& block );
@@ -710,6 +723,8 @@ FC_REFLECT( eosio::chain_apis::read_write::push_transaction_results, (transactio
 
 FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(key_type)(index_position)(encode_type)(reverse)(show_payer) )
 FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_result, (rows)(more) );
+FC_REFLECT( eosio::chain_apis::read_only::table_row_packed, (data)(payer) );
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_packed_result, (rows)(more) );
 
 FC_REFLECT( eosio::chain_apis::read_only::get_table_by_scope_params, (code)(table)(lower_bound)(upper_bound)(limit)(reverse) )
 FC_REFLECT( eosio::chain_apis::read_only::get_table_by_scope_result_row, (code)(scope)(table)(payer)(count));
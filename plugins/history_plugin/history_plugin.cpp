@@ -1,6 +1,7 @@
 #include <eosio/history_plugin/history_plugin.hpp>
 #include <eosio/history_plugin/account_control_history_object.hpp>
 #include <eosio/history_plugin/public_key_history_object.hpp>
+#include <eosio/history_plugin/history_log.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
@@ -8,8 +9,17 @@
 #include <fc/io/json.hpp>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/signals2/connection.hpp>
 
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace eosio {
    using namespace chain;
    using boost::signals2::scoped_connection;
@@ -17,68 +27,385 @@ namespace eosio {
    static appbase::abstract_plugin& _history_plugin = app().register_plugin<history_plugin>();
 
 
-   struct account_history_object : public chainbase::object<account_history_object_type, account_history_object>  {
-      OBJECT_CTOR( account_history_object );
+   /// a transaction with actions in the history, and those actions
+   struct transaction_history {
+      transaction_history_entry       trx;
+      vector<action_history_entry>    actions;
+   };
 
-      id_type      id;
-      account_name account; ///< the name of the account which has this action in its history
-      uint64_t     action_sequence_num = 0; ///< the sequence number of the relevant action (global)
-      int32_t      account_sequence_num = 0; ///< the sequence number for this account (per-account)
+   struct reversible_history_block {
+      block_id_type                  id;
+      uint32_t                       block_num = 0;
+      vector<transaction_history>    transactions;
    };
 
-   struct action_history_object : public chainbase::object<action_history_object_type, action_history_object> {
+} /// namespace eosio
+
+FC_REFLECT( eosio::transaction_history, (trx)(actions) )
+FC_REFLECT( eosio::reversible_history_block, (id)(block_num)(transactions) )
+
+namespace eosio {
+
+   /**
+    *  The action history of irreversible blocks, kept out of chainbase in append-only logs (actions.log and
+    *  transactions.log) with sorted index files.
+    *
+    *  Blocks are written by a background thread in the order they become irreversible. The transactions written since
+    *  the last index files are kept in memory, and are written as a new pair of sorted index files once they have
+    *  index_batch_size actions. Index files are merged with their predecessor while it is not larger, so a lookup
+    *  searches a logarithmic number of files. Lookups are made from the main thread.
+    */
+   class history_store {
+      public:
+         using entry_ptr       = std::shared_ptr<const action_history_entry>;
+         using transaction_ptr = std::shared_ptr<const transaction_history>;
+
+         history_store( const bfs::path& dir, uint32_t index_batch_size );
+         ~history_store();
+
+         /// the last block appended, whose history is stored
+         uint32_t last_block()const { return _last_block; }
+
+         /// the last block whose history the writer has committed; it trails last_block() while blocks are queued
+         uint32_t last_committed_block()const { return committed_block_num; }
+
+         /// stores the history of the next irreversible block
+         void append_block( uint32_t block_num, const block_id_type& id, vector<transaction_ptr> transactions );
+
+         /// writes the remaining index entries and waits for the writer to finish
+         void close();
 
-      OBJECT_CTOR( action_history_object, (packed_action_trace) );
+         optional<int32_t> last_account_sequence( account_name account )const;
 
-      id_type      id;
-      uint64_t     action_sequence_num; ///< the sequence number of the relevant action
+         /// calls f(account_sequence_num, entry) for the actions of account in [first, last], until f returns false
+         template<typename F>
+         bool for_each_account_action( account_name account, int32_t first, int32_t last, F&& f )const;
 
-      shared_string        packed_action_trace;
-      uint32_t             block_num;
-      block_timestamp_type block_time;
-      transaction_id_type  trx_id;
+         /// the stored transaction with the least id which matches prefix
+         optional<transaction_history> find_transaction( const transaction_id_prefix& prefix )const;
+
+         /// the entries of a transaction's actions, each sharing ownership of the transaction
+         static vector<entry_ptr> actions_of( const transaction_ptr& t ) {
+            vector<entry_ptr> result;
+            for( const auto& a : t->actions )
+               result.emplace_back( t, &a ); // shares ownership of the transaction
+            return result;
+         }
+
+      private:
+         struct index_files {
+            uint32_t                                      begin = 0; ///< of the blocks indexed
+            uint32_t                                      end   = 0;
+            history_index_file<account_index_entry>       accounts;
+            history_index_file<transaction_index_entry>   transactions;
+
+            index_files( const bfs::path& dir, uint32_t begin, uint32_t end )
+            :begin(begin), end(end)
+            ,accounts( name( dir, begin, end, "accounts" ) )
+            ,transactions( name( dir, begin, end, "transactions" ) ) {}
+
+            static string name( const bfs::path& dir, uint32_t begin, uint32_t end, const char* kind ) {
+               return (dir / ("index-" + std::to_string(begin) + "-" + std::to_string(end) + "." + kind)).string();
+            }
+
+            void remove() {
+               accounts.remove();
+               transactions.remove();
+            }
+         };
+         using index_files_ptr = std::shared_ptr<index_files>;
+
+         void open_index_files( uint32_t end_block );
+         void add_recent( const transaction_ptr& t );
+         void add_unindexed( uint64_t pos, const transaction_history_entry& trx, const vector<action_history_entry>& actions );
+         void write_block( uint32_t block_num, const block_id_type& id, const vector<transaction_ptr>& transactions );
+         void write_index_files();
+         void merge_index_files();
+         template<typename F>
+         void run_on_writer( F&& f );
+
+         const bfs::path                                dir;
+         const uint32_t                                 index_batch_size;
+         // appended to by the writer, read by lookups through a separate stream
+         mutable history_log<action_history_entry>        actions_log;
+         mutable history_log<transaction_history_entry>   transactions_log;
+         uint32_t                                       _last_block = 0;
+
+         mutable std::mutex                                    mtx;
+         vector<index_files_ptr>                               files;               ///< guarded by mtx, oldest first
+         std::map<std::pair<uint64_t,int32_t>, entry_ptr>     recent_by_account;   ///< guarded by mtx
+         std::map<transaction_id_type, transaction_ptr>       recent_transactions; ///< guarded by mtx
+         std::atomic<uint32_t>                                 committed_block_num{0}; ///< written only by the writer
+
+         // used only by the writer
+         vector<account_index_entry>         unindexed_accounts;
+         vector<transaction_index_entry>     unindexed_transactions;
+         vector<transaction_id_type>         unindexed_ids;
+         uint32_t                            unindexed_begin = 0; ///< the first block not in an index file
+
+         optional<boost::asio::thread_pool>  writer;
    };
-   using account_history_id_type = account_history_object::id_type;
-   using action_history_id_type  = action_history_object::id_type;
-
-
-   struct by_action_sequence_num;
-   struct by_account_action_seq;
-   struct by_trx_id;
-
-   using action_history_index = chainbase::shared_multi_index_container<
-      action_history_object,
-      indexed_by<
-         ordered_unique<tag<by_id>, member<action_history_object, action_history_object::id_type, &action_history_object::id>>,
-         ordered_unique<tag<by_action_sequence_num>, member<action_history_object, uint64_t, &action_history_object::action_sequence_num>>,
-         ordered_unique<tag<by_trx_id>,
-            composite_key< action_history_object,
-               member<action_history_object, transaction_id_type, &action_history_object::trx_id>,
-               member<action_history_object, uint64_t, &action_history_object::action_sequence_num >
-            >
-         >
-      >
-   >;
-
-   using account_history_index = chainbase::shared_multi_index_container<
-      account_history_object,
-      indexed_by<
-         ordered_unique<tag<by_id>, member<account_history_object, account_history_object::id_type, &account_history_object::id>>,
-         ordered_unique<tag<by_account_action_seq>,
-            composite_key< account_history_object,
-               member<account_history_object, account_name, &account_history_object::account >,
-               member<account_history_object, int32_t, &account_history_object::account_sequence_num >
-            >
-         >
-      >
-   >;
 
-} /// namespace eosio
+   struct committed_block {
+      uint32_t       block_num = 0;
+      block_id_type  id;
+   };
 
-CHAINBASE_SET_INDEX_TYPE(eosio::account_history_object, eosio::account_history_index)
-CHAINBASE_SET_INDEX_TYPE(eosio::action_history_object, eosio::action_history_index)
+   history_store::history_store( const bfs::path& dir, uint32_t index_batch_size )
+   :dir(dir), index_batch_size(index_batch_size)
+   ,actions_log( "actions", (dir / "actions.log").string() )
+   ,transactions_log( "transactions", (dir / "transactions.log").string() ) {
+      committed_block head;
+      if( bfs::exists( dir / "actions.head" ) ) {
+         std::ifstream in( (dir / "actions.head").string(), std::ios_base::binary );
+         in.read( (char*)&head, sizeof(head) );
+      }
+      _last_block = committed_block_num = head.block_num;
+      actions_log.truncate_after_block( _last_block );
+      transactions_log.truncate_after_block( _last_block );
+
+      open_index_files( _last_block + 1 );
+      unindexed_begin = files.empty() ? 0 : files.back()->end;
+      auto begin = unindexed_begin ? transactions_log.end_of_block( unindexed_begin - 1 ) : 0;
+      transactions_log.for_each( begin, transactions_log.size(), [&]( uint64_t pos, transaction_history_entry&& trx ) {
+         auto t = std::make_shared<transaction_history>();
+         for( auto action_pos : trx.action_positions )
+            t->actions.push_back( actions_log.read( action_pos ) );
+         t->trx = std::move( trx );
+         add_unindexed( pos, t->trx, t->actions );
+         add_recent( t );
+      });
+      ilog( "history has blocks up to ${b}, ${n} index files", ("b", _last_block)("n", files.size()) );
+
+      writer.emplace( 1 );
+   }
 
-namespace eosio {
+   history_store::~history_store() {
+      close();
+   }
+
+   /// keeps the index files which cover the blocks before end_block from the first without gaps, and removes the rest
+   void history_store::open_index_files( uint32_t end_block ) {
+      vector<std::pair<uint32_t,uint32_t>> found;
+      for( bfs::directory_iterator itr( dir ); itr != bfs::directory_iterator(); ++itr ) {
+         auto filename = itr->path().filename().string();
+         vector<string> parts;
+         boost::split( parts, filename, boost::is_any_of( "-." ) );
+         if( parts.size() == 4 && parts[0] == "index" && parts[3] == "accounts" ) {
+            uint32_t begin = std::stoul( parts[1] );
+            uint32_t end = std::stoul( parts[2] );
+            if( bfs::exists( index_files::name( dir, begin, end, "transactions" ) ) )
+               found.emplace_back( begin, end );
+         } else if( parts.size() == 5 && parts[0] == "index" && parts[4] == "tmp" ) {
+            bfs::remove( itr->path() );
+         }
+      }
+      // a merge leaves the merged files behind when the node stops before removing them; the longest range is kept
+      std::sort( found.begin(), found.end(), []( const auto& a, const auto& b ) {
+         return a.first < b.first || (a.first == b.first && a.second > b.second);
+      });
+      uint32_t covered = 0;
+      for( const auto& f : found ) {
+         if( f.first == covered && f.second <= end_block ) {
+            files.push_back( std::make_shared<index_files>( dir, f.first, f.second ) );
+            covered = f.second;
+         } else {
+            index_files( dir, f.first, f.second ).remove();
+         }
+      }
+   }
+
+   void history_store::add_recent( const transaction_ptr& t ) {
+      for( const auto& e : actions_of( t ) ) {
+         for( const auto& a : e->accounts )
+            recent_by_account[std::make_pair( a.account.value, a.account_sequence_num )] = e;
+      }
+      recent_transactions[t->trx.id] = t;
+   }
+
+   void history_store::add_unindexed( uint64_t pos, const transaction_history_entry& trx, const vector<action_history_entry>& actions ) {
+      for( size_t i = 0; i < actions.size(); ++i ) {
+         for( const auto& a : actions[i].accounts )
+            unindexed_accounts.push_back( {a.account.value, a.account_sequence_num, trx.block_num, trx.action_positions[i]} );
+      }
+      unindexed_transactions.push_back( {transaction_index_entry::prefix_of( trx.id ), pos, trx.block_num} );
+      unindexed_ids.push_back( trx.id );
+   }
+
+   template<typename F>
+   void history_store::run_on_writer( F&& f ) {
+      boost::asio::post( *writer, [f{std::forward<F>( f )}]() {
+         try {
+            f();
+         } catch( const fc::exception& e ) {
+            elog( "unable to write history: ${e}", ("e", e.to_detail_string()) );
+            app().get_io_service().post( []() { app().quit(); } );
+         } catch( const std::exception& e ) {
+            elog( "unable to write history: ${e}", ("e", e.what()) );
+            app().get_io_service().post( []() { app().quit(); } );
+         }
+      });
+   }
+
+   void history_store::append_block( uint32_t block_num, const block_id_type& id, vector<transaction_ptr> transactions ) {
+      _last_block = block_num;
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         for( const auto& t : transactions )
+            add_recent( t );
+      }
+      run_on_writer( [this, block_num, id, transactions{std::move( transactions )}]() {
+         write_block( block_num, id, transactions );
+      });
+   }
+
+   void history_store::close() {
+      if( !writer ) return;
+      run_on_writer( [this]() { write_index_files(); } );
+      writer->join();
+      writer.reset();
+   }
+
+   void history_store::write_block( uint32_t block_num, const block_id_type& id, const vector<transaction_ptr>& transactions ) {
+      for( const auto& t : transactions ) {
+         auto trx = t->trx;
+         trx.action_positions.clear();
+         for( const auto& a : t->actions )
+            trx.action_positions.push_back( actions_log.append( a ) );
+         add_unindexed( transactions_log.append( trx ), trx, t->actions );
+      }
+      actions_log.flush();
+      transactions_log.flush();
+
+      // the block is committed once actions.head names it; entries of later blocks are removed on startup
+      committed_block head{block_num, id};
+      auto tmp = (dir / "actions.head.tmp").string();
+      {
+         std::ofstream out( tmp, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc );
+         out.write( (const char*)&head, sizeof(head) );
+      }
+      bfs::rename( tmp, dir / "actions.head" );
+      committed_block_num = block_num;
+
+      if( unindexed_accounts.size() >= index_batch_size )
+         write_index_files();
+   }
+
+   void history_store::write_index_files() {
+      if( unindexed_transactions.empty() ) return;
+      const uint32_t end = committed_block_num + 1;
+      std::sort( unindexed_accounts.begin(), unindexed_accounts.end() );
+      std::sort( unindexed_transactions.begin(), unindexed_transactions.end() );
+      history_index_file<account_index_entry>::write( index_files::name( dir, unindexed_begin, end, "accounts" ), unindexed_accounts );
+      history_index_file<transaction_index_entry>::write( index_files::name( dir, unindexed_begin, end, "transactions" ), unindexed_transactions );
+      auto f = std::make_shared<index_files>( dir, unindexed_begin, end );
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         files.push_back( f );
+         for( const auto& a : unindexed_accounts )
+            recent_by_account.erase( std::make_pair( a.account, a.account_sequence_num ) );
+         for( const auto& id : unindexed_ids )
+            recent_transactions.erase( id );
+      }
+      unindexed_accounts.clear();
+      unindexed_transactions.clear();
+      unindexed_ids.clear();
+      unindexed_begin = end;
+      merge_index_files();
+   }
+
+   void history_store::merge_index_files() {
+      while( true ) {
+         index_files_ptr a, b;
+         {
+            std::lock_guard<std::mutex> g( mtx );
+            if( files.size() < 2 || files[files.size() - 2]->accounts.size() > files.back()->accounts.size() )
+               return;
+            a = files[files.size() - 2];
+            b = files.back();
+         }
+         history_index_file<account_index_entry>::merge( index_files::name( dir, a->begin, b->end, "accounts" ), a->accounts, b->accounts );
+         history_index_file<transaction_index_entry>::merge( index_files::name( dir, a->begin, b->end, "transactions" ), a->transactions, b->transactions );
+         auto merged = std::make_shared<index_files>( dir, a->begin, b->end );
+         {
+            std::lock_guard<std::mutex> g( mtx );
+            files.pop_back();
+            files.back() = merged;
+         }
+         a->remove();
+         b->remove();
+      }
+   }
+
+   optional<int32_t> history_store::last_account_sequence( account_name account )const {
+      std::lock_guard<std::mutex> g( mtx );
+      auto itr = recent_by_account.lower_bound( std::make_pair( account.value + 1, 0 ) );
+      if( itr != recent_by_account.begin() && (--itr)->first.first == account.value )
+         return itr->first.second;
+      for( auto f = files.rbegin(); f != files.rend(); ++f ) {
+         auto i = (*f)->accounts.lower_bound( {account.value + 1, 0} );
+         if( i == 0 ) continue;
+         auto e = (*f)->accounts.at( i - 1 );
+         if( e.account == account.value )
+            return e.account_sequence_num;
+      }
+      return {};
+   }
+
+   template<typename F>
+   bool history_store::for_each_account_action( account_name account, int32_t first, int32_t last, F&& f )const {
+      std::lock_guard<std::mutex> g( mtx );
+      for( const auto& file : files ) {
+         for( auto i = file->accounts.lower_bound( {account.value, first} ); i < file->accounts.size(); ++i ) {
+            auto e = file->accounts.at( i );
+            if( e.account != account.value || e.account_sequence_num > last )
+               break;
+            if( !f( e.account_sequence_num, actions_log.read( e.pos ) ) )
+               return false;
+         }
+      }
+      for( auto itr = recent_by_account.lower_bound( std::make_pair( account.value, first ) );
+           itr != recent_by_account.end() && itr->first.first == account.value && itr->first.second <= last; ++itr ) {
+         if( !f( itr->first.second, *itr->second ) )
+            return false;
+      }
+      return true;
+   }
+
+   optional<transaction_history> history_store::find_transaction( const transaction_id_prefix& prefix )const {
+      std::lock_guard<std::mutex> g( mtx );
+      optional<transaction_history> result;
+      auto itr = recent_transactions.lower_bound( prefix.id );
+      if( itr != recent_transactions.end() && prefix.matches( itr->first ) )
+         result = *itr->second;
+
+      // the index narrows the candidates to those sharing the first 8 bytes, each read directly from transactions.log
+      optional<transaction_history_entry> stored;
+      for( const auto& file : files ) {
+         for( auto i = file->transactions.lower_bound( {transaction_index_entry::prefix_of( prefix.id )} ); i < file->transactions.size(); ++i ) {
+            auto e = file->transactions.at( i );
+            if( !prefix.matches_index_prefix( e.id_prefix ) )
+               break;
+            auto trx = transactions_log.read( e.pos );
+            if( prefix.matches( trx.id ) && (!stored || trx.id < stored->id) )
+               stored = std::move( trx );
+         }
+      }
+      if( stored && (!result || stored->id < result->trx.id) ) {
+         result.emplace();
+         for( auto pos : stored->action_positions )
+            result->actions.push_back( actions_log.read( pos ) );
+         result->trx = std::move( *stored );
+      }
+      return result;
+   }
+
+   /// the history of a reversible block, which a fork may still replace
+   struct reversible_history {
+      block_id_type                                 id;
+      vector<history_store::transaction_ptr>        transactions;
+      vector<std::pair<account_name,int32_t>>       previous_sequences; ///< of the accounts whose sequence numbers the block took
+   };
 
    template<typename MultiIndex, typename LookupType>
    static void remove(chainbase::database& db, const account_name& account_name, const permission_name& permission)
@@ -135,94 +462,132 @@ namespace eosio {
       }
    };
 
+   /// the filter-on and filter-out entries which apply to one receiver and action, with the blank action resolved
+   struct filter_rule {
+      bool                          on_all  = false; ///< every actor is tracked
+      bool                          out_all = false; ///< no actor is tracked
+      std::unordered_set<uint64_t>  on_actors;
+      std::unordered_set<uint64_t>  out_actors;
+
+      void add( const filter_entry& fe, bool filter_on ) {
+         if( fe.actor.value == 0 )
+            (filter_on ? on_all : out_all) = true;
+         else
+            (filter_on ? on_actors : out_actors).insert( fe.actor.value );
+      }
+
+      bool on( account_name actor )const  { return on_all || (!on_actors.empty() && on_actors.count( actor.value )); }
+      bool out( account_name actor )const { return out_all || (!out_actors.empty() && out_actors.count( actor.value )); }
+   };
+
+   /**
+    *  filter-on and filter-out compiled at startup into hash lookups, so that matching an action trace takes two
+    *  lookups plus at most two per authorization, however many entries are configured.
+    */
+   struct compiled_filter {
+      struct receiver_rules {
+         filter_rule                                  any_action; ///< for actions without entries of their own
+         std::unordered_map<uint64_t, filter_rule>    actions;    ///< include the entries for any action
+      };
+      std::unordered_map<uint64_t, receiver_rules>    receivers;
+
+      compiled_filter() = default;
+      compiled_filter( const std::set<filter_entry>& filter_on, const std::set<filter_entry>& filter_out ) {
+         // entries for a receiver's every action are added first, so each action's rule can start from them
+         for( bool any_action : {true, false} ) {
+            for( bool on : {true, false} ) {
+               for( const auto& fe : on ? filter_on : filter_out ) {
+                  if( (fe.action.value == 0) != any_action )
+                     continue;
+                  auto& r = receivers[fe.receiver.value];
+                  if( any_action ) {
+                     r.any_action.add( fe, on );
+                  } else {
+                     r.actions.emplace( fe.action.value, r.any_action ).first->second.add( fe, on );
+                  }
+               }
+            }
+         }
+      }
+
+      /// the rule for an action, or nullptr when no entry names its receiver
+      const filter_rule* find( account_name receiver, action_name action )const {
+         auto r = receivers.find( receiver.value );
+         if( r == receivers.end() )
+            return nullptr;
+         auto a = r->second.actions.find( action.value );
+         return a != r->second.actions.end() ? &a->second : &r->second.any_action;
+      }
+   };
+
    class history_plugin_impl {
       public:
          bool bypass_filter = false;
          std::set<filter_entry> filter_on;
          std::set<filter_entry> filter_out;
+         compiled_filter        filters;
          chain_plugin*          chain_plug = nullptr;
+         fc::optional<scoped_connection> accepted_transaction_connection;
          fc::optional<scoped_connection> applied_transaction_connection;
-
-          bool filter(const action_trace& act) {
-            bool pass_on = false;
-            if (bypass_filter) {
-              pass_on = true;
-            }
-            if (filter_on.find({ act.receipt.receiver, 0, 0 }) != filter_on.end()) {
-              pass_on = true;
-            }
-            if (filter_on.find({ act.receipt.receiver, act.act.name, 0 }) != filter_on.end()) {
-              pass_on = true;
-            }
-            for (const auto& a : act.act.authorization) {
-              if (filter_on.find({ act.receipt.receiver, 0, a.actor }) != filter_on.end()) {
-                pass_on = true;
-              }
-              if (filter_on.find({ act.receipt.receiver, act.act.name, a.actor }) != filter_on.end()) {
-                pass_on = true;
-              }
+         fc::optional<scoped_connection> accepted_block_connection;
+         fc::optional<scoped_connection> irreversible_block_connection;
+
+         bfs::path                       history_dir;
+         uint32_t                        index_batch_size = 65536;
+         optional<history_store>         store;
+
+         std::map<transaction_id_type, transaction_trace_ptr>          cached_traces;
+         transaction_trace_ptr                                         onblock_trace;
+         vector<transaction_trace_ptr>                                 implicit_traces; ///< of the recurring actions, in order
+         std::set<transaction_id_type>                                 implicit_ids;
+         std::map<uint32_t, reversible_history>                        reversible_blocks;
+         std::map<std::pair<uint64_t,int32_t>, history_store::entry_ptr>             reversible_by_account;
+         std::map<transaction_id_type, history_store::transaction_ptr>               reversible_transactions;
+         std::map<account_name, int32_t>                               next_account_sequence; ///< as of the head block
+         std::ofstream                                                 reversible_log;
+         uint32_t                                                      reversible_log_kept = 0;     ///< records when last rewritten
+         uint32_t                                                      reversible_log_appended = 0; ///< records appended since
+
+         bool filter(const action_trace& act) {
+            const filter_rule* rule = filters.find( act.receipt.receiver, act.act.name );
+            if( !rule )
+               return bypass_filter;
+
+            bool pass_on = bypass_filter || rule->on_all;
+            for( const auto& a : act.act.authorization ) {
+               if( pass_on ) break;
+               pass_on = rule->on( a.actor );
             }
+            if( !pass_on ) return false;
 
-            if (!pass_on) {  return false;  }
-
-            if (filter_out.find({ act.receipt.receiver, 0, 0 }) != filter_out.end()) {
-              return false;
-            }
-            if (filter_out.find({ act.receipt.receiver, act.act.name, 0 }) != filter_out.end()) {
-              return false;
-            }
-            for (const auto& a : act.act.authorization) {
-              if (filter_out.find({ act.receipt.receiver, 0, a.actor }) != filter_out.end()) {
-                return false;
-              }
-              if (filter_out.find({ act.receipt.receiver, act.act.name, a.actor }) != filter_out.end()) {
-                return false;
-              }
+            if( rule->out_all ) return false;
+            for( const auto& a : act.act.authorization ) {
+               if( rule->out( a.actor ) ) return false;
             }
-
             return true;
-          }
+         }
 
          set<account_name> account_set( const action_trace& act ) {
             set<account_name> result;
 
             result.insert( act.receipt.receiver );
+            const filter_rule* rule = filters.find( act.receipt.receiver, act.act.name );
             for( const auto& a : act.act.authorization ) {
-               if( bypass_filter ||
-                   filter_on.find({ act.receipt.receiver, 0, 0}) != filter_on.end() ||
-                   filter_on.find({ act.receipt.receiver, 0, a.actor}) != filter_on.end() ||
-                   filter_on.find({ act.receipt.receiver, act.act.name, 0}) != filter_on.end() ||
-                   filter_on.find({ act.receipt.receiver, act.act.name, a.actor }) != filter_on.end() ) {
-                 if ((filter_out.find({ act.receipt.receiver, 0, 0 }) == filter_out.end()) &&
-                     (filter_out.find({ act.receipt.receiver, 0, a.actor }) == filter_out.end()) &&
-                     (filter_out.find({ act.receipt.receiver, act.act.name, 0 }) == filter_out.end()) &&
-                     (filter_out.find({ act.receipt.receiver, act.act.name, a.actor }) == filter_out.end())) {
-                   result.insert( a.actor );
-                 }
-               }
+               if( rule ? (bypass_filter || rule->on( a.actor )) && !rule->out( a.actor ) : bypass_filter )
+                  result.insert( a.actor );
             }
             return result;
          }
 
-         void record_account_action( account_name n, const base_action_trace& act ) {
-            auto& chain = chain_plug->chain();
-            chainbase::database& db = const_cast<chainbase::database&>( chain.db() ); // Override read-only access to state DB (highly unrecommended practice!)
-
-            const auto& idx = db.get_index<account_history_index, by_account_action_seq>();
-            auto itr = idx.lower_bound( boost::make_tuple( name(n.value+1), 0 ) );
-
-            uint64_t asn = 0;
-            if( itr != idx.begin() ) --itr;
-            if( itr->account == n )
-               asn = itr->account_sequence_num + 1;
-
-            //idump((n)(act.receipt.global_sequence)(asn));
-            const auto& a = db.create<account_history_object>( [&]( auto& aho ) {
-              aho.account = n;
-              aho.action_sequence_num = act.receipt.global_sequence;
-              aho.account_sequence_num = asn;
-            });
-            //idump((a.account)(a.action_sequence_num)(a.action_sequence_num));
+         /// the sequence number of the next action of account, recording its previous value so that a fork can undo it
+         int32_t next_sequence( account_name n, reversible_history& block ) {
+            auto itr = next_account_sequence.find( n );
+            if( itr == next_account_sequence.end() ) {
+               auto last = store->last_account_sequence( n );
+               itr = next_account_sequence.emplace( n, last ? *last + 1 : 0 ).first;
+            }
+            block.previous_sequences.emplace_back( n, itr->second );
+            return itr->second++;
          }
 
          void on_system_action( const action_trace& at ) {
@@ -252,43 +617,270 @@ namespace eosio {
             }
          }
 
-         void on_action_trace( const action_trace& at ) {
+         void on_system_actions( const action_trace& at ) {
+            if( at.receipt.receiver == chain::config::system_account_name )
+               on_system_action( at );
+            for( const auto& iline : at.inline_traces ) {
+               on_system_actions( iline );
+            }
+         }
+
+         void record_action_trace( const action_trace& at, const block_state_ptr& bs, transaction_history& trx, reversible_history& block ) {
             if( filter( at ) ) {
-               //idump((fc::json::to_pretty_string(at)));
-               auto& chain = chain_plug->chain();
-               chainbase::database& db = const_cast<chainbase::database&>( chain.db() ); // Override read-only access to state DB (highly unrecommended practice!)
-
-               db.create<action_history_object>( [&]( auto& aho ) {
-                  auto ps = fc::raw::pack_size( at );
-                  aho.packed_action_trace.resize(ps);
-                  datastream<char*> ds( aho.packed_action_trace.data(), ps );
-                  fc::raw::pack( ds, at );
-                  aho.action_sequence_num = at.receipt.global_sequence;
-                  aho.block_num = chain.pending_block_state()->block_num;
-                  aho.block_time = chain.pending_block_time();
-                  aho.trx_id     = at.trx_id;
-               });
-
-               auto aset = account_set( at );
-               for( auto a : aset ) {
-                  record_account_action( a, at );
+               action_history_entry entry;
+               entry.global_sequence = at.receipt.global_sequence;
+               entry.block_num = bs->block_num;
+               entry.block_time = bs->header.timestamp;
+               entry.trx_id = at.trx_id;
+               entry.packed_action_trace = fc::raw::pack( at );
+               for( auto a : account_set( at ) ) {
+                  entry.accounts.push_back( {a, next_sequence( a, block )} );
                }
+               trx.actions.push_back( std::move( entry ) );
             }
-            if( at.receipt.receiver == chain::config::system_account_name )
-               on_system_action( at );
             for( const auto& iline : at.inline_traces ) {
-               on_action_trace( iline );
+               record_action_trace( iline, bs, trx, block );
             }
          }
 
+         static bool is_onblock( const transaction_trace_ptr& p ) {
+            if( p->action_traces.size() != 1 )
+               return false;
+            const auto& act = p->action_traces[0].act;
+            return act.account == chain::config::system_account_name && act.name == N(onblock);
+         }
+
+         /// the key and controlled account indexes are in chainbase, so they are updated as the transaction applies
          void on_applied_transaction( const transaction_trace_ptr& trace ) {
             if( !trace->receipt || (trace->receipt->status != transaction_receipt_header::executed &&
                   trace->receipt->status != transaction_receipt_header::soft_fail) )
                return;
             for( const auto& atrace : trace->action_traces ) {
-               on_action_trace( atrace );
+               on_system_actions( atrace );
+            }
+            if( is_onblock( trace ) ) {
+               // onblock starts each pending block, so traces of the implicit transactions of an aborted one are dropped
+               onblock_trace = trace;
+               implicit_traces.clear();
+               implicit_ids.clear();
+            } else if( implicit_ids.erase( trace->id ) ) {
+               implicit_traces.push_back( trace );
+            } else if( trace->failed_dtrx_trace ) {
+               cached_traces[trace->failed_dtrx_trace->id] = trace;
+            } else {
+               cached_traces[trace->id] = trace;
+            }
+         }
+
+         /// implicit transactions other than onblock, such as recurring actions, have no receipt in the block
+         void on_accepted_transaction( const transaction_metadata_ptr& trx ) {
+            if( trx->implicit )
+               implicit_ids.insert( trx->id );
+         }
+
+         /// removes the blocks from block_num on, undoing the account sequence numbers they took
+         void pop_reversible_blocks( uint32_t block_num ) {
+            while( !reversible_blocks.empty() && reversible_blocks.rbegin()->first >= block_num ) {
+               auto& block = reversible_blocks.rbegin()->second;
+               for( auto p = block.previous_sequences.rbegin(); p != block.previous_sequences.rend(); ++p )
+                  next_account_sequence[p->first] = p->second;
+               remove_reversible( block );
+               reversible_blocks.erase( std::prev( reversible_blocks.end() ) );
+            }
+         }
+
+         void add_reversible( const reversible_history& block ) {
+            for( const auto& t : block.transactions ) {
+               for( const auto& e : history_store::actions_of( t ) ) {
+                  for( const auto& a : e->accounts )
+                     reversible_by_account[std::make_pair( a.account.value, a.account_sequence_num )] = e;
+               }
+               reversible_transactions[t->trx.id] = t;
+            }
+         }
+
+         void remove_reversible( const reversible_history& block ) {
+            for( const auto& t : block.transactions ) {
+               for( const auto& e : t->actions ) {
+                  for( const auto& a : e.accounts )
+                     reversible_by_account.erase( std::make_pair( a.account.value, a.account_sequence_num ) );
+               }
+               reversible_transactions.erase( t->trx.id );
             }
          }
+
+         void on_accepted_block( const block_state_ptr& bs ) {
+            vector<std::pair<transaction_trace_ptr, const transaction_receipt*>> traces;
+            if( onblock_trace )
+               traces.emplace_back( onblock_trace, nullptr );
+            for( const auto& t : implicit_traces )
+               traces.emplace_back( t, nullptr );
+            for( const auto& r : bs->block->transactions ) {
+               transaction_id_type id;
+               if( r.trx.contains<transaction_id_type>() )
+                  id = r.trx.get<transaction_id_type>();
+               else
+                  id = r.trx.get<packed_transaction>().id();
+               auto itr = cached_traces.find( id );
+               if( itr != cached_traces.end() )
+                  traces.emplace_back( itr->second, &r );
+            }
+            cached_traces.clear();
+            onblock_trace.reset();
+            implicit_traces.clear();
+            implicit_ids.clear();
+
+            if( bs->block_num <= store->last_block() ) // replayed
+               return;
+
+            pop_reversible_blocks( bs->block_num ); // a fork switch replaces the blocks from here on
+            reversible_history block;
+            block.id = bs->id;
+            for( const auto& trace : traces ) {
+               auto trx = std::make_shared<transaction_history>();
+               trx->trx.id = trace.first->failed_dtrx_trace ? trace.first->failed_dtrx_trace->id : trace.first->id;
+               trx->trx.block_num = bs->block_num;
+               trx->trx.block_time = bs->header.timestamp;
+               if( trace.second )
+                  trx->trx.receipt = *trace.second;
+               for( const auto& atrace : trace.first->action_traces ) {
+                  record_action_trace( atrace, bs, *trx, block );
+               }
+               if( !trx->actions.empty() )
+                  block.transactions.push_back( std::move( trx ) );
+            }
+            add_reversible( block );
+            append_reversible_log( bs->block_num, block );
+            reversible_blocks.emplace( bs->block_num, std::move( block ) );
+         }
+
+         void on_irreversible_block( const block_state_ptr& bs ) {
+            if( bs->block_num <= store->last_block() )
+               return;
+            // blocks restored from reversible.log may have become irreversible before the node stopped, in which case
+            // they get no signal of their own
+            auto& chain = chain_plug->chain();
+            while( !reversible_blocks.empty() && reversible_blocks.begin()->first < bs->block_num ) {
+               auto& b = *reversible_blocks.begin();
+               if( b.first > store->last_block() ) {
+                  auto blk = chain.fetch_block_by_number( b.first );
+                  if( blk && blk->id() == b.second.id )
+                     store->append_block( b.first, b.second.id, b.second.transactions );
+               }
+               remove_reversible( b.second );
+               reversible_blocks.erase( reversible_blocks.begin() );
+            }
+            vector<history_store::transaction_ptr> transactions;
+            auto itr = reversible_blocks.find( bs->block_num );
+            if( itr != reversible_blocks.end() && itr->second.id == bs->id ) {
+               transactions = itr->second.transactions;
+            } else {
+               wlog( "no history recorded for irreversible block ${n}", ("n", bs->block_num) );
+            }
+            // handed to the store before being removed here, so lookups always find them in one or the other
+            store->append_block( bs->block_num, bs->id, std::move( transactions ) );
+            while( !reversible_blocks.empty() && reversible_blocks.begin()->first <= bs->block_num ) {
+               remove_reversible( reversible_blocks.begin()->second );
+               reversible_blocks.erase( reversible_blocks.begin() );
+            }
+            if( reversible_log_appended > reversible_log_kept + 64 )
+               rewrite_reversible_log( read_reversible_log() );
+         }
+
+         /**
+          *  The history of each accepted block is appended to reversible.log as it is accepted, so that it survives a
+          *  crash. A record replaces those of its block number and later, as the fork switch which produced it did. The
+          *  log is rewritten without the blocks the store has committed once most of its records are superseded.
+          */
+         void append_reversible_log( uint32_t block_num, const reversible_history& block ) {
+            reversible_history_block saved{block.id, block_num, {}};
+            for( const auto& t : block.transactions )
+               saved.transactions.push_back( *t );
+            write_reversible_record( reversible_log, saved );
+            reversible_log.flush();
+            ++reversible_log_appended;
+         }
+
+         static void write_reversible_record( std::ostream& out, const reversible_history_block& block ) {
+            auto data = fc::raw::pack( block );
+            const uint32_t size = data.size();
+            out.write( (const char*)&size, sizeof(size) );
+            out.write( data.data(), data.size() );
+         }
+
+         /// the blocks of reversible.log which its last record leaves on the chain; a record cut short is ignored
+         std::map<uint32_t, reversible_history_block> read_reversible_log()const {
+            std::map<uint32_t, reversible_history_block> result;
+            const auto path = history_dir / "reversible.log";
+            if( !bfs::exists( path ) ) return result;
+            bytes data( bfs::file_size( path ) );
+            {
+               std::ifstream in( path.string(), std::ios_base::binary );
+               in.read( data.data(), data.size() );
+            }
+            size_t pos = 0;
+            while( data.size() - pos >= sizeof(uint32_t) ) {
+               uint32_t size;
+               memcpy( &size, data.data() + pos, sizeof(size) );
+               pos += sizeof(size);
+               if( data.size() - pos < size )
+                  break;
+               reversible_history_block block;
+               fc::datastream<const char*> ds( data.data() + pos, size );
+               fc::raw::unpack( ds, block );
+               pos += size;
+               result.erase( result.lower_bound( block.block_num ), result.end() );
+               result.emplace( block.block_num, std::move( block ) );
+            }
+            return result;
+         }
+
+         void rewrite_reversible_log( std::map<uint32_t, reversible_history_block> saved ) {
+            saved.erase( saved.begin(), saved.upper_bound( store->last_committed_block() ) );
+            const auto path = history_dir / "reversible.log";
+            const auto tmp = history_dir / "reversible.log.tmp";
+            {
+               std::ofstream out( tmp.string(), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc );
+               for( const auto& b : saved )
+                  write_reversible_record( out, b.second );
+            }
+            if( reversible_log.is_open() )
+               reversible_log.close();
+            bfs::rename( tmp, path );
+            reversible_log.open( path.string(), std::ios_base::binary | std::ios_base::out | std::ios_base::app );
+            reversible_log_kept = saved.size();
+            reversible_log_appended = 0;
+         }
+
+         void load_reversible_blocks() {
+            auto saved = read_reversible_log();
+            saved.erase( saved.begin(), saved.upper_bound( store->last_block() ) );
+
+            // blocks which are no longer on the chain are replaced when their successors are accepted
+            for( const auto& b : saved ) {
+               reversible_history block;
+               block.id = b.second.id;
+               for( const auto& t : b.second.transactions ) {
+                  for( const auto& e : t.actions ) {
+                     for( const auto& a : e.accounts ) {
+                        EOS_ASSERT( next_sequence( a.account, block ) == a.account_sequence_num, chain::plugin_exception,
+                                    "corrupt ${f}", ("f", (history_dir / "reversible.log").string()) );
+                     }
+                  }
+                  block.transactions.push_back( std::make_shared<transaction_history>( t ) );
+               }
+               add_reversible( block );
+               reversible_blocks.emplace( b.first, std::move( block ) );
+            }
+            rewrite_reversible_log( std::move( saved ) ); // also drops a record cut short by a crash
+         }
+
+         optional<int32_t> last_account_sequence( account_name n )const {
+            auto itr = next_account_sequence.find( n );
+            if( itr != next_account_sequence.end() )
+               return itr->second ? itr->second - 1 : optional<int32_t>();
+            return store->last_account_sequence( n );
+         }
    };
 
    history_plugin::history_plugin()
@@ -309,6 +901,12 @@ namespace eosio {
             ("filter-out,F", bpo::value<vector<string>>()->composing(),
              "Do not track actions which match receiver:action:actor. Action and Actor both blank excludes all from Reciever. Actor blank excludes all from reciever:action. Receiver may not be blank.")
             ;
+      cfg.add_options()
+            ("history-dir", bpo::value<bfs::path>()->default_value("history"),
+             "the location of the history directory (absolute path or relative to application data dir)")
+            ("history-index-batch-size", bpo::value<uint32_t>()->default_value(65536),
+             "Number of actions whose index entries are kept in memory before being written as new sorted index files")
+            ;
    }
 
    void history_plugin::plugin_initialize(const variables_map& options) {
@@ -318,7 +916,7 @@ namespace eosio {
             for( auto& s : fo ) {
                if( s == "*" || s == "\"*\"" ) {
                   my->bypass_filter = true;
-                  wlog( "--filter-on * enabled. This can fill shared_mem, causing nodeos to stop." );
+                  wlog( "--filter-on * enabled. This records every action, which can fill the history directory quickly." );
                   break;
                }
                std::vector<std::string> v;
@@ -342,22 +940,43 @@ namespace eosio {
                my->filter_out.insert( fe );
             }
          }
+         my->filters = compiled_filter( my->filter_on, my->filter_out );
 
          my->chain_plug = app().find_plugin<chain_plugin>();
          EOS_ASSERT( my->chain_plug, chain::missing_chain_plugin_exception, ""  );
          auto& chain = my->chain_plug->chain();
 
          chainbase::database& db = const_cast<chainbase::database&>( chain.db() ); // Override read-only access to state DB (highly unrecommended practice!)
-         // TODO: Use separate chainbase database for managing the state of the history_plugin (or remove deprecated history_plugin entirely) 
-         db.add_index<account_history_index>();
-         db.add_index<action_history_index>();
          db.add_index<account_control_history_multi_index>();
          db.add_index<public_key_history_multi_index>();
 
+         auto dir_option = options.at( "history-dir" ).as<bfs::path>();
+         if( dir_option.is_relative() )
+            my->history_dir = app().data_dir() / dir_option;
+         else
+            my->history_dir = dir_option;
+         bfs::create_directories( my->history_dir );
+         my->index_batch_size = options.at( "history-index-batch-size" ).as<uint32_t>();
+         EOS_ASSERT( my->index_batch_size > 0, chain::plugin_config_exception, "history-index-batch-size must be greater than 0" );
+         my->store.emplace( my->history_dir, my->index_batch_size );
+         my->load_reversible_blocks();
+
+         my->accepted_transaction_connection.emplace(
+               chain.accepted_transaction.connect( [&]( const transaction_metadata_ptr& p ) {
+                  my->on_accepted_transaction( p );
+               } ));
          my->applied_transaction_connection.emplace(
                chain.applied_transaction.connect( [&]( const transaction_trace_ptr& p ) {
                   my->on_applied_transaction( p );
                } ));
+         my->accepted_block_connection.emplace(
+               chain.accepted_block.connect( [&]( const block_state_ptr& p ) {
+                  my->on_accepted_block( p );
+               } ));
+         my->irreversible_block_connection.emplace(
+               chain.irreversible_block.connect( [&]( const block_state_ptr& p ) {
+                  my->on_irreversible_block( p );
+               } ));
       } FC_LOG_AND_RETHROW()
    }
 
@@ -365,7 +984,12 @@ namespace eosio {
    }
 
    void history_plugin::plugin_shutdown() {
+      my->accepted_transaction_connection.reset();
       my->applied_transaction_connection.reset();
+      my->accepted_block_connection.reset();
+      my->irreversible_block_connection.reset();
+      if( my->store )
+         my->store->close();
    }
 
 
@@ -375,11 +999,8 @@ namespace eosio {
       read_only::get_actions_result read_only::get_actions( const read_only::get_actions_params& params )const {
          edump((params));
         auto& chain = history->chain_plug->chain();
-        const auto& db = chain.db();
         const auto abi_serializer_max_time = history->chain_plug->get_abi_serializer_max_time();
 
-        const auto& idx = db.get_index<account_history_index, by_account_action_seq>();
-
         int32_t start = 0;
         int32_t pos = params.pos ? *params.pos : -1;
         int32_t end = 0;
@@ -387,14 +1008,9 @@ namespace eosio {
         auto n = params.account_name;
         idump((pos));
         if( pos == -1 ) {
-            auto itr = idx.lower_bound( boost::make_tuple( name(n.value+1), 0 ) );
-            if( itr == idx.begin() ) {
-               if( itr->account == n )
-                  pos = itr->account_sequence_num+1;
-            } else if( itr != idx.begin() ) --itr;
-
-            if( itr->account == n )
-               pos = itr->account_sequence_num + 1;
+            auto last = history->last_account_sequence( n );
+            if( last )
+               pos = *last + 1;
         }
 
         if( pos== -1 ) pos = 0xfffffff;
@@ -411,22 +1027,18 @@ namespace eosio {
 
         idump((start)(end));
 
-        auto start_itr = idx.lower_bound( boost::make_tuple( n, start ) );
-        auto end_itr = idx.upper_bound( boost::make_tuple( n, end) );
-
         auto start_time = fc::time_point::now();
         auto end_time = start_time;
 
         get_actions_result result;
         result.last_irreversible_block = chain.last_irreversible_block_num();
-        while( start_itr != end_itr ) {
-           const auto& a = db.get<action_history_object, by_action_sequence_num>( start_itr->action_sequence_num );
+        auto add_action = [&]( int32_t account_sequence_num, const action_history_entry& a ) {
            fc::datastream<const char*> ds( a.packed_action_trace.data(), a.packed_action_trace.size() );
            action_trace t;
            fc::raw::unpack( ds, t );
            result.actions.emplace_back( ordered_action_result{
-                                 start_itr->action_sequence_num,
-                                 start_itr->account_sequence_num,
+                                 a.global_sequence,
+                                 account_sequence_num,
                                  a.block_num, a.block_time,
                                  chain.to_variant_with_abi(t, abi_serializer_max_time)
                                  });
@@ -434,9 +1046,19 @@ namespace eosio {
            end_time = fc::time_point::now();
            if( end_time - start_time > fc::microseconds(100000) ) {
               result.time_limit_exceeded_error = true;
-              break;
+              return false;
+           }
+           return true;
+        };
+
+        // irreversible actions from the store, then those of reversible blocks, which are all later
+        if( history->store->for_each_account_action( n, start, end, add_action ) ) {
+           const auto& ridx = history->reversible_by_account;
+           for( auto itr = ridx.lower_bound( std::make_pair( n.value, start ) );
+                itr != ridx.end() && itr->first.first == n.value && itr->first.second <= end; ++itr ) {
+              if( !add_action( itr->first.second, *itr->second ) )
+                 break;
            }
-           ++start_itr;
         }
         return result;
       }
@@ -454,22 +1076,15 @@ namespace eosio {
             input_id = transaction_id_type(p.id);
          } EOS_RETHROW_EXCEPTIONS(transaction_id_type_exception, "Invalid transaction ID: ${transaction_id}", ("transaction_id", p.id))
 
-         auto txn_id_matched = [&input_id, input_id_size = input_id_length/2, no_half_byte_at_end = (input_id_length % 2 == 0)]
-                               ( const transaction_id_type &id ) -> bool // hex prefix comparison
-         {
-            bool whole_byte_prefix_matches = memcmp( input_id.data(), id.data(), input_id_size ) == 0;
-            if( !whole_byte_prefix_matches || no_half_byte_at_end )
-               return whole_byte_prefix_matches;
-
-            // check if half byte at end of specified part of input_id matches
-            return (*(input_id.data() + input_id_size) & 0xF0) == (*(id.data() + input_id_size) & 0xF0);
-         };
+         const transaction_id_prefix prefix{input_id, input_id_length};
 
-         const auto& db = chain.db();
-         const auto& idx = db.get_index<action_history_index, by_trx_id>();
-         auto itr = idx.lower_bound( boost::make_tuple( input_id ) );
+         auto history_trx = history->store->find_transaction( prefix );
+         const auto& ridx = history->reversible_transactions;
+         auto ritr = ridx.lower_bound( input_id );
+         if( ritr != ridx.end() && prefix.matches( ritr->first ) && (!history_trx || ritr->first < history_trx->trx.id) )
+            history_trx = *ritr->second;
 
-         bool in_history = (itr != idx.end() && txn_id_matched(itr->trx_id) );
+         bool in_history = history_trx.valid();
 
          if( !in_history && !p.block_num_hint ) {
             EOS_THROW(tx_not_found, "Transaction ${id} not found in history and no block hint was given", ("id",p.id));
@@ -478,48 +1093,27 @@ namespace eosio {
          get_transaction_result result;
 
          if( in_history ) {
-            result.id         = itr->trx_id;
+            result.id         = history_trx->trx.id;
             result.last_irreversible_block = chain.last_irreversible_block_num();
-            result.block_num  = itr->block_num;
-            result.block_time = itr->block_time;
+            result.block_num  = history_trx->trx.block_num;
+            result.block_time = history_trx->trx.block_time;
 
-            while( itr != idx.end() && itr->trx_id == result.id ) {
-
-              fc::datastream<const char*> ds( itr->packed_action_trace.data(), itr->packed_action_trace.size() );
+            for( const auto& a : history_trx->actions ) {
+              fc::datastream<const char*> ds( a.packed_action_trace.data(), a.packed_action_trace.size() );
               action_trace t;
               fc::raw::unpack( ds, t );
               result.traces.emplace_back( chain.to_variant_with_abi(t, abi_serializer_max_time) );
+            }
 
-              ++itr;
-            }
-
-            auto blk = chain.fetch_block_by_number( result.block_num );
-            if( blk == nullptr ) { // still in pending
-                auto blk_state = chain.pending_block_state();
-                if( blk_state != nullptr ) {
-                    blk = blk_state->block;
-                }
-            }
-            if( blk != nullptr ) {
-                for (const auto &receipt: blk->transactions) {
-                    if (receipt.trx.contains<packed_transaction>()) {
-                        auto &pt = receipt.trx.get<packed_transaction>();
-                        auto mtrx = transaction_metadata(pt);
-                        if (mtrx.id == result.id) {
-                            fc::mutable_variant_object r("receipt", receipt);
-                            r("trx", chain.to_variant_with_abi(mtrx.trx, abi_serializer_max_time));
-                            result.trx = move(r);
-                            break;
-                        }
-                    } else {
-                        auto &id = receipt.trx.get<transaction_id_type>();
-                        if (id == result.id) {
-                            fc::mutable_variant_object r("receipt", receipt);
-                            result.trx = move(r);
-                            break;
-                        }
-                    }
-                }
+            // the receipt is stored with the transaction, so the block is not read
+            if( history_trx->trx.receipt ) {
+               const auto& receipt = *history_trx->trx.receipt;
+               fc::mutable_variant_object r("receipt", receipt);
+               if (receipt.trx.contains<packed_transaction>()) {
+                  auto mtrx = transaction_metadata(receipt.trx.get<packed_transaction>());
+                  r("trx", chain.to_variant_with_abi(mtrx.trx, abi_serializer_max_time));
+               }
+               result.trx = move(r);
             }
          } else {
             auto blk = chain.fetch_block_by_number(*p.block_num_hint);
@@ -529,7 +1123,7 @@ namespace eosio {
                   if (receipt.trx.contains<packed_transaction>()) {
                      auto& pt = receipt.trx.get<packed_transaction>();
                      auto mtrx = transaction_metadata(pt);
-                     if( txn_id_matched(mtrx.id) ) {
+                     if( prefix.matches(mtrx.id) ) {
                         result.id = mtrx.id;
                         result.last_irreversible_block = chain.last_irreversible_block_num();
                         result.block_num = *p.block_num_hint;
@@ -542,7 +1136,7 @@ namespace eosio {
                      }
                   } else {
                      auto& id = receipt.trx.get<transaction_id_type>();
-                     if( txn_id_matched(id) ) {
+                     if( prefix.matches(id) ) {
                         result.id = id;
                         result.last_irreversible_block = chain.last_irreversible_block_num();
                         result.block_num = *p.block_num_hint;
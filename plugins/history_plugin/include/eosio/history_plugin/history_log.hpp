@@ -0,0 +1,354 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+#include <eosio/chain/block.hpp>
+#include <eosio/chain/block_timestamp.hpp>
+#include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/types.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+/*
+ *   actions.log, transactions.log:
+ *   +---------+----------------+-----------+------------------+-----+---------+----------------+
+ *   | Entry i | Pos of Entry i | Entry i+1 | Pos of Entry i+1 | ... | Entry z | Pos of Entry z |
+ *   +---------+----------------+-----------+------------------+-----+---------+----------------+
+ *
+ *   index-<begin>-<end>.accounts, index-<begin>-<end>.transactions:
+ *   +---------------+-----------------+-----+---------------+
+ *   | Index entry 0 | Index entry 1   | ... | Index entry n |
+ *   +---------------+-----------------+-----+---------------+
+ *
+ * each entry:
+ *    history_log_header
+ *    action_history_entry or transaction_history_entry packed with fc::raw
+ *
+ * each index file holds the account_index_entry or transaction_index_entry records of the blocks [begin, end), sorted.
+ */
+
+struct account_sequence {
+   chain::account_name account;
+   int32_t             account_sequence_num = 0; ///< the sequence number for this account (per-account)
+};
+
+struct action_history_entry {
+   uint64_t                      global_sequence = 0;
+   uint32_t                      block_num       = 0;
+   chain::block_timestamp_type   block_time;
+   chain::transaction_id_type    trx_id;
+   std::vector<account_sequence> accounts; ///< the accounts which have this action in their history
+   chain::bytes                  packed_action_trace;
+};
+
+struct transaction_history_entry {
+   chain::transaction_id_type                 id;
+   uint32_t                                   block_num = 0;
+   chain::block_timestamp_type                block_time;
+   fc::optional<chain::transaction_receipt>   receipt;          ///< absent for the onblock transaction
+   std::vector<uint64_t>                      action_positions; ///< of the transaction's entries in actions.log
+};
+
+struct history_log_header {
+   uint32_t block_num    = 0;
+   uint32_t payload_size = 0;
+};
+
+struct account_index_entry {
+   uint64_t account              = 0;
+   int32_t  account_sequence_num = 0;
+   uint32_t block_num            = 0;
+   uint64_t pos                  = 0; ///< of the entry in actions.log
+
+   friend bool operator<(const account_index_entry& a, const account_index_entry& b) {
+      return std::tie(a.account, a.account_sequence_num) < std::tie(b.account, b.account_sequence_num);
+   }
+};
+
+/**
+ *  Indexes a transaction by the first 8 bytes of its id, which is all a lookup by id prefix needs to narrow the
+ *  candidates to, in a third of the space of the whole id.
+ */
+struct transaction_index_entry {
+   uint64_t id_prefix = 0;
+   uint64_t pos       = 0; ///< of the entry in transactions.log
+   uint32_t block_num = 0;
+   uint32_t reserved  = 0;
+
+   static uint64_t prefix_of(const chain::transaction_id_type& id) {
+      uint64_t result = 0;
+      for (size_t i = 0; i < sizeof(result); ++i)
+         result = (result << 8) | (uint8_t)id.data()[i];
+      return result;
+   }
+
+   friend bool operator<(const transaction_index_entry& a, const transaction_index_entry& b) {
+      return std::tie(a.id_prefix, a.block_num, a.pos) < std::tie(b.id_prefix, b.block_num, b.pos);
+   }
+};
+
+/// the leading hex digits of a transaction id, as given to get_transaction
+struct transaction_id_prefix {
+   chain::transaction_id_type id; ///< the digits, followed by zeros
+   size_t                     hex_digits = 0;
+
+   bool matches(const chain::transaction_id_type& other) const {
+      size_t whole_bytes = hex_digits / 2;
+      if (memcmp(id.data(), other.data(), whole_bytes) != 0)
+         return false;
+      return hex_digits % 2 == 0 || (id.data()[whole_bytes] & 0xF0) == (other.data()[whole_bytes] & 0xF0);
+   }
+
+   /// whether ids with this index prefix may match
+   bool matches_index_prefix(uint64_t id_prefix) const {
+      size_t bits = std::min<size_t>(hex_digits * 4, 64);
+      return bits == 0 || (id_prefix >> (64 - bits)) == (transaction_index_entry::prefix_of(id) >> (64 - bits));
+   }
+};
+
+/**
+ *  An append-only log of history entries. Entries are appended by a single writer, and read back by position
+ *  through a separate stream, so a reader never waits for the writer.
+ */
+template <typename Entry>
+class history_log {
+ private:
+   const char* const name = "";
+   std::string       filename;
+   std::fstream      log;
+   std::ifstream     reader;
+   uint64_t          _size = 0;
+
+ public:
+   history_log(const char* const name, std::string filename)
+       : name(name)
+       , filename(std::move(filename)) {
+      log.open(this->filename, std::ios_base::binary | std::ios_base::in | std::ios_base::out | std::ios_base::app);
+      log.seekg(0, std::ios_base::end);
+      _size = log.tellg();
+      if (_size && !last_entry_valid())
+         recover();
+      reader.open(this->filename, std::ios_base::binary | std::ios_base::in);
+   }
+
+   uint64_t size() const { return _size; }
+
+   /// returns the position of the entry
+   uint64_t append(const Entry& entry) {
+      auto               payload = fc::raw::pack(entry);
+      history_log_header header{entry.block_num, (uint32_t)payload.size()};
+      uint64_t           pos = _size;
+      log.write((char*)&header, sizeof(header));
+      log.write(payload.data(), payload.size());
+      log.write((char*)&pos, sizeof(pos));
+      _size += sizeof(header) + payload.size() + sizeof(pos);
+      return pos;
+   }
+
+   void flush() { log.flush(); }
+
+   Entry read(uint64_t pos) {
+      history_log_header header;
+      reader.clear();
+      reader.seekg(pos);
+      reader.read((char*)&header, sizeof(header));
+      chain::bytes payload(header.payload_size);
+      reader.read(payload.data(), payload.size());
+      EOS_ASSERT(reader, chain::plugin_exception, "unable to read ${name}.log at ${pos}", ("name", name)("pos", pos));
+      return fc::raw::unpack<Entry>(payload);
+   }
+
+   /// calls f(pos, entry) for each entry at a position in [begin, end)
+   template <typename F>
+   void for_each(uint64_t begin, uint64_t end, F f) {
+      for (uint64_t pos = begin; pos < end; pos += entry_size(pos))
+         f(pos, read(pos));
+   }
+
+   /// the position after the entries of the blocks up to block_num
+   uint64_t end_of_block(uint32_t block_num) {
+      uint64_t end = _size;
+      reader.clear();
+      while (end) {
+         uint64_t pos;
+         reader.seekg(end - sizeof(pos));
+         reader.read((char*)&pos, sizeof(pos));
+         history_log_header header;
+         reader.seekg(pos);
+         reader.read((char*)&header, sizeof(header));
+         if (header.block_num <= block_num)
+            break;
+         end = pos;
+      }
+      return end;
+   }
+
+   /// removes the entries of the blocks after block_num, which the log holds when the node stopped while writing them
+   void truncate_after_block(uint32_t block_num) {
+      uint64_t end = end_of_block(block_num);
+      if (end != _size) {
+         ilog("removing ${n} bytes of uncommitted entries from ${name}.log", ("n", _size - end)("name", name));
+         truncate(end);
+      }
+   }
+
+ private:
+   uint64_t entry_size(uint64_t pos) {
+      history_log_header header;
+      reader.clear();
+      reader.seekg(pos);
+      reader.read((char*)&header, sizeof(header));
+      return sizeof(header) + header.payload_size + sizeof(uint64_t);
+   }
+
+   bool last_entry_valid() {
+      history_log_header header;
+      uint64_t           suffix;
+      if (_size < sizeof(header) + sizeof(suffix))
+         return false;
+      log.seekg(_size - sizeof(suffix));
+      log.read((char*)&suffix, sizeof(suffix));
+      if (suffix + sizeof(header) + sizeof(suffix) > _size)
+         return false;
+      log.seekg(suffix);
+      log.read((char*)&header, sizeof(header));
+      return suffix + sizeof(header) + header.payload_size + sizeof(suffix) == _size;
+   }
+
+   void recover() {
+      ilog("recover ${name}.log", ("name", name));
+      uint64_t pos = 0;
+      while (true) {
+         history_log_header header;
+         uint64_t           suffix;
+         if (pos + sizeof(header) > _size)
+            break;
+         log.seekg(pos);
+         log.read((char*)&header, sizeof(header));
+         if (pos + sizeof(header) + header.payload_size + sizeof(suffix) > _size)
+            break;
+         log.seekg(pos + sizeof(header) + header.payload_size);
+         log.read((char*)&suffix, sizeof(suffix));
+         if (suffix != pos)
+            break;
+         pos += sizeof(header) + header.payload_size + sizeof(suffix);
+      }
+      truncate(pos);
+   }
+
+   void truncate(uint64_t size) {
+      log.flush();
+      boost::filesystem::resize_file(filename, size);
+      log.seekg(0, std::ios_base::end);
+      _size = size;
+   }
+}; // history_log
+
+/**
+ *  A file of fixed-size index entries sorted by Entry::operator<, searched in place.
+ */
+template <typename Entry>
+class history_index_file {
+ private:
+   std::string           filename;
+   mutable std::ifstream file;
+   uint64_t              _size = 0;
+
+ public:
+   explicit history_index_file(std::string filename)
+       : filename(std::move(filename)) {
+      file.open(this->filename, std::ios_base::binary | std::ios_base::in);
+      file.seekg(0, std::ios_base::end);
+      uint64_t bytes = file.tellg();
+      EOS_ASSERT(bytes % sizeof(Entry) == 0, chain::plugin_exception, "corrupt ${f}", ("f", this->filename));
+      _size = bytes / sizeof(Entry);
+   }
+
+   /// writes sorted entries, through a temporary file so that an index file is never seen partly written
+   static void write(const std::string& filename, const std::vector<Entry>& sorted) {
+      auto tmp = filename + ".tmp";
+      {
+         std::ofstream out(tmp, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+         out.write((const char*)sorted.data(), sorted.size() * sizeof(Entry));
+         out.flush();
+         EOS_ASSERT(out, chain::plugin_exception, "unable to write ${f}", ("f", tmp));
+      }
+      boost::filesystem::rename(tmp, filename);
+   }
+
+   /// writes the entries of a and b, where the entries of b were all added after those of a
+   static void merge(const std::string& filename, const history_index_file& a, const history_index_file& b) {
+      auto tmp = filename + ".tmp";
+      {
+         std::ofstream out(tmp, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+         std::ifstream in_a(a.filename, std::ios_base::binary | std::ios_base::in);
+         std::ifstream in_b(b.filename, std::ios_base::binary | std::ios_base::in);
+         uint64_t      i = 0, j = 0;
+         Entry         ea, eb;
+         if (a._size)
+            in_a.read((char*)&ea, sizeof(ea));
+         if (b._size)
+            in_b.read((char*)&eb, sizeof(eb));
+         while (i < a._size || j < b._size) {
+            if (j == b._size || (i < a._size && !(eb < ea))) {
+               out.write((const char*)&ea, sizeof(ea));
+               if (++i < a._size)
+                  in_a.read((char*)&ea, sizeof(ea));
+            } else {
+               out.write((const char*)&eb, sizeof(eb));
+               if (++j < b._size)
+                  in_b.read((char*)&eb, sizeof(eb));
+            }
+         }
+         out.flush();
+         EOS_ASSERT(out && in_a && in_b, chain::plugin_exception, "unable to merge into ${f}", ("f", tmp));
+      }
+      boost::filesystem::rename(tmp, filename);
+   }
+
+   uint64_t size() const { return _size; }
+
+   Entry at(uint64_t i) const {
+      Entry e;
+      file.seekg(i * sizeof(Entry));
+      file.read((char*)&e, sizeof(e));
+      EOS_ASSERT(file, chain::plugin_exception, "unable to read ${f}", ("f", filename));
+      return e;
+   }
+
+   /// index of the first entry not less than key
+   uint64_t lower_bound(const Entry& key) const {
+      uint64_t first = 0, count = _size;
+      while (count) {
+         uint64_t step = count / 2;
+         if (at(first + step) < key) {
+            first += step + 1;
+            count -= step + 1;
+         } else {
+            count = step;
+         }
+      }
+      return first;
+   }
+
+   void remove() {
+      file.close();
+      boost::filesystem::remove(filename);
+   }
+}; // history_index_file
+
+} // namespace eosio
+
+FC_REFLECT(eosio::account_sequence, (account)(account_sequence_num))
+FC_REFLECT(eosio::action_history_entry,
+           (global_sequence)(block_num)(block_time)(trx_id)(accounts)(packed_action_trace))
+FC_REFLECT(eosio::transaction_history_entry, (id)(block_num)(block_time)(receipt)(action_positions))
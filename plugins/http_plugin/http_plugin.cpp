@@ -13,7 +13,13 @@
 #include <fc/crypto/openssl.hpp>
 
 #include <boost/asio.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/optional.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
 
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/config/asio.hpp>
@@ -25,6 +31,9 @@
 #include <thread>
 #include <memory>
 #include <regex>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 namespace eosio {
 
@@ -126,15 +135,87 @@ namespace eosio {
 
    static bool verbose_http_errors = false;
 
+   namespace bio = boost::iostreams;
+
+   enum class content_encoding {
+      identity,
+      gzip,
+      deflate
+   };
+
+   /**
+    *  Picks the response encoding from an Accept-Encoding header, preferring gzip over deflate; codings with q=0 are
+    *  refused.
+    */
+   static content_encoding negotiate_content_encoding( const string& accept_encoding ) {
+      bool gzip = false, deflate = false, any = false, gzip_refused = false;
+      vector<string> codings;
+      boost::split( codings, accept_encoding, boost::is_any_of( "," ));
+      for( auto& c : codings ) {
+         vector<string> params;
+         boost::split( params, c, boost::is_any_of( ";" ));
+         string name = boost::algorithm::to_lower_copy( boost::algorithm::trim_copy( params[0] ));
+         bool refused = false;
+         for( size_t i = 1; i < params.size(); ++i ) {
+            string p = boost::algorithm::trim_copy( params[i] );
+            if( p.size() > 2 && (p[0] == 'q' || p[0] == 'Q') && p[1] == '=' ) {
+               try {
+                  refused = std::stod( p.substr( 2 )) <= 0;
+               } catch( ... ) {
+                  refused = true;
+               }
+            }
+         }
+         if( refused ) {
+            gzip_refused = gzip_refused || name == "gzip" || name == "x-gzip";
+            continue;
+         }
+         if( name == "gzip" || name == "x-gzip" ) gzip = true;
+         else if( name == "deflate" ) deflate = true;
+         else if( name == "*" ) any = true;
+      }
+      if( gzip || (any && !gzip_refused) ) return content_encoding::gzip;
+      if( deflate ) return content_encoding::deflate;
+      return content_encoding::identity;
+   }
+
    class http_plugin_impl {
       public:
-         map<string,url_handler>  url_handlers;
+         struct registered_handler {
+            url_handler              handler;
+            handler_thread           thread = handler_thread::main;
+         };
+
+         struct read_only_request {
+            url_handler              handler;
+            string                   url;
+            string                   body;
+            url_response_callback    cb;
+         };
+
+         // declared before the servers, which must be destroyed first
+         optional<asio::io_service>                       http_ios;
+         optional<asio::io_service::work>                 http_ios_work;
+         vector<std::thread>                              http_threads;
+         uint16_t                                         thread_pool_size = 2;
+
+         optional<boost::asio::thread_pool>               read_only_pool;
+         uint16_t                                         read_only_pool_size = 2;
+         std::mutex                                       read_only_mtx;
+         std::deque<read_only_request>                    read_only_queue; ///< guarded by read_only_mtx
+         bool                                             read_window_scheduled = false; ///< guarded by read_only_mtx
+
+         std::mutex                                       url_handlers_mtx;
+         map<string,registered_handler>                   url_handlers; ///< guarded by url_handlers_mtx
+         map<string,registered_handler>                   binary_url_handlers; ///< guarded by url_handlers_mtx
          optional<tcp::endpoint>  listen_endpoint;
          string                   access_control_allow_origin;
          string                   access_control_allow_headers;
          string                   access_control_max_age;
          bool                     access_control_allow_credentials = false;
          size_t                   max_body_size;
+         uint32_t                 compression_min_size = 1024; ///< 0 disables response compression
+         int                      compression_level = bio::zlib::best_speed;
 
          websocket_server_type    server;
 
@@ -283,14 +364,60 @@ namespace eosio {
                con->append_header( "Content-type", "application/json" );
                auto body = con->get_request_body();
                auto resource = con->get_uri()->get_resource();
-               auto handler_itr = url_handlers.find( resource );
-               if( handler_itr != url_handlers.end()) {
+               const bool binary = req.get_header( "Accept" ).find( "application/octet-stream" ) != string::npos;
+               optional<registered_handler> handler;
+               bool binary_handler = false;
+               {
+                  std::lock_guard<std::mutex> g( url_handlers_mtx );
+                  auto handler_itr = binary_url_handlers.find( resource );
+                  if( binary && handler_itr != binary_url_handlers.end() ) {
+                     handler = handler_itr->second;
+                     binary_handler = true;
+                  } else if( (handler_itr = url_handlers.find( resource )) != url_handlers.end() ) {
+                     handler = handler_itr->second;
+                  }
+               }
+               if( handler ) {
                   con->defer_http_response();
-                  handler_itr->second( resource, body, [con]( auto code, auto&& body ) {
-                     con->set_body( std::move( body ));
-                     con->set_status( websocketpp::http::status_code::value( code ));
-                     con->send_http_response();
-                  } );
+                  content_encoding encoding = content_encoding::identity;
+                  if( compression_min_size > 0 ) {
+                     con->append_header( "Vary", "Accept-Encoding" );
+                     encoding = negotiate_content_encoding( req.get_header( "Accept-Encoding" ));
+                  }
+
+                  // the response is compressed and sent from the http threads whichever thread produced it
+                  url_response_callback cb = [this, con, encoding, binary_handler]( int code, string body ) {
+                     http_ios->post( [this, con, code, encoding, binary_handler, body{std::move( body )}]() mutable {
+                        // errors are reported as json whichever handler produced them
+                        if( binary_handler && code >= 200 && code < 300 )
+                           con->replace_header( "Content-type", "application/octet-stream" );
+                        if( encoding != content_encoding::identity && body.size() >= compression_min_size ) {
+                           try {
+                              body = compress( body, encoding );
+                              con->append_header( "Content-Encoding", encoding == content_encoding::gzip ? "gzip" : "deflate" );
+                           } catch( ... ) {
+                              elog( "unable to compress http response, sending it uncompressed" );
+                           }
+                        }
+                        con->set_body( std::move( body ));
+                        con->set_status( websocketpp::http::status_code::value( code ));
+                        con->send_http_response();
+                     } );
+                  };
+
+                  if( handler->thread == handler_thread::read_only && read_only_pool ) {
+                     queue_read_only( read_only_request{ std::move( handler->handler ), std::move( resource ),
+                                                         std::move( body ), std::move( cb ) } );
+                  } else {
+                     app().get_io_service().post( [h{std::move( handler->handler )}, resource{std::move( resource )},
+                                                   body{std::move( body )}, cb{std::move( cb )}]() {
+                        try {
+                           h( resource, body, cb );
+                        } catch( ... ) {
+                           http_plugin::handle_exception( "http", resource.c_str(), body, cb );
+                        }
+                     } );
+                  }
 
                } else {
                   dlog( "404 - not found: ${ep}", ("ep", resource));
@@ -304,11 +431,71 @@ namespace eosio {
             }
          }
 
+         string compress( const string& body, content_encoding encoding ) const {
+            string out;
+            out.reserve( body.size() / 4 );
+            bio::filtering_ostream comp;
+            if( encoding == content_encoding::gzip )
+               comp.push( bio::gzip_compressor( bio::gzip_params( compression_level )));
+            else
+               comp.push( bio::zlib_compressor( bio::zlib_params( compression_level )));
+            comp.push( bio::back_inserter( out ));
+            bio::write( comp, body.data(), body.size() );
+            bio::close( comp );
+            return out;
+         }
+
+         /**
+          *  Queues a read-only request and makes sure a read window is scheduled on the application thread to run it.
+          */
+         void queue_read_only( read_only_request&& r ) {
+            std::lock_guard<std::mutex> g( read_only_mtx );
+            read_only_queue.emplace_back( std::move( r ));
+            if( !read_window_scheduled ) {
+               read_window_scheduled = true;
+               app().get_io_service().post( [this]() { run_read_window(); } );
+            }
+         }
+
+         /**
+          *  Runs on the application thread: hands every queued read-only request to the read-only pool and blocks until
+          *  all of them are done. Nothing can modify the chain state while the application thread waits here, which
+          *  makes the window a shared read lock held by the pool threads.
+          */
+         void run_read_window() {
+            std::deque<read_only_request> requests;
+            {
+               std::lock_guard<std::mutex> g( read_only_mtx );
+               requests.swap( read_only_queue );
+               read_window_scheduled = false;
+            }
+            if( requests.empty() || !read_only_pool ) return; // nothing to do, or shutting down
+
+            std::mutex done_mtx;
+            std::condition_variable done_cv;
+            size_t remaining = requests.size();
+            for( auto& r : requests ) {
+               boost::asio::post( *read_only_pool, [&r, &done_mtx, &done_cv, &remaining]() {
+                  try {
+                     r.handler( r.url, r.body, r.cb );
+                  } catch( ... ) {
+                     http_plugin::handle_exception( "http", r.url.c_str(), r.body, r.cb );
+                  }
+                  std::lock_guard<std::mutex> g( done_mtx );
+                  if( --remaining == 0 )
+                     done_cv.notify_one();
+               } );
+            }
+
+            std::unique_lock<std::mutex> lock( done_mtx );
+            done_cv.wait( lock, [&remaining]() { return remaining == 0; } );
+         }
+
          template<class T>
          void create_server_for_endpoint(const tcp::endpoint& ep, websocketpp::server<detail::asio_with_stub_log<T>>& ws) {
             try {
                ws.clear_access_channels(websocketpp::log::alevel::all);
-               ws.init_asio(&app().get_io_service());
+               ws.init_asio(&*http_ios);
                ws.set_reuse_addr(true);
                ws.set_max_http_body_size(max_body_size);
                ws.set_http_handler([&](connection_hdl hdl) {
@@ -400,6 +587,14 @@ namespace eosio {
             ("verbose-http-errors", bpo::bool_switch()->default_value(false), "Append the error log to HTTP responses")
             ("http-validate-host", boost::program_options::value<bool>()->default_value(true), "If set to false, then any incoming \"Host\" header is considered valid")
             ("http-alias", bpo::value<std::vector<string>>()->composing(), "Additionaly acceptable values for the \"Host\" header of incoming HTTP requests, can be specified multiple times.  Includes http/s_server_address by default.")
+            ("http-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
+             "Number of worker threads in http thread pool")
+            ("http-read-only-threads", bpo::value<uint16_t>()->default_value(my->read_only_pool_size),
+             "Number of threads executing read-only API calls concurrently; 0 executes them on the application thread")
+            ("http-compression-min-size", bpo::value<uint32_t>()->default_value(my->compression_min_size),
+             "Compress responses of at least this many bytes with gzip or deflate when the client accepts it; 0 disables compression")
+            ("http-compression-level", bpo::value<int>()->default_value(my->compression_level),
+             "zlib compression level of http responses, from 1 (fastest) to 9 (smallest)")
             ;
    }
 
@@ -474,11 +669,26 @@ namespace eosio {
          my->max_body_size = options.at( "max-body-size" ).as<uint32_t>();
          verbose_http_errors = options.at( "verbose-http-errors" ).as<bool>();
 
+         my->thread_pool_size = options.at( "http-threads" ).as<uint16_t>();
+         EOS_ASSERT( my->thread_pool_size > 0, chain::plugin_config_exception,
+                     "http-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+         my->read_only_pool_size = options.at( "http-read-only-threads" ).as<uint16_t>();
+
+         my->compression_min_size = options.at( "http-compression-min-size" ).as<uint32_t>();
+         my->compression_level = options.at( "http-compression-level" ).as<int>();
+         EOS_ASSERT( my->compression_level >= 1 && my->compression_level <= 9, chain::plugin_config_exception,
+                     "http-compression-level ${l} must be between 1 and 9", ("l", my->compression_level));
+
          //watch out for the returns above when adding new code here
       } FC_LOG_AND_RETHROW()
    }
 
    void http_plugin::plugin_startup() {
+      my->http_ios.emplace();
+      my->http_ios_work.emplace( *my->http_ios );
+      if( my->read_only_pool_size > 0 )
+         my->read_only_pool.emplace( my->read_only_pool_size );
+
       if(my->listen_endpoint) {
          try {
             my->create_server_for_endpoint(*my->listen_endpoint, my->server);
@@ -501,7 +711,7 @@ namespace eosio {
       if(my->unix_endpoint) {
          try {
             my->unix_server.clear_access_channels(websocketpp::log::alevel::all);
-            my->unix_server.init_asio(&app().get_io_service());
+            my->unix_server.init_asio(&*my->http_ios);
             my->unix_server.set_max_http_body_size(my->max_body_size);
             my->unix_server.listen(*my->unix_endpoint);
             my->unix_server.set_http_handler([&](connection_hdl hdl) {
@@ -541,6 +751,11 @@ namespace eosio {
             throw;
          }
       }
+
+      my->http_threads.reserve( my->thread_pool_size );
+      for( uint16_t i = 0; i < my->thread_pool_size; ++i ) {
+         my->http_threads.emplace_back( [&ios = *my->http_ios]() { ios.run(); } );
+      }
    }
 
    void http_plugin::plugin_shutdown() {
@@ -548,13 +763,34 @@ namespace eosio {
          my->server.stop_listening();
       if(my->https_server.is_listening())
          my->https_server.stop_listening();
+      if(my->unix_server.is_listening())
+         my->unix_server.stop_listening();
+
+      if( my->http_ios ) {
+         my->http_ios_work.reset();
+         my->http_ios->stop();
+      }
+      for( auto& t : my->http_threads )
+         t.join();
+      my->http_threads.clear();
+
+      if( my->read_only_pool ) {
+         my->read_only_pool->stop();
+         my->read_only_pool->join();
+         my->read_only_pool.reset();
+      }
    }
 
-   void http_plugin::add_handler(const string& url, const url_handler& handler) {
+   void http_plugin::add_handler(const string& url, const url_handler& handler, handler_thread thread) {
       ilog( "add api url: ${c}", ("c",url) );
-      app().get_io_service().post([=](){
-        my->url_handlers.insert(std::make_pair(url,handler));
-      });
+      std::lock_guard<std::mutex> g( my->url_handlers_mtx );
+      my->url_handlers.emplace( url, http_plugin_impl::registered_handler{ handler, thread } );
+   }
+
+   void http_plugin::add_binary_handler(const string& url, const url_handler& handler, handler_thread thread) {
+      ilog( "add binary api url: ${c}", ("c",url) );
+      std::lock_guard<std::mutex> g( my->url_handlers_mtx );
+      my->binary_url_handlers.emplace( url, http_plugin_impl::registered_handler{ handler, thread } );
    }
 
    void http_plugin::handle_exception( const char *api_name, const char *call_name, const string& body, url_response_callback cb ) {
@@ -40,6 +40,20 @@ namespace eosio {
     */
    using api_description = std::map<string, url_handler>;
 
+   /**
+    * @brief The thread a URL handler is executed on
+    *
+    * main handlers run on the appbase application io_service thread, one at a time.
+    *
+    * read_only handlers must only read chain state and must call the response callback before returning. They run
+    * concurrently on the read-only thread pool, in windows during which the application thread does nothing else,
+    * so the chain state cannot change under them.
+    */
+   enum class handler_thread {
+      main,
+      read_only
+   };
+
    struct http_plugin_defaults {
       //If not empty, this string is prepended on to the various configuration
       // items for setting listen addresses
@@ -60,12 +74,13 @@ namespace eosio {
     *  called with the response code and body.
     *
     *  The handler will be called from the appbase application io_service
-    *  thread.  The callback can be called from any thread and will
-    *  automatically propagate the call to the http thread.
+    *  thread, or from the read-only thread pool if it was added as a
+    *  read_only handler.  The callback can be called from any thread and will
+    *  automatically propagate the call to the http threads.
     *
-    *  The HTTP service will run in its own thread with its own io_service to
-    *  make sure that HTTP request processing does not interfer with other
-    *  plugins.
+    *  The HTTP service runs on its own threads with their own io_service to
+    *  make sure that accepting and parsing requests does not interfere with
+    *  other plugins.
     */
    class http_plugin : public appbase::plugin<http_plugin>
    {
@@ -83,10 +98,20 @@ namespace eosio {
         void plugin_startup();
         void plugin_shutdown();
 
-        void add_handler(const string& url, const url_handler&);
-        void add_api(const api_description& api) {
+        void add_handler(const string& url, const url_handler&, handler_thread thread = handler_thread::main);
+        void add_api(const api_description& api, handler_thread thread = handler_thread::main) {
+           for (const auto& call : api)
+              add_handler(call.first, call.second, thread);
+        }
+
+        /**
+         * Adds a handler used instead of the one added by add_handler when the request accepts
+         * application/octet-stream; a successful response body is sent as application/octet-stream.
+         */
+        void add_binary_handler(const string& url, const url_handler&, handler_thread thread = handler_thread::main);
+        void add_binary_api(const api_description& api, handler_thread thread = handler_thread::main) {
            for (const auto& call : api)
-              add_handler(call.first, call.second);
+              add_binary_handler(call.first, call.second, thread);
         }
 
         // standard exception handling for api handlers
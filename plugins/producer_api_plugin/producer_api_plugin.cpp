@@ -90,6 +90,8 @@ void producer_api_plugin::plugin_startup() {
             INVOKE_R_V(producer, get_integrity_hash), 201),
        CALL(producer, producer, create_snapshot,
             INVOKE_R_V(producer, create_snapshot), 201),
+       CALL(producer, producer, get_production_timing,
+            INVOKE_R_V(producer, get_production_timing), 201),
    });
 }
 
@@ -25,6 +25,7 @@ public:
       fc::optional<int32_t> last_block_time_offset_us;
       fc::optional<int32_t> subjective_cpu_leeway_us;
       fc::optional<double>  incoming_defer_ratio;
+      fc::optional<bool>    adaptive_block_cutoff;
    };
 
    struct whitelist_blacklist {
@@ -50,6 +51,17 @@ public:
       std::string          snapshot_name;
    };
 
+   struct production_timing_information {
+      bool     adaptive_block_cutoff = false;
+      int32_t  effective_produce_time_offset_us = 0;
+      int32_t  effective_last_block_time_offset_us = 0;
+      int64_t  avg_produce_us = 0;
+      int64_t  stddev_produce_us = 0;
+      int64_t  avg_sign_us = 0;
+      int64_t  avg_timer_lateness_us = 0;
+      uint32_t blocks_measured = 0;
+   };
+
    producer_plugin();
    virtual ~producer_plugin();
 
@@ -81,6 +93,8 @@ public:
    integrity_hash_information get_integrity_hash() const;
    snapshot_information create_snapshot() const;
 
+   production_timing_information get_production_timing() const;
+
    signal<void(const chain::producer_confirmation&)> confirmed_block;
 private:
    std::shared_ptr<class producer_plugin_impl> my;
@@ -88,9 +102,12 @@ private:
 
 } //eosio
 
-FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(subjective_cpu_leeway_us)(incoming_defer_ratio));
+FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(subjective_cpu_leeway_us)(incoming_defer_ratio)(adaptive_block_cutoff));
 FC_REFLECT(eosio::producer_plugin::greylist_params, (accounts));
 FC_REFLECT(eosio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
 FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash))
 FC_REFLECT(eosio::producer_plugin::snapshot_information, (head_block_id)(snapshot_name))
+FC_REFLECT(eosio::producer_plugin::production_timing_information,
+           (adaptive_block_cutoff)(effective_produce_time_offset_us)(effective_last_block_time_offset_us)
+           (avg_produce_us)(stddev_produce_us)(avg_sign_us)(avg_timer_lateness_us)(blocks_measured))
 
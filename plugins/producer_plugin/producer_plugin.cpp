@@ -7,6 +7,7 @@
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/transaction_object.hpp>
+#include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/snapshot.hpp>
 
 #include <fc/io/json.hpp>
@@ -18,6 +19,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <boost/algorithm/string.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/function_output_iterator.hpp>
@@ -25,6 +27,7 @@
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
 #include <boost/signals2/connection.hpp>
 
 namespace bmi = boost::multi_index;
@@ -33,6 +36,8 @@ using bmi::ordered_non_unique;
 using bmi::member;
 using bmi::tag;
 using bmi::hashed_unique;
+using bmi::ordered_unique;
+using bmi::composite_key;
 
 using boost::multi_index_container;
 
@@ -76,6 +81,7 @@ struct transaction_id_with_expiry {
 
 struct by_id;
 struct by_expiry;
+struct by_sender;
 
 using transaction_id_with_expiry_index = multi_index_container<
    transaction_id_with_expiry,
@@ -85,6 +91,170 @@ using transaction_id_with_expiry_index = multi_index_container<
    >
 >;
 
+/**
+ * Incoming transactions waiting for a pending block that is able to take them.
+ *
+ * Transactions are grouped by their first authorizer. Each account's transactions are retried in arrival order, while
+ * accounts take turns ordered by the estimated CPU time they have been given since the last call to start_round(), so
+ * one busy account cannot starve everybody else. The estimate for an account is a moving average of the CPU billed
+ * to its recently accepted transactions.
+ */
+class pending_incoming_transaction_queue {
+   public:
+      static constexpr uint32_t default_cpu_estimate_us = 100;
+      static constexpr size_t   max_tracked_accounts    = 64*1024;
+
+      struct entry {
+         packed_transaction_ptr                 trx;
+         transaction_metadata_ptr               trx_meta;
+         bool                                   persist_until_expired = false;
+         next_function<transaction_trace_ptr>   next;
+         account_name                           sender;
+         fc::time_point                         expiry;
+         uint64_t                               seq = 0;
+      };
+
+      static account_name first_authorizer( const transaction& trx ) {
+         for( const auto& act : trx.actions ) {
+            if( !act.authorization.empty() )
+               return act.authorization.front().actor;
+         }
+         return account_name();
+      }
+
+      /// zero means an account may queue any number of transactions
+      void set_account_quota( uint32_t quota ) { _account_quota = quota; }
+
+      size_t size()const  { return _entries.size(); }
+      bool   empty()const { return _entries.empty(); }
+
+      /**
+       * @return false if the transaction was not queued because its first authorizer has reached its quota
+       */
+      bool push( const packed_transaction_ptr& trx, const transaction_metadata_ptr& trx_meta, bool persist_until_expired,
+                 const next_function<transaction_trace_ptr>& next ) {
+         auto sender = first_authorizer( trx_meta->trx );
+         auto& state = _senders[sender];
+         if( _account_quota && state.queued >= _account_quota )
+            return false;
+
+         auto seq = _next_seq++;
+         _entries.insert( entry{ trx, trx_meta, persist_until_expired, next, sender, trx->expiration(), seq } );
+         if( state.queued++ == 0 )
+            _ready.emplace( state.served_us, seq, sender );
+         return true;
+      }
+
+      /**
+       * Removes the next transaction in fair order whose estimated CPU usage fits within @ref cpu_budget_us
+       */
+      optional<entry> pop_next( uint64_t cpu_budget_us ) {
+         auto& by_sender = _entries.get<by_sender>();
+         for( auto ready_itr = _ready.begin(); ready_itr != _ready.end(); ++ready_itr ) {
+            const auto& sender = std::get<2>( *ready_itr );
+            auto estimate = estimated_cpu_us( sender );
+            if( estimate > cpu_budget_us ) continue;
+
+            auto itr = by_sender.find( boost::make_tuple( sender, std::get<1>( *ready_itr ) ) );
+            entry e = *itr;
+            _ready.erase( ready_itr );
+            _senders[e.sender].served_us += estimate;
+            erase_queued( by_sender, itr, false );
+            return e;
+         }
+         return optional<entry>();
+      }
+
+      /**
+       * Removes every transaction that expires before @ref now, passing each one to @ref on_expired
+       */
+      template<typename F>
+      void expire( const fc::time_point& now, F&& on_expired ) {
+         auto& by_expiry_idx = _entries.get<by_expiry>();
+         while( !by_expiry_idx.empty() && by_expiry_idx.begin()->expiry < now ) {
+            entry e = *by_expiry_idx.begin();
+            auto& by_sender = _entries.get<by_sender>();
+            erase_queued( by_sender, _entries.project<by_sender>( by_expiry_idx.begin() ), true );
+            on_expired( e );
+         }
+      }
+
+      /// resets the CPU time accounts have been given, so that every account starts the next block on equal terms
+      void start_round() {
+         _ready.clear();
+         auto& by_sender = _entries.get<by_sender>();
+         for( auto itr = _senders.begin(); itr != _senders.end(); ) {
+            if( itr->second.queued == 0 ) {
+               itr = _senders.erase( itr );
+               continue;
+            }
+            itr->second.served_us = 0;
+            auto front = by_sender.lower_bound( boost::make_tuple( itr->first ) );
+            _ready.emplace( 0, front->seq, itr->first );
+            ++itr;
+         }
+      }
+
+      void record_cpu_usage( const account_name& sender, uint32_t cpu_usage_us ) {
+         auto itr = _cpu_estimates.find( sender );
+         if( itr == _cpu_estimates.end() ) {
+            if( _cpu_estimates.size() >= max_tracked_accounts ) _cpu_estimates.clear();
+            _cpu_estimates.emplace( sender, cpu_usage_us );
+         } else {
+            itr->second = ( itr->second * 3 + cpu_usage_us ) / 4;
+         }
+      }
+
+      uint32_t estimated_cpu_us( const account_name& sender )const {
+         auto itr = _cpu_estimates.find( sender );
+         return itr != _cpu_estimates.end() ? std::max<uint32_t>( itr->second, 1 ) : default_cpu_estimate_us;
+      }
+
+   private:
+      using entry_index = multi_index_container<
+         entry,
+         indexed_by<
+            ordered_unique<tag<by_sender>,
+               composite_key< entry,
+                  BOOST_MULTI_INDEX_MEMBER(entry, account_name, sender),
+                  BOOST_MULTI_INDEX_MEMBER(entry, uint64_t, seq)
+               >
+            >,
+            ordered_non_unique<tag<by_expiry>, BOOST_MULTI_INDEX_MEMBER(entry, fc::time_point, expiry)>
+         >
+      >;
+
+      struct sender_state {
+         uint32_t queued    = 0;
+         uint64_t served_us = 0;
+      };
+
+      /**
+       * Erases a queued entry and makes the sender's next transaction, if any, ready in its place. A sender left with
+       * nothing queued is forgotten, unless it was served this round; start_round() forgets those.
+       */
+      template<typename Index>
+      void erase_queued( Index& by_sender, typename Index::iterator itr, bool may_be_ready ) {
+         auto sender = itr->sender;
+         auto& state = _senders[sender];
+         bool was_front = !may_be_ready || _ready.erase( std::make_tuple( state.served_us, itr->seq, sender ) ) > 0;
+         itr = by_sender.erase( itr );
+         if( --state.queued == 0 && state.served_us == 0 ) {
+            _senders.erase( sender );
+            return;
+         }
+         if( was_front && itr != by_sender.end() && itr->sender == sender )
+            _ready.emplace( state.served_us, itr->seq, sender );
+      }
+
+      entry_index                                             _entries;
+      std::map<account_name, sender_state>                    _senders;
+      std::set<std::tuple<uint64_t, uint64_t, account_name>>  _ready; ///< (served_us, seq, sender) of each sender's oldest entry
+      std::map<account_name, uint32_t>                        _cpu_estimates;
+      uint64_t                                                _next_seq = 0;
+      uint32_t                                                _account_quota = 0;
+};
+
 enum class pending_block_mode {
    producing,
    speculating
@@ -106,6 +276,41 @@ enum class pending_block_mode {
       NEXT(e.dynamic_copy_exception());\
    }
 
+/**
+ * Moving statistics of how long producing a block takes, from the production timer firing to the block being committed.
+ */
+struct production_timing {
+   static constexpr double  sample_weight = 0.1;
+   static constexpr int64_t max_lead_us   = config::block_interval_us / 2;
+
+   double   avg_produce_us         = 0; ///< finalizing, signing and committing
+   double   var_produce_us         = 0;
+   double   avg_sign_us            = 0;
+   double   avg_timer_lateness_us  = 0; ///< how late the production timer fired relative to its deadline
+   uint32_t blocks_measured        = 0;
+
+   void add_sample(int64_t produce_us, int64_t sign_us, optional<int64_t> timer_lateness_us) {
+      if (blocks_measured++ == 0) {
+         avg_produce_us = produce_us;
+         avg_sign_us = sign_us;
+         avg_timer_lateness_us = timer_lateness_us ? std::max<int64_t>(*timer_lateness_us, 0) : 0;
+         return;
+      }
+      auto delta = produce_us - avg_produce_us;
+      avg_produce_us += sample_weight * delta;
+      var_produce_us = (1 - sample_weight) * (var_produce_us + sample_weight * delta * delta);
+      avg_sign_us += sample_weight * (sign_us - avg_sign_us);
+      if (timer_lateness_us)
+         avg_timer_lateness_us += sample_weight * (std::max<int64_t>(*timer_lateness_us, 0) - avg_timer_lateness_us);
+   }
+
+   /// how long before its target time production of a block should be started
+   int64_t predicted_lead_us() const {
+      auto lead = avg_produce_us + 2 * std::sqrt(var_produce_us) + avg_timer_lateness_us;
+      return std::min<int64_t>(lead, int64_t(max_lead_us));
+   }
+};
+
 class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin_impl> {
    public:
       producer_plugin_impl(boost::asio::io_service& io)
@@ -136,6 +341,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       fc::microseconds                                          _max_irreversible_block_age_us;
       int32_t                                                   _produce_time_offset_us = 0;
       int32_t                                                   _last_block_time_offset_us = 0;
+      bool                                                      _adaptive_block_cutoff = false;
+      production_timing                                         _production_timing;
+      optional<fc::time_point>                                  _scheduled_production_time;
+      bool                                                      _pending_block_is_last = false;
       fc::time_point                                            _irreversible_block_time;
       fc::microseconds                                          _keosd_provider_timeout_us;
 
@@ -342,12 +551,32 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
       }
 
-      std::deque<std::tuple<packed_transaction_ptr, bool, next_function<transaction_trace_ptr>>> _pending_incoming_transactions;
+      pending_incoming_transaction_queue _pending_incoming_transactions;
 
-      void on_incoming_transaction_async(const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
+      /**
+       * Holds on to a transaction until a pending block can take it. The transaction is unpacked once, and the same
+       * transaction_metadata, with its ids and signing keys, is reused by every retry. The keys are recovered on the
+       * controller thread pool while the transaction waits.
+       */
+      void queue_incoming_transaction(const packed_transaction_ptr& trx, transaction_metadata_ptr trx_meta,
+                                      bool persist_until_expired, const next_function<transaction_trace_ptr>& next) {
+         if (!trx_meta) {
+            trx_meta = std::make_shared<transaction_metadata>(*trx);
+            app().get_plugin<chain_plugin>().chain().recover_keys_async(trx_meta);
+         }
+         if (!_pending_incoming_transactions.push(trx, trx_meta, persist_until_expired, next)) {
+            auto e_ptr = std::static_pointer_cast<fc::exception>(std::make_shared<tx_queue_quota_exceeded>(
+                  FC_LOG_MESSAGE(error, "too many queued transactions from the authorizer of transaction ${id}", ("id", trx->id())) ));
+            next(e_ptr);
+            _transaction_ack_channel.publish(std::pair<fc::exception_ptr, packed_transaction_ptr>(e_ptr, trx));
+         }
+      }
+
+      void on_incoming_transaction_async(const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next,
+                                         transaction_metadata_ptr trx_meta = transaction_metadata_ptr()) {
          chain::controller& chain = app().get_plugin<chain_plugin>().chain();
          if (!chain.pending_block_state()) {
-            _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+            queue_incoming_transaction(trx, std::move(trx_meta), persist_until_expired, next);
             return;
          }
 
@@ -393,18 +622,16 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
             return;
          }
 
-         auto deadline = fc::time_point::now() + fc::milliseconds(_max_transaction_time_ms);
+         fc::time_point deadline;
          bool deadline_is_subjective = false;
-         if (_max_transaction_time_ms < 0 || (_pending_block_mode == pending_block_mode::producing && block_time < deadline) ) {
-            deadline_is_subjective = true;
-            deadline = block_time;
-         }
+         std::tie(deadline, deadline_is_subjective) = calculate_transaction_deadline(block_time);
 
          try {
-            auto trace = chain.push_transaction(std::make_shared<transaction_metadata>(*trx), deadline);
+            if (!trx_meta) trx_meta = std::make_shared<transaction_metadata>(*trx);
+            auto trace = chain.push_transaction(trx_meta, deadline);
             if (trace->except) {
                if (failure_is_subjective(*trace->except, deadline_is_subjective)) {
-                  _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+                  queue_incoming_transaction(trx, trx_meta, persist_until_expired, next);
                   if (_pending_block_mode == pending_block_mode::producing) {
                      fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} COULD NOT FIT, tx: ${txid} RETRYING ",
                              ("block_num", chain.head_block_num() + 1)
@@ -419,6 +646,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                   send_response(e_ptr);
                }
             } else {
+               if (trace->receipt) {
+                  _pending_incoming_transactions.record_cpu_usage(pending_incoming_transaction_queue::first_authorizer(trx_meta->trx),
+                                                                  trace->receipt->cpu_usage_us);
+               }
                if (persist_until_expired) {
                   // if this trx didnt fail/soft-fail and the persist flag is set, store its ID so that we can
                   // ensure its applied to all future speculative blocks as well.
@@ -448,6 +679,34 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          return !_production_enabled || _pause_production || (_max_irreversible_block_age_us.count() >= 0 && get_irreversible_block_age() >= _max_irreversible_block_age_us);
       }
 
+      /**
+       * The offset from a block's timestamp at which its production is started. With the adaptive cut-off enabled the
+       * configured offset becomes the target time for the block to be finished by, and production starts early enough
+       * to cover the measured time it takes to finalize, sign and commit a block.
+       */
+      int32_t effective_time_offset_us(bool last_block) const {
+         int32_t configured = last_block ? _last_block_time_offset_us : _produce_time_offset_us;
+         if (!_adaptive_block_cutoff || _production_timing.blocks_measured == 0)
+            return configured;
+         return configured - static_cast<int32_t>(_production_timing.predicted_lead_us());
+      }
+
+      /**
+       * @return the deadline of a transaction pushed into the pending block, and whether reaching it is subjective
+       */
+      std::pair<fc::time_point, bool> calculate_transaction_deadline(const fc::time_point& block_time) const {
+         auto deadline = fc::time_point::now() + fc::milliseconds(_max_transaction_time_ms);
+         auto cutoff = block_time;
+         if (_adaptive_block_cutoff) {
+            // no transaction should hold up production past the adapted cut-off
+            cutoff = std::min(cutoff, block_time + fc::microseconds(effective_time_offset_us(_pending_block_is_last)));
+         }
+         if (_max_transaction_time_ms < 0 || (_pending_block_mode == pending_block_mode::producing && cutoff < deadline)) {
+            return std::make_pair(cutoff, true);
+         }
+         return std::make_pair(deadline, false);
+      }
+
       enum class start_block_result {
          succeeded,
          failed,
@@ -526,8 +785,12 @@ void producer_plugin::set_program_options(
           "offset of non last block producing time in microseconds. Negative number results in blocks to go out sooner, and positive number results in blocks to go out later")
          ("last-block-time-offset-us", boost::program_options::value<int32_t>()->default_value(0),
           "offset of last block producing time in microseconds. Negative number results in blocks to go out sooner, and positive number results in blocks to go out later")
+         ("adaptive-block-cutoff", bpo::value<bool>()->default_value(false),
+          "Start producing each block early enough to cover the measured time it takes to finalize, sign and commit it, so that it is finished by its produce-time-offset-us or last-block-time-offset-us rather than started at it")
          ("incoming-defer-ratio", bpo::value<double>()->default_value(1.0),
           "ratio between incoming transations and deferred transactions when both are exhausted")
+         ("incoming-transaction-queue-account-quota", bpo::value<uint32_t>()->default_value(0),
+          "Maximum number of incoming transactions sharing the same first authorizer that may wait for a block at any one time (0 for no limit)")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
          ;
@@ -652,12 +915,16 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
 
    my->_last_block_time_offset_us = options.at("last-block-time-offset-us").as<int32_t>();
 
+   my->_adaptive_block_cutoff = options.at("adaptive-block-cutoff").as<bool>();
+
    my->_max_transaction_time_ms = options.at("max-transaction-time").as<int32_t>();
 
    my->_max_irreversible_block_age_us = fc::seconds(options.at("max-irreversible-block-age").as<int32_t>());
 
    my->_incoming_defer_ratio = options.at("incoming-defer-ratio").as<double>();
 
+   my->_pending_incoming_transactions.set_account_quota(options.at("incoming-transaction-queue-account-quota").as<uint32_t>());
+
    if( options.count( "snapshots-dir" )) {
       auto sd = options.at( "snapshots-dir" ).as<bfs::path>();
       if( sd.is_relative()) {
@@ -807,6 +1074,10 @@ void producer_plugin::update_runtime_options(const runtime_options& options) {
       my->_incoming_defer_ratio = *options.incoming_defer_ratio;
    }
 
+   if (options.adaptive_block_cutoff) {
+      my->_adaptive_block_cutoff = *options.adaptive_block_cutoff;
+   }
+
    if (check_speculating && my->_pending_block_mode == pending_block_mode::speculating) {
       chain::controller& chain = app().get_plugin<chain_plugin>().chain();
       chain.abort_block();
@@ -824,10 +1095,27 @@ producer_plugin::runtime_options producer_plugin::get_runtime_options() const {
       my->_max_transaction_time_ms,
       my->_max_irreversible_block_age_us.count() < 0 ? -1 : my->_max_irreversible_block_age_us.count() / 1'000'000,
       my->_produce_time_offset_us,
-      my->_last_block_time_offset_us
+      my->_last_block_time_offset_us,
+      {},
+      {},
+      my->_adaptive_block_cutoff
    };
 }
 
+producer_plugin::production_timing_information producer_plugin::get_production_timing() const {
+   const auto& timing = my->_production_timing;
+   production_timing_information info;
+   info.adaptive_block_cutoff = my->_adaptive_block_cutoff;
+   info.effective_produce_time_offset_us = my->effective_time_offset_us(false);
+   info.effective_last_block_time_offset_us = my->effective_time_offset_us(true);
+   info.avg_produce_us = static_cast<int64_t>(timing.avg_produce_us);
+   info.stddev_produce_us = static_cast<int64_t>(std::sqrt(timing.var_produce_us));
+   info.avg_sign_us = static_cast<int64_t>(timing.avg_sign_us);
+   info.avg_timer_lateness_us = static_cast<int64_t>(timing.avg_timer_lateness_us);
+   info.blocks_measured = timing.blocks_measured;
+   return info;
+}
+
 void producer_plugin::add_greylist_accounts(const greylist_params& params) {
    chain::controller& chain = app().get_plugin<chain_plugin>().chain();
    for (auto &acc : params.accounts) {
@@ -1017,6 +1305,7 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
 
    // Not our turn
    last_block = ((block_timestamp_type(block_time).slot % config::producer_repetitions) == config::producer_repetitions - 1);
+   _pending_block_is_last = last_block;
    const auto& scheduled_producer = hbs->get_scheduled_producer(block_time);
    auto currrent_watermark_itr = _producer_watermarks.find(scheduled_producer.producer_name);
    auto signature_provider_itr = _signature_providers.find(scheduled_producer.block_signing_key);
@@ -1118,6 +1407,21 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                 ("expired", num_expired_persistent));
       }
 
+      // answer queued transactions that can no longer be applied before spending any time on the rest
+      _pending_incoming_transactions.expire(pbs->header.timestamp.to_time_point(), [&](const pending_incoming_transaction_queue::entry& e) {
+         auto id = e.trx->id();
+         fc_dlog(_trx_trace_log, "[TRX_TRACE] Pending transaction queue is EXPIRING tx: ${txid}", ("txid", id));
+         auto e_ptr = std::static_pointer_cast<fc::exception>(std::make_shared<expired_tx_exception>(FC_LOG_MESSAGE(error, "expired transaction ${id}", ("id", id)) ));
+         e.next(e_ptr);
+         _transaction_ack_channel.publish(std::pair<fc::exception_ptr, packed_transaction_ptr>(e_ptr, e.trx));
+      });
+      _pending_incoming_transactions.start_round();
+
+      // pops the next queued incoming transaction, in fair order, that is expected to fit in what is left of the block
+      auto next_pending_incoming_transaction = [&]() {
+         return _pending_incoming_transactions.pop_next(chain.get_resource_limits_manager().get_block_cpu_limit());
+      };
+
       try {
          size_t orig_pending_txn_size = _pending_incoming_transactions.size();
 
@@ -1171,12 +1475,9 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                   num_processed++;
 
                   try {
-                     auto deadline = fc::time_point::now() + fc::milliseconds(_max_transaction_time_ms);
+                     fc::time_point deadline;
                      bool deadline_is_subjective = false;
-                     if (_max_transaction_time_ms < 0 || (_pending_block_mode == pending_block_mode::producing && block_time < deadline)) {
-                        deadline_is_subjective = true;
-                        deadline = block_time;
-                     }
+                     std::tie(deadline, deadline_is_subjective) = calculate_transaction_deadline(block_time);
 
                      auto trace = chain.push_transaction(trx, deadline);
                      if (trace->except) {
@@ -1222,6 +1523,16 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                       ("expired", num_expired));
             }
 
+            try {
+               auto num_expired = chain.retire_expired_scheduled_transactions(block_time);
+               if (num_expired) {
+                  fc_dlog(_log, "Retired ${n} expired scheduled transactions", ("n", num_expired));
+               }
+            } catch ( const guard_exception& e ) {
+               app().get_plugin<chain_plugin>().handle_guard_exception(e);
+               return start_block_result::failed;
+            } FC_LOG_AND_DROP();
+
             auto scheduled_trxs = chain.get_scheduled_transactions();
             if (!scheduled_trxs.empty()) {
                int num_applied = 0;
@@ -1237,12 +1548,12 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                   num_processed++;
 
                   // configurable ratio of incoming txns vs deferred txns
-                  while (_incoming_trx_weight >= 1.0 && orig_pending_txn_size && _pending_incoming_transactions.size()) {
-                     auto e = _pending_incoming_transactions.front();
-                     _pending_incoming_transactions.pop_front();
+                  while (_incoming_trx_weight >= 1.0 && orig_pending_txn_size) {
+                     auto e = next_pending_incoming_transaction();
+                     if (!e) break;
                      --orig_pending_txn_size;
                      _incoming_trx_weight -= 1.0;
-                     on_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+                     on_incoming_transaction_async(e->trx, e->persist_until_expired, e->next, e->trx_meta);
                   }
 
                   if (block_time <= fc::time_point::now()) {
@@ -1255,12 +1566,9 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                   }
 
                   try {
-                     auto deadline = fc::time_point::now() + fc::milliseconds(_max_transaction_time_ms);
+                     fc::time_point deadline;
                      bool deadline_is_subjective = false;
-                     if (_max_transaction_time_ms < 0 || (_pending_block_mode == pending_block_mode::producing && block_time < deadline)) {
-                        deadline_is_subjective = true;
-                        deadline = block_time;
-                     }
+                     std::tie(deadline, deadline_is_subjective) = calculate_transaction_deadline(block_time);
 
                      auto trace = chain.push_scheduled_transaction(trx, deadline);
                      if (trace->except) {
@@ -1300,12 +1608,12 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
             _incoming_trx_weight = 0.0;
 
             if (!_pending_incoming_transactions.empty()) {
-               fc_dlog(_log, "Processing ${n} pending transactions");
-               while (orig_pending_txn_size && _pending_incoming_transactions.size()) {
-                  auto e = _pending_incoming_transactions.front();
-                  _pending_incoming_transactions.pop_front();
+               fc_dlog(_log, "Processing ${n} pending transactions", ("n", _pending_incoming_transactions.size()));
+               while (orig_pending_txn_size) {
+                  auto e = next_pending_incoming_transaction();
+                  if (!e) break;
                   --orig_pending_txn_size;
-                  on_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+                  on_incoming_transaction_async(e->trx, e->persist_until_expired, e->next, e->trx_meta);
                   if (block_time <= fc::time_point::now()) return start_block_result::exhausted;
                }
             }
@@ -1357,11 +1665,13 @@ void producer_plugin_impl::schedule_production_loop() {
       if (result == start_block_result::succeeded) {
          // ship this block off no later than its deadline
          EOS_ASSERT( chain.pending_block_state(), missing_pending_block_state, "producing without pending_block_state, start_block succeeded" );
-         auto deadline = chain.pending_block_time().time_since_epoch().count() + (last_block ? _last_block_time_offset_us : _produce_time_offset_us);
+         auto deadline = chain.pending_block_time().time_since_epoch().count() + effective_time_offset_us(last_block);
+         _scheduled_production_time = fc::time_point(fc::microseconds(deadline));
          _timer.expires_at( epoch + boost::posix_time::microseconds( deadline ));
          fc_dlog(_log, "Scheduling Block Production on Normal Block #${num} for ${time}", ("num", chain.pending_block_state()->block_num)("time",deadline));
       } else {
          EOS_ASSERT( chain.pending_block_state(), missing_pending_block_state, "producing without pending_block_state" );
+         _scheduled_production_time.reset();
          auto expect_time = chain.pending_block_time() - fc::microseconds(config::block_interval_us);
          // ship this block off up to 1 block time earlier or immediately
          if (fc::time_point::now() >= expect_time) {
@@ -1474,14 +1784,26 @@ void producer_plugin_impl::produce_block() {
 
    EOS_ASSERT(signature_provider_itr != _signature_providers.end(), producer_priv_key_not_found, "Attempting to produce a block for which we don't have the private key");
 
+   const auto produce_start = fc::time_point::now();
+   optional<int64_t> timer_lateness_us;
+   if (_scheduled_production_time) {
+      timer_lateness_us = (produce_start - *_scheduled_production_time).count();
+      _scheduled_production_time.reset();
+   }
+
    //idump( (fc::time_point::now() - chain.pending_block_time()) );
    chain.finalize_block();
+   fc::microseconds sign_time;
    chain.sign_block( [&]( const digest_type& d ) {
       auto debug_logger = maybe_make_debug_time_logger();
-      return signature_provider_itr->second(d);
+      auto sign_start = fc::time_point::now();
+      auto sig = signature_provider_itr->second(d);
+      sign_time = fc::time_point::now() - sign_start;
+      return sig;
    } );
 
    chain.commit_block();
+   _production_timing.add_sample((fc::time_point::now() - produce_start).count(), sign_time.count(), timer_lateness_us);
    auto hbt = chain.head_block_time();
    //idump((fc::time_point::now() - hbt));
 
@@ -5,7 +5,12 @@
 #pragma once
 
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <stdint.h>
 
 #include <eosio/chain/exceptions.hpp>
@@ -64,7 +69,9 @@ class state_history_log {
    std::fstream         index;
    uint32_t             _begin_block = 0;
    uint32_t             _end_block   = 0;
+   uint32_t             _irreversible_end = 0; // entries below this were irreversible when written, so are never truncated
    chain::block_id_type last_block_id;
+   std::shared_ptr<boost::interprocess::mapped_region> log_mapping; // read-only, for get_mapped_entry
 
  public:
    state_history_log(const char* const name, std::string log_filename, std::string index_filename)
@@ -77,6 +84,12 @@ class state_history_log {
 
    uint32_t begin_block() const { return _begin_block; }
    uint32_t end_block() const { return _end_block; }
+   uint32_t irreversible_end() const { return _irreversible_end; }
+
+   // records that the entries up to block_num, if already written, can no longer be removed by a fork
+   void mark_irreversible(uint32_t block_num) {
+      _irreversible_end = std::max(_irreversible_end, std::min(block_num + 1, _end_block));
+   }
 
    template <typename F>
    void write_entry(const state_history_log_header& header, const chain::block_id_type& prev_id, F write_payload) {
@@ -124,6 +137,18 @@ class state_history_log {
       return log;
    }
 
+   // returns the payload inside a read-only mapping of the log, which the result keeps alive. The payload stays
+   // readable until truncate() removes its entry; a remap for later entries does not unmap it.
+   std::shared_ptr<const char> get_mapped_entry(uint32_t block_num, state_history_log_header& header) {
+      EOS_ASSERT(block_num >= _begin_block && block_num < _end_block, chain::plugin_exception,
+                 "read non-existing block in ${name}.log", ("name", name));
+      uint64_t pos = get_pos(block_num);
+      map_log(pos + sizeof(header));
+      memcpy(&header, (const char*)log_mapping->get_address() + pos, sizeof(header));
+      map_log(pos + sizeof(header) + header.payload_size);
+      return std::shared_ptr<const char>(log_mapping, (const char*)log_mapping->get_address() + pos + sizeof(header));
+   }
+
    chain::block_id_type get_block_id(uint32_t block_num) {
       state_history_log_header header;
       get_entry(block_num, header);
@@ -131,6 +156,15 @@ class state_history_log {
    }
 
  private:
+   void map_log(uint64_t size) {
+      if (log_mapping && size <= log_mapping->get_size())
+         return;
+      log.flush();
+      boost::interprocess::file_mapping f(log_filename.c_str(), boost::interprocess::read_only);
+      log_mapping = std::make_shared<boost::interprocess::mapped_region>(f, boost::interprocess::read_only);
+      EOS_ASSERT(size <= log_mapping->get_size(), chain::plugin_exception, "corrupt ${name}.log (9)", ("name", name));
+   }
+
    bool get_last_block(uint64_t size) {
       state_history_log_header header;
       uint64_t                 suffix;
@@ -251,6 +285,7 @@ class state_history_log {
    }
 
    void truncate(uint32_t block_num) {
+      log_mapping.reset();
       log.flush();
       index.flush();
       uint64_t num_removed = 0;
@@ -270,10 +305,104 @@ class state_history_log {
          boost::filesystem::resize_file(index_filename, (block_num - _begin_block) * sizeof(state_history_summary));
          _end_block = block_num;
       }
+      _irreversible_end = std::min(_irreversible_end, _end_block);
       log.sync();
       index.sync();
       ilog("fork or replay: removed ${n} blocks from ${name}.log", ("n", num_removed)("name", name));
    }
 }; // state_history_log
 
+/*
+ *   <block_num>.checkpoint:
+ *   +--------+---------+
+ *   | Header | Payload |
+ *   +--------+---------+
+ *
+ * header:
+ *    state_history_log_header of the block, payload_size is the size of the payload
+ *
+ * payload:
+ *    char[]      compressed deltas which create every row of the state after the block
+ */
+class state_history_checkpoints {
+ private:
+   boost::filesystem::path dir;
+   uint32_t                max_checkpoints = 0;
+   std::mutex              mutex; // guards block_nums
+   std::set<uint32_t>      block_nums;
+
+ public:
+   state_history_checkpoints(boost::filesystem::path dir, uint32_t max_checkpoints)
+       : dir(std::move(dir))
+       , max_checkpoints(max_checkpoints) {
+      boost::filesystem::create_directories(this->dir);
+      for (boost::filesystem::directory_iterator it(this->dir), end; it != end; ++it) {
+         if (it->path().extension() == ".tmp")
+            boost::filesystem::remove(it->path());
+         else if (it->path().extension() == ".checkpoint")
+            block_nums.insert(std::stoul(it->path().stem().string()));
+      }
+      if (!block_nums.empty())
+         ilog("chain state checkpoints at blocks ${b}-${e}", ("b", *block_nums.begin())("e", *block_nums.rbegin()));
+   }
+
+   // checkpoints are written in block order, so the ones past header.block_num belong to a fork which was abandoned
+   void write(const state_history_log_header& header, const chain::bytes& payload) {
+      EOS_ASSERT(header.payload_size == payload.size(), chain::plugin_exception, "checkpoint has incorrect size");
+      auto tmp = filename(header.block_num);
+      tmp += ".tmp";
+      {
+         std::ofstream f(tmp.string(), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+         f.write((char*)&header, sizeof(header));
+         f.write(payload.data(), payload.size());
+         f.flush();
+         EOS_ASSERT(f.good(), chain::plugin_exception, "unable to write ${f}", ("f", tmp.string()));
+      }
+      boost::filesystem::rename(tmp, filename(header.block_num));
+
+      std::lock_guard<std::mutex> g(mutex);
+      block_nums.insert(header.block_num);
+      while (*block_nums.rbegin() > header.block_num)
+         remove(*block_nums.rbegin());
+      while (block_nums.size() > max_checkpoints)
+         remove(*block_nums.begin());
+   }
+
+   /// the newest checkpoint at or before block_num
+   fc::optional<uint32_t> find(uint32_t block_num) {
+      std::lock_guard<std::mutex> g(mutex);
+      auto                        it = block_nums.upper_bound(block_num);
+      if (it == block_nums.begin())
+         return {};
+      return *--it;
+   }
+
+   /// returns false if the checkpoint was removed
+   bool read(uint32_t block_num, state_history_log_header& header, chain::bytes& payload) {
+      std::ifstream f(filename(block_num).string(), std::ios_base::binary | std::ios_base::in);
+      if (!f.is_open())
+         return false;
+      f.seekg(0, std::ios_base::end);
+      uint64_t size = f.tellg();
+      f.seekg(0);
+      f.read((char*)&header, sizeof(header));
+      EOS_ASSERT(size >= sizeof(header) && header.block_num == block_num && header.version == 0 &&
+                     header.payload_size == size - sizeof(header),
+                 chain::plugin_exception, "corrupt checkpoint ${f}", ("f", filename(block_num).string()));
+      payload.resize(header.payload_size);
+      f.read(payload.data(), payload.size());
+      return true;
+   }
+
+ private:
+   boost::filesystem::path filename(uint32_t block_num) const {
+      return dir / (std::to_string(block_num) + ".checkpoint");
+   }
+
+   void remove(uint32_t block_num) {
+      boost::filesystem::remove(filename(block_num));
+      block_nums.erase(block_num);
+   }
+}; // state_history_checkpoints
+
 } // namespace eosio
@@ -69,8 +69,18 @@ struct get_blocks_result_v0 {
    fc::optional<bytes>          deltas;
 };
 
-using state_request = fc::static_variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0>;
-using state_result  = fc::static_variant<get_status_result_v0, get_blocks_result_v0>;
+struct get_checkpoint_request_v0 {
+   uint32_t block_num = 0;
+};
+
+struct get_checkpoint_result_v0 {
+   fc::optional<block_position> block;
+   fc::optional<bytes>          deltas;
+};
+
+using state_request = fc::static_variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0,
+                                         get_checkpoint_request_v0>;
+using state_result  = fc::static_variant<get_status_result_v0, get_blocks_result_v0, get_checkpoint_result_v0>;
 
 class state_history_plugin : public plugin<state_history_plugin> {
  public:
@@ -98,4 +108,5 @@ FC_REFLECT_EMPTY(eosio::get_status_request_v0);
 FC_REFLECT(eosio::get_status_result_v0, (head)(last_irreversible)(trace_begin_block)(trace_end_block)(chain_state_begin_block)(chain_state_end_block));
 FC_REFLECT(eosio::get_blocks_request_v0, (start_block_num)(end_block_num)(max_messages_in_flight)(have_positions)(irreversible_only)(fetch_block)(fetch_traces)(fetch_deltas));
 FC_REFLECT(eosio::get_blocks_ack_request_v0, (num_messages));
+FC_REFLECT(eosio::get_checkpoint_request_v0, (block_num));
 // clang-format on
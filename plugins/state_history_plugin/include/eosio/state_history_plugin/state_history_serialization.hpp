@@ -554,4 +554,11 @@ datastream<ST>& operator<<(datastream<ST>& ds, const eosio::get_blocks_result_v0
    return ds;
 }
 
+template <typename ST>
+datastream<ST>& operator<<(datastream<ST>& ds, const eosio::get_checkpoint_result_v0& obj) {
+   fc::raw::pack(ds, obj.block);
+   history_pack_big_bytes(ds, obj.deltas);
+   return ds;
+}
+
 } // namespace fc
@@ -10,7 +10,9 @@
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
@@ -18,6 +20,12 @@
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/signals2/connection.hpp>
 
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
 using tcp    = boost::asio::ip::tcp;
 namespace ws = boost::beast::websocket;
 
@@ -57,7 +65,10 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    chain_plugin*                                        chain_plug = nullptr;
    fc::optional<state_history_log>                      trace_log;
    fc::optional<state_history_log>                      chain_state_log;
-   bool                                                 stopping = false;
+   fc::optional<state_history_checkpoints>              checkpoints;
+   uint32_t                                             checkpoint_interval = 0;
+   std::atomic<bool>                                    stopping{false};
+   fc::optional<scoped_connection>                      accepted_transaction_connection;
    fc::optional<scoped_connection>                      applied_transaction_connection;
    fc::optional<scoped_connection>                      accepted_block_connection;
    string                                               endpoint_address = "0.0.0.0";
@@ -65,18 +76,60 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    std::unique_ptr<tcp::acceptor>                       acceptor;
    std::map<transaction_id_type, transaction_trace_ptr> cached_traces;
    transaction_trace_ptr                                onblock_trace;
+   std::vector<transaction_trace_ptr>                   implicit_traces; // of the recurring actions, in order
+   std::set<transaction_id_type>                        implicit_ids;
+
+   // traces and deltas are packed and compressed on thread_pool, then appended to the logs by writer in block order
+   uint16_t                                             thread_pool_size = 2;
+   fc::optional<boost::asio::thread_pool>               thread_pool;
+   fc::optional<boost::asio::thread_pool>               writer;
+   std::mutex                                           log_mutex; // guards trace_log and chain_state_log
+   bool                                                 chain_state_fresh = false; // no log or checkpoint has the state
+
+   // sessions run on ship_threads; the main thread, which owns the chain, publishes position for them
+   struct chain_position {
+      block_position head;
+      block_position last_irreversible;
+      uint32_t       stored_block_num = 0; // last block written to the logs
+   };
+   uint16_t                                             network_threads = 2;
+   fc::optional<boost::asio::io_service>                ship_ios;
+   fc::optional<boost::asio::io_service::work>          ship_ios_work;
+   std::vector<std::thread>                             ship_threads;
+   std::mutex                                           position_mutex; // guards position
+   chain_position                                       position;
+
+   void update_position(uint32_t stored_block_num) {
+      auto&                       chain = chain_plug->chain();
+      std::lock_guard<std::mutex> g(position_mutex);
+      position.head              = {chain.head_block_num(), chain.head_block_id()};
+      position.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+      position.stored_block_num  = stored_block_num;
+   }
 
-   void get_log_entry(state_history_log& log, uint32_t block_num, fc::optional<bytes>& result) {
+   struct log_payload {
+      std::shared_ptr<const char> data; // keeps the log's mapping, or a copy of the payload, alive
+      uint32_t                    size = 0;
+   };
+
+   /// entries which were irreversible when written point into the log's mapping; a fork may still truncate the others,
+   /// so they are copied while log_mutex keeps the writer out
+   fc::optional<log_payload> get_log_entry(state_history_log& log, uint32_t block_num) {
+      std::lock_guard<std::mutex> g(log_mutex);
       if (block_num < log.begin_block() || block_num >= log.end_block())
-         return;
+         return {};
       state_history_log_header header;
-      auto&                    stream = log.get_entry(block_num, header);
+      auto                     entry = log.get_mapped_entry(block_num, header);
       uint32_t                 s;
-      stream.read((char*)&s, sizeof(s));
-      result.emplace();
-      result->resize(s);
-      if (s)
-         stream.read(result->data(), s);
+      memcpy(&s, entry.get(), sizeof(s));
+      EOS_ASSERT(sizeof(s) + s <= header.payload_size, plugin_exception, "corrupt entry for block ${b}",
+                 ("b", block_num));
+      log_payload result{std::shared_ptr<const char>(entry, entry.get() + sizeof(s)), s};
+      if (block_num >= log.irreversible_end()) {
+         auto copy   = std::make_shared<bytes>(result.data.get(), result.data.get() + s);
+         result.data = std::shared_ptr<const char>(copy, copy->data());
+      }
+      return result;
    }
 
    void get_block(uint32_t block_num, fc::optional<bytes>& result) {
@@ -89,11 +142,20 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       result = fc::raw::pack(*p);
    }
 
-   fc::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+   fc::optional<chain::block_id_type> get_log_block_id(uint32_t block_num) {
+      std::lock_guard<std::mutex> g(log_mutex);
       if (trace_log && block_num >= trace_log->begin_block() && block_num < trace_log->end_block())
          return trace_log->get_block_id(block_num);
       if (chain_state_log && block_num >= chain_state_log->begin_block() && block_num < chain_state_log->end_block())
          return chain_state_log->get_block_id(block_num);
+      return {};
+   }
+
+   /// falls back to the block log, so only runs on the main thread
+   fc::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+      auto id = get_log_block_id(block_num);
+      if (id)
+         return id;
       try {
          auto block = chain_plug->chain().fetch_block_by_number(block_num);
          if (block)
@@ -103,17 +165,45 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       return {};
    }
 
+   chain_position get_position() {
+      std::lock_guard<std::mutex> g(position_mutex);
+      return position;
+   }
+
+   /// a message, and the log payloads which it sends without copying
+   struct send_buffer {
+      std::vector<char>         head;
+      fc::optional<log_payload> traces;
+      std::vector<char>         middle;
+      fc::optional<log_payload> deltas;
+
+      std::vector<boost::asio::const_buffer> buffers() const {
+         std::vector<boost::asio::const_buffer> result{boost::asio::buffer(head)};
+         if (traces)
+            result.push_back(boost::asio::buffer(traces->data.get(), traces->size));
+         if (!middle.empty())
+            result.push_back(boost::asio::buffer(middle));
+         if (deltas)
+            result.push_back(boost::asio::buffer(deltas->data.get(), deltas->size));
+         return result;
+      }
+   };
+
    struct session : std::enable_shared_from_this<session> {
       std::shared_ptr<state_history_plugin_impl> plugin;
+      boost::asio::io_service::strand            strand; // runs everything below on the network threads
       std::unique_ptr<ws::stream<tcp::socket>>   socket_stream;
       bool                                       sending  = false;
       bool                                       sent_abi = false;
-      std::vector<std::vector<char>>             send_queue;
+      std::deque<send_buffer>                    send_queue;
       fc::optional<get_blocks_request_v0>        current_request;
+      uint32_t                                   request_num = 0; // drops main thread results for older requests
+      bool                                       waiting_for_main    = false;
       bool                                       need_to_send_update = false;
 
       session(std::shared_ptr<state_history_plugin_impl> plugin)
-          : plugin(std::move(plugin)) {}
+          : plugin(std::move(plugin))
+          , strand(*this->plugin->ship_ios) {}
 
       void start(tcp::socket socket) {
          ilog("incoming connection");
@@ -122,18 +212,20 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          socket_stream->next_layer().set_option(boost::asio::ip::tcp::no_delay(true));
          socket_stream->next_layer().set_option(boost::asio::socket_base::send_buffer_size(1024 * 1024));
          socket_stream->next_layer().set_option(boost::asio::socket_base::receive_buffer_size(1024 * 1024));
-         socket_stream->async_accept([self = shared_from_this(), this](boost::system::error_code ec) {
-            callback(ec, "async_accept", [&] {
-               start_read();
-               send(state_history_plugin_abi);
-            });
-         });
+         socket_stream->async_accept(
+             boost::asio::bind_executor(strand, [self = shared_from_this(), this](boost::system::error_code ec) {
+                callback(ec, "async_accept", [&] {
+                   start_read();
+                   send(state_history_plugin_abi);
+                });
+             }));
       }
 
       void start_read() {
          auto in_buffer = std::make_shared<boost::beast::flat_buffer>();
          socket_stream->async_read(
-             *in_buffer, [self = shared_from_this(), this, in_buffer](boost::system::error_code ec, size_t) {
+             *in_buffer, boost::asio::bind_executor(strand, [self = shared_from_this(), this,
+                                                             in_buffer](boost::system::error_code ec, size_t) {
                 callback(ec, "async_read", [&] {
                    auto d = boost::asio::buffer_cast<char const*>(boost::beast::buffers_front(in_buffer->data()));
                    auto s = boost::asio::buffer_size(in_buffer->data());
@@ -143,17 +235,40 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
                    req.visit(*this);
                    start_read();
                 });
-             });
+             }));
       }
 
       void send(const char* s) {
-         send_queue.push_back({s, s + strlen(s)});
+         send_queue.emplace_back();
+         send_queue.back().head.assign(s, s + strlen(s));
          send();
       }
 
       template <typename T>
       void send(T obj) {
-         send_queue.push_back(fc::raw::pack(state_result{std::move(obj)}));
+         send_queue.emplace_back();
+         send_queue.back().head = fc::raw::pack(state_result{std::move(obj)});
+         send();
+      }
+
+      void send(get_blocks_result_v0 result, fc::optional<log_payload> traces, fc::optional<log_payload> deltas) {
+         auto pack_presence = [](std::vector<char>& v, const fc::optional<log_payload>& p) {
+            auto flag = fc::raw::pack(p.valid());
+            v.insert(v.end(), flag.begin(), flag.end());
+            if (p) {
+               auto size = fc::raw::pack(fc::unsigned_int(p->size));
+               v.insert(v.end(), size.begin(), size.end());
+            }
+         };
+         send_queue.emplace_back();
+         auto& buf = send_queue.back();
+         // result.traces and result.deltas are empty, which packed as their last 2 bytes; the payloads follow instead
+         buf.head = fc::raw::pack(state_result{std::move(result)});
+         buf.head.resize(buf.head.size() - 2);
+         pack_presence(buf.head, traces);
+         pack_presence(buf.middle, deltas);
+         buf.traces = std::move(traces);
+         buf.deltas = std::move(deltas);
          send();
       }
 
@@ -166,22 +281,24 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          socket_stream->binary(sent_abi);
          sent_abi = true;
          socket_stream->async_write( //
-             boost::asio::buffer(send_queue[0]),
-             [self = shared_from_this(), this](boost::system::error_code ec, size_t) {
-                callback(ec, "async_write", [&] {
-                   send_queue.erase(send_queue.begin());
-                   sending = false;
-                   send();
-                });
-             });
+             send_queue.front().buffers(),
+             boost::asio::bind_executor(
+                 strand, [self = shared_from_this(), this](boost::system::error_code ec, size_t) {
+                    callback(ec, "async_write", [&] {
+                       send_queue.pop_front();
+                       sending = false;
+                       send();
+                    });
+                 }));
       }
 
       using result_type = void;
       void operator()(get_status_request_v0&) {
-         auto&                chain = plugin->chain_plug->chain();
+         auto                 position = plugin->get_position();
          get_status_result_v0 result;
-         result.head              = {chain.head_block_num(), chain.head_block_id()};
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+         result.head              = position.head;
+         result.last_irreversible = position.last_irreversible;
+         std::lock_guard<std::mutex> g(plugin->log_mutex);
          if (plugin->trace_log) {
             result.trace_begin_block = plugin->trace_log->begin_block();
             result.trace_end_block   = plugin->trace_log->end_block();
@@ -194,16 +311,28 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
 
       void operator()(get_blocks_request_v0& req) {
-         for (auto& cp : req.have_positions) {
-            if (req.start_block_num <= cp.block_num)
-               continue;
-            auto id = plugin->get_block_id(cp.block_num);
-            if (!id || *id != cp.block_id)
-               req.start_block_num = std::min(req.start_block_num, cp.block_num);
-         }
-         req.have_positions.clear();
-         current_request = req;
-         send_update(true);
+         auto num = ++request_num;
+         // checking have_positions may read the block log
+         app().get_io_service().post([self = shared_from_this(), this, req, num]() mutable {
+            catch_and_log([&] {
+               for (auto& cp : req.have_positions) {
+                  if (req.start_block_num <= cp.block_num)
+                     continue;
+                  auto id = plugin->get_block_id(cp.block_num);
+                  if (!id || *id != cp.block_id)
+                     req.start_block_num = std::min(req.start_block_num, cp.block_num);
+               }
+               req.have_positions.clear();
+            });
+            boost::asio::post(strand, [self, this, req{std::move(req)}, num]() {
+               if (num != request_num)
+                  return;
+               catch_and_close([&] {
+                  current_request = req;
+                  send_update(true);
+               });
+            });
+         });
       }
 
       void operator()(get_blocks_ack_request_v0& req) {
@@ -213,37 +342,90 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          send_update();
       }
 
+      // checkpoints are written with the block's chain_state_history.log entry, so its id is in the log
+      void operator()(get_checkpoint_request_v0& req) {
+         get_checkpoint_result_v0 result;
+         fc::optional<uint32_t>   block_num;
+         state_history_log_header header;
+         bytes                    deltas;
+         if (plugin->checkpoints)
+            block_num = plugin->checkpoints->find(req.block_num);
+         if (block_num && plugin->checkpoints->read(*block_num, header, deltas)) {
+            auto block_id = plugin->get_log_block_id(*block_num);
+            if (block_id && *block_id == header.block_id) {
+               result.block  = block_position{*block_num, *block_id};
+               result.deltas = std::move(deltas);
+            }
+         }
+         send(std::move(result));
+      }
+
       void send_update(bool changed = false) {
          if (changed)
             need_to_send_update = true;
-         if (!send_queue.empty() || !need_to_send_update || !current_request ||
+         if (!send_queue.empty() || waiting_for_main || !need_to_send_update || !current_request ||
              !current_request->max_messages_in_flight)
             return;
-         auto&                chain = plugin->chain_plug->chain();
+         auto                 position = plugin->get_position();
          get_blocks_result_v0 result;
-         result.head              = {chain.head_block_num(), chain.head_block_id()};
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+         result.head              = position.head;
+         result.last_irreversible = position.last_irreversible;
          uint32_t current =
              current_request->irreversible_only ? result.last_irreversible.block_num : result.head.block_num;
+         if (plugin->trace_log || plugin->chain_state_log)
+            current = std::min(current, position.stored_block_num); // later entries may still be in the pipeline
          if (current_request->start_block_num <= current &&
              current_request->start_block_num < current_request->end_block_num) {
-            auto block_id = plugin->get_block_id(current_request->start_block_num);
-            if (block_id) {
-               result.this_block  = block_position{current_request->start_block_num, *block_id};
-               auto prev_block_id = plugin->get_block_id(current_request->start_block_num - 1);
-               if (prev_block_id)
-                  result.prev_block = block_position{current_request->start_block_num - 1, *prev_block_id};
-               if (current_request->fetch_block)
-                  plugin->get_block(current_request->start_block_num, result.block);
-               if (current_request->fetch_traces && plugin->trace_log)
-                  plugin->get_log_entry(*plugin->trace_log, current_request->start_block_num, result.traces);
-               if (current_request->fetch_deltas && plugin->chain_state_log)
-                  plugin->get_log_entry(*plugin->chain_state_log, current_request->start_block_num, result.deltas);
-            }
-            ++current_request->start_block_num;
+            auto block_num = current_request->start_block_num;
+            auto block_id  = plugin->get_log_block_id(block_num);
+            auto prev_id   = plugin->get_log_block_id(block_num - 1);
+            if (block_id && prev_id && !current_request->fetch_block)
+               return send_block(std::move(result), current, block_id, prev_id);
+
+            // the block log is only read on the main thread
+            waiting_for_main = true;
+            app().get_io_service().post([self = shared_from_this(), this, result, current, block_num,
+                                         num = request_num, fetch_block = current_request->fetch_block]() mutable {
+               fc::optional<chain::block_id_type> block_id, prev_id;
+               catch_and_log([&] {
+                  block_id = plugin->get_block_id(block_num);
+                  prev_id  = plugin->get_block_id(block_num - 1);
+                  if (block_id && fetch_block)
+                     plugin->get_block(block_num, result.block);
+               });
+               boost::asio::post(strand, [self, this, result{std::move(result)}, current, block_num, block_id, prev_id,
+                                          num]() mutable {
+                  waiting_for_main = false;
+                  catch_and_close([&] {
+                     if (num != request_num || current_request->start_block_num != block_num)
+                        return send_update();
+                     send_block(std::move(result), current, block_id, prev_id);
+                  });
+               });
+            });
+            return;
          }
          send(std::move(result));
          --current_request->max_messages_in_flight;
+         need_to_send_update = false;
+      }
+
+      void send_block(get_blocks_result_v0 result, uint32_t current, const fc::optional<chain::block_id_type>& block_id,
+                      const fc::optional<chain::block_id_type>& prev_id) {
+         auto                      block_num = current_request->start_block_num;
+         fc::optional<log_payload> traces, deltas;
+         if (block_id) {
+            result.this_block = block_position{block_num, *block_id};
+            if (prev_id)
+               result.prev_block = block_position{block_num - 1, *prev_id};
+            if (current_request->fetch_traces && plugin->trace_log)
+               traces = plugin->get_log_entry(*plugin->trace_log, block_num);
+            if (current_request->fetch_deltas && plugin->chain_state_log)
+               deltas = plugin->get_log_entry(*plugin->chain_state_log, block_num);
+         }
+         ++current_request->start_block_num;
+         send(std::move(result), std::move(traces), std::move(deltas));
+         --current_request->max_messages_in_flight;
          need_to_send_update = current_request->start_block_num <= current &&
                                current_request->start_block_num < current_request->end_block_num;
       }
@@ -283,10 +465,13 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
 
       void close() {
-         socket_stream->next_layer().close();
+         if (socket_stream)
+            socket_stream->next_layer().close();
+         std::lock_guard<std::mutex> g(plugin->sessions_mutex);
          plugin->sessions.erase(this);
       }
    };
+   std::mutex                                   sessions_mutex; // guards sessions
    std::map<session*, std::shared_ptr<session>> sessions;
 
    void listen() {
@@ -294,7 +479,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
 
       auto address  = boost::asio::ip::make_address(endpoint_address);
       auto endpoint = tcp::endpoint{address, endpoint_port};
-      acceptor      = std::make_unique<tcp::acceptor>(app().get_io_service());
+      acceptor      = std::make_unique<tcp::acceptor>(*ship_ios);
 
       auto check_ec = [&](const char* what) {
          if (!ec)
@@ -314,7 +499,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    }
 
    void do_accept() {
-      auto socket = std::make_shared<tcp::socket>(app().get_io_service());
+      auto socket = std::make_shared<tcp::socket>(*ship_ios);
       acceptor->async_accept(*socket, [self = shared_from_this(), socket, this](auto ec) {
          if (stopping)
             return;
@@ -324,9 +509,12 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
             return;
          }
          catch_and_log([&] {
-            auto s            = std::make_shared<session>(self);
-            sessions[s.get()] = s;
-            s->start(std::move(*socket));
+            auto s = std::make_shared<session>(self);
+            {
+               std::lock_guard<std::mutex> g(sessions_mutex);
+               sessions[s.get()] = s;
+            }
+            boost::asio::post(s->strand, [s, socket]() { s->catch_and_close([&] { s->start(std::move(*socket)); }); });
          });
          catch_and_log([&] { do_accept(); });
       });
@@ -344,10 +532,21 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
              auth.permission == eosio::chain::config::active_name;
    }
 
+   // implicit transactions other than onblock, such as recurring actions, have no receipt in the block
+   void on_accepted_transaction(const transaction_metadata_ptr& p) {
+      if (p->implicit)
+         implicit_ids.insert(p->id);
+   }
+
    void on_applied_transaction(const transaction_trace_ptr& p) {
       if (p->receipt) {
-         if (is_onblock(p))
+         if (is_onblock(p)) {
+            // onblock starts each pending block, so traces of the implicit transactions of an aborted one are dropped
             onblock_trace = p;
+            implicit_traces.clear();
+            implicit_ids.clear();
+         } else if (implicit_ids.erase(p->id))
+            implicit_traces.push_back(p);
          else if (p->failed_dtrx_trace)
             cached_traces[p->failed_dtrx_trace->id] = p;
          else
@@ -356,24 +555,87 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    }
 
    void on_accepted_block(const block_state_ptr& block_state) {
-      store_traces(block_state);
-      store_chain_state(block_state);
+      std::shared_future<bytes> traces_bin, deltas_bin, checkpoint_bin;
+      if (trace_log)
+         traces_bin = store_traces(block_state);
+      if (chain_state_log)
+         deltas_bin = store_chain_state(block_state, checkpoint_bin);
+      if (!trace_log && !chain_state_log)
+         return on_block_stored(block_state->block_num);
+
+      boost::asio::post(*writer, [self = shared_from_this(), this, block_state, traces_bin, deltas_bin,
+                                  checkpoint_bin]() {
+         try {
+            if (traces_bin.valid())
+               write_log_entry(*trace_log, block_state, traces_bin.get());
+            if (deltas_bin.valid())
+               write_log_entry(*chain_state_log, block_state, deltas_bin.get());
+            if (checkpoint_bin.valid()) {
+               auto& bin = checkpoint_bin.get();
+               checkpoints->write({.block_num    = block_state->block->block_num(),
+                                   .block_id     = block_state->block->id(),
+                                   .payload_size = bin.size()},
+                                  bin);
+            }
+            app().get_io_service().post(
+                [self, this, block_num = block_state->block_num]() { on_block_stored(block_num); });
+         } catch (const fc::exception& e) {
+            elog("unable to store state history: ${e}", ("e", e.to_detail_string()));
+            app().get_io_service().post([]() { app().quit(); });
+         } catch (const std::exception& e) {
+            elog("unable to store state history: ${e}", ("e", e.what()));
+            app().get_io_service().post([]() { app().quit(); });
+         }
+      });
+   }
+
+   void on_block_stored(uint32_t block_num) {
+      if (stopping)
+         return;
+      update_position(block_num);
+      std::lock_guard<std::mutex> g(sessions_mutex);
       for (auto& s : sessions) {
          auto& p = s.second;
          if (p) {
-            if (p->current_request && block_state->block_num < p->current_request->start_block_num)
-               p->current_request->start_block_num = block_state->block_num;
-            p->send_update(true);
+            boost::asio::post(p->strand, [p, block_num]() {
+               p->catch_and_close([&] {
+                  if (p->current_request && block_num < p->current_request->start_block_num)
+                     p->current_request->start_block_num = block_num;
+                  p->send_update(true);
+               });
+            });
          }
       }
    }
 
-   void store_traces(const block_state_ptr& block_state) {
-      if (!trace_log)
-         return;
+   template <typename F>
+   std::shared_future<bytes> async_pack(F&& f) {
+      auto task = std::make_shared<std::packaged_task<bytes()>>(std::forward<F>(f));
+      boost::asio::post(*thread_pool, [task]() { (*task)(); });
+      return task->get_future().share();
+   }
+
+   void write_log_entry(state_history_log& log, const block_state_ptr& block_state, const bytes& bin) {
+      EOS_ASSERT(bin.size() == (uint32_t)bin.size(), plugin_exception, "state history entry is too big");
+      state_history_log_header header{.block_num    = block_state->block->block_num(),
+                                      .block_id     = block_state->block->id(),
+                                      .payload_size = sizeof(uint32_t) + bin.size()};
+      std::lock_guard<std::mutex> g(log_mutex);
+      log.write_entry(header, block_state->block->previous, [&](auto& stream) {
+         uint32_t s = (uint32_t)bin.size();
+         stream.write((char*)&s, sizeof(s));
+         if (!bin.empty())
+            stream.write(bin.data(), bin.size());
+      });
+      log.mark_irreversible(block_state->dpos_irreversible_blocknum);
+   }
+
+   /// traces are immutable once their block is accepted, so all of their serialization runs on thread_pool
+   std::shared_future<bytes> store_traces(const block_state_ptr& block_state) {
       std::vector<transaction_trace_ptr> traces;
       if (onblock_trace)
          traces.push_back(onblock_trace);
+      traces.insert(traces.end(), implicit_traces.begin(), implicit_traces.end());
       for (auto& r : block_state->block->transactions) {
          transaction_id_type id;
          if (r.trx.contains<transaction_id_type>())
@@ -387,29 +649,34 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
       cached_traces.clear();
       onblock_trace.reset();
+      implicit_traces.clear();
+      implicit_ids.clear();
 
-      auto& db         = chain_plug->chain().db();
-      auto  traces_bin = zlib_compress_bytes(fc::raw::pack(make_history_serial_wrapper(db, traces)));
-      EOS_ASSERT(traces_bin.size() == (uint32_t)traces_bin.size(), plugin_exception, "traces is too big");
-
-      state_history_log_header header{.block_num    = block_state->block->block_num(),
-                                      .block_id     = block_state->block->id(),
-                                      .payload_size = sizeof(uint32_t) + traces_bin.size()};
-      trace_log->write_entry(header, block_state->block->previous, [&](auto& stream) {
-         uint32_t s = (uint32_t)traces_bin.size();
-         stream.write((char*)&s, sizeof(s));
-         if (!traces_bin.empty())
-            stream.write(traces_bin.data(), traces_bin.size());
+      auto& db = chain_plug->chain().db(); // not read by the serialization of traces
+      return async_pack([&db, traces{std::move(traces)}]() {
+         return zlib_compress_bytes(fc::raw::pack(make_history_serial_wrapper(db, traces)));
       });
    }
 
-   void store_chain_state(const block_state_ptr& block_state) {
-      if (!chain_state_log)
-         return;
-      bool fresh = chain_state_log->begin_block() == chain_state_log->end_block();
+   /// the changed rows are packed here, before the next block changes them; the rest runs on thread_pool
+   std::shared_future<bytes> store_chain_state(const block_state_ptr& block_state,
+                                               std::shared_future<bytes>& checkpoint_bin) {
+      bool fresh = chain_state_fresh;
+      chain_state_fresh = false;
+      if (checkpoints && (fresh || block_state->block_num % checkpoint_interval == 0)) {
+         ilog("Placing checkpoint of state in block ${n}", ("n", block_state->block->block_num()));
+         checkpoint_bin =
+             async_pack([deltas{pack_deltas(true)}]() { return zlib_compress_bytes(fc::raw::pack(deltas)); });
+         fresh = false;
+      }
       if (fresh)
          ilog("Placing initial state in block ${n}", ("n", block_state->block->block_num()));
 
+      return async_pack([deltas{pack_deltas(fresh)}]() { return zlib_compress_bytes(fc::raw::pack(deltas)); });
+   } // store_chain_state
+
+   /// full: every row of every table instead of the rows changed by the head block
+   std::vector<table_delta> pack_deltas(bool full) {
       std::vector<table_delta> deltas;
       auto&                    db = chain_plug->chain().db();
 
@@ -434,7 +701,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       };
 
       auto process_table = [&](auto* name, auto& index, auto& pack_row) {
-         if (fresh) {
+         if (full) {
             if (index.indices().empty())
                return;
             deltas.push_back({});
@@ -485,18 +752,8 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       process_table("resource_limits_state", db.get_index<resource_limits::resource_limits_state_index>(), pack_row);
       process_table("resource_limits_config", db.get_index<resource_limits::resource_limits_config_index>(), pack_row);
 
-      auto deltas_bin = zlib_compress_bytes(fc::raw::pack(deltas));
-      EOS_ASSERT(deltas_bin.size() == (uint32_t)deltas_bin.size(), plugin_exception, "deltas is too big");
-      state_history_log_header header{.block_num    = block_state->block->block_num(),
-                                      .block_id     = block_state->block->id(),
-                                      .payload_size = sizeof(uint32_t) + deltas_bin.size()};
-      chain_state_log->write_entry(header, block_state->block->previous, [&](auto& stream) {
-         uint32_t s = (uint32_t)deltas_bin.size();
-         stream.write((char*)&s, sizeof(s));
-         if (!deltas_bin.empty())
-            stream.write(deltas_bin.data(), deltas_bin.size());
-      });
-   } // store_chain_state
+      return deltas;
+   } // pack_deltas
 };   // state_history_plugin_impl
 
 state_history_plugin::state_history_plugin()
@@ -513,6 +770,15 @@ void state_history_plugin::set_program_options(options_description& cli, options
    options("chain-state-history", bpo::bool_switch()->default_value(false), "enable chain state history");
    options("state-history-endpoint", bpo::value<string>()->default_value("0.0.0.0:8080"),
            "the endpoint upon which to listen for incoming connections");
+   options("chain-state-checkpoint-interval", bpo::value<uint32_t>()->default_value(0),
+           "place the whole chain state in a checkpoint every N blocks, and when chain_state_history.log starts, "
+           "instead of in its first entry; 0 disables checkpoints");
+   options("chain-state-checkpoints", bpo::value<uint32_t>()->default_value(4),
+           "number of chain state checkpoints to keep");
+   options("state-history-network-threads", bpo::value<uint16_t>()->default_value(2),
+           "number of threads which serve the websocket sessions");
+   options("state-history-threads", bpo::value<uint16_t>()->default_value(2),
+           "number of threads which serialize and compress traces and deltas");
 }
 
 void state_history_plugin::plugin_initialize(const variables_map& options) {
@@ -523,6 +789,8 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       my->chain_plug = app().find_plugin<chain_plugin>();
       EOS_ASSERT(my->chain_plug, chain::missing_chain_plugin_exception, "");
       auto& chain = my->chain_plug->chain();
+      my->accepted_transaction_connection.emplace(
+          chain.accepted_transaction.connect([&](const transaction_metadata_ptr& p) { my->on_accepted_transaction(p); }));
       my->applied_transaction_connection.emplace(
           chain.applied_transaction.connect([&](const transaction_trace_ptr& p) { my->on_applied_transaction(p); }));
       my->accepted_block_connection.emplace(
@@ -554,18 +822,74 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       if (options.at("chain-state-history").as<bool>())
          my->chain_state_log.emplace("chain_state_history", (state_history_dir / "chain_state_history.log").string(),
                                      (state_history_dir / "chain_state_history.index").string());
+
+      my->checkpoint_interval = options.at("chain-state-checkpoint-interval").as<uint32_t>();
+      if (my->chain_state_log && my->checkpoint_interval) {
+         auto max_checkpoints = options.at("chain-state-checkpoints").as<uint32_t>();
+         EOS_ASSERT(max_checkpoints > 0, plugin_config_exception, "chain-state-checkpoints must be greater than 0");
+         my->checkpoints.emplace(state_history_dir / "chain_state_checkpoints", max_checkpoints);
+      }
+
+      my->thread_pool_size = options.at("state-history-threads").as<uint16_t>();
+      EOS_ASSERT(my->thread_pool_size > 0, plugin_config_exception,
+                 "state-history-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+      if (my->trace_log || my->chain_state_log) {
+         my->thread_pool.emplace(my->thread_pool_size);
+         my->writer.emplace(1);
+      }
+
+      my->network_threads = options.at("state-history-network-threads").as<uint16_t>();
+      EOS_ASSERT(my->network_threads > 0, plugin_config_exception,
+                 "state-history-network-threads ${num} must be greater than 0", ("num", my->network_threads));
+      my->ship_ios.emplace();
+      my->ship_ios_work.emplace(*my->ship_ios);
+
+      auto stored = [](auto& log) { return log.end_block() ? log.end_block() - 1 : 0; };
+      if (my->trace_log)
+         my->position.stored_block_num = stored(*my->trace_log);
+      if (my->chain_state_log) {
+         my->position.stored_block_num = my->trace_log
+                                             ? std::min(my->position.stored_block_num, stored(*my->chain_state_log))
+                                             : stored(*my->chain_state_log);
+         my->chain_state_fresh = my->chain_state_log->begin_block() == my->chain_state_log->end_block() ||
+                                 (my->checkpoints && !my->checkpoints->find(my->chain_state_log->end_block()));
+      }
    }
    FC_LOG_AND_RETHROW()
 } // state_history_plugin::plugin_initialize
 
-void state_history_plugin::plugin_startup() { my->listen(); }
+void state_history_plugin::plugin_startup() {
+   my->update_position(my->position.stored_block_num);
+   my->listen();
+   my->ship_threads.reserve(my->network_threads);
+   for (uint16_t i = 0; i < my->network_threads; ++i)
+      my->ship_threads.emplace_back([&ios = *my->ship_ios]() { ios.run(); });
+}
 
 void state_history_plugin::plugin_shutdown() {
+   my->accepted_transaction_connection.reset();
    my->applied_transaction_connection.reset();
    my->accepted_block_connection.reset();
-   while (!my->sessions.empty())
-      my->sessions.begin()->second->close();
    my->stopping = true;
+   if (my->ship_ios) {
+      my->ship_ios_work.reset();
+      my->ship_ios->stop();
+   }
+   for (auto& t : my->ship_threads)
+      t.join();
+   my->ship_threads.clear();
+   for (auto& s : my->sessions) {
+      boost::system::error_code ec;
+      if (s.second->socket_stream)
+         s.second->socket_stream->next_layer().close(ec);
+   }
+   my->sessions.clear();
+   my->acceptor.reset();
+   // finish writing the blocks already accepted
+   if (my->thread_pool)
+      my->thread_pool->join();
+   if (my->writer)
+      my->writer->join();
 }
 
 } // namespace eosio
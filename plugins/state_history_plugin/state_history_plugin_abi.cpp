@@ -48,6 +48,17 @@ extern const char* const state_history_plugin_abi = R"({
                 { "name": "deltas", "type": "bytes?" }
             ]
         },
+        {
+            "name": "get_checkpoint_request_v0", "fields": [
+                { "name": "block_num", "type": "uint32" }
+            ]
+        },
+        {
+            "name": "get_checkpoint_result_v0", "fields": [
+                { "name": "block", "type": "block_position?" },
+                { "name": "deltas", "type": "bytes?" }
+            ]
+        },
         {
             "name": "row", "fields": [
                 { "name": "present", "type": "bool" },
@@ -424,8 +435,8 @@ extern const char* const state_history_plugin_abi = R"({
         { "new_type_name": "transaction_id", "type": "checksum256" }
     ],
     "variants": [
-        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0"] },
-        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0"] },
+        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_checkpoint_request_v0"] },
+        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_checkpoint_result_v0"] },
 
         { "name": "action_receipt", "types": ["action_receipt_v0"] },
         { "name": "action_trace", "types": ["action_trace_v0"] },
@@ -0,0 +1,138 @@
+/**
+ *  @file
+ *  @copyright defined in eosio/LICENSE.txt
+ */
+#include <eosio/chain/merkle.hpp>
+#include <eosio/chain/sha256_batch.hpp>
+
+#include <fc/time.hpp>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+
+#include <iostream>
+
+using namespace eosio::chain;
+namespace bpo = boost::program_options;
+using bpo::options_description;
+using bpo::variables_map;
+
+/**
+ *  Compares fc::sha256 with every sha256_batch backend supported by this cpu on the hashing a block does: a merkle
+ *  root over as many leaves as a block has receipts, and the digests of receipt sized messages.
+ */
+struct hashbench {
+   void set_program_options(options_description& cli);
+   void initialize(const variables_map& options);
+   void run();
+
+   uint32_t    leaves = 0;
+   uint32_t    message_size = 0;
+   uint32_t    iterations = 0;
+};
+
+void hashbench::set_program_options(options_description& cli)
+{
+   cli.add_options()
+         ("leaves", bpo::value<uint32_t>()->default_value(1000),
+          "the number of digests in the merkle tree and of messages hashed per iteration")
+         ("message-size", bpo::value<uint32_t>()->default_value(76),
+          "the size in bytes of each hashed message, 76 is a packed action_receipt without auth_sequence entries")
+         ("iterations", bpo::value<uint32_t>()->default_value(200),
+          "the number of times each benchmark is repeated")
+         ("help,h", "Print this help message and exit.")
+         ;
+}
+
+void hashbench::initialize(const variables_map& options) {
+   leaves = std::max<uint32_t>( options.at( "leaves" ).as<uint32_t>(), 1 );
+   message_size = options.at( "message-size" ).as<uint32_t>();
+   iterations = std::max<uint32_t>( options.at( "iterations" ).as<uint32_t>(), 1 );
+}
+
+template<typename F>
+static void measure( const string& name, uint32_t iterations, uint32_t per_iteration, F&& f ) {
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < iterations; ++i )
+      f();
+   auto elapsed = fc::time_point::now() - start;
+   std::cout << name << ": " << elapsed.count() / iterations << " us per iteration, "
+             << double(elapsed.count()) * 1000 / (double(iterations) * per_iteration) << " ns per hash" << std::endl;
+}
+
+void hashbench::run() {
+   vector<digest_type> ids;
+   for( uint32_t i = 0; i < leaves; ++i )
+      ids.push_back( digest_type::hash( i ) );
+
+   vector<char> data( size_t(leaves) * message_size );
+   for( size_t i = 0; i < data.size(); ++i )
+      data[i] = char( i * 131 );
+   vector<sha256_batch::message> msgs( leaves );
+   for( uint32_t i = 0; i < leaves; ++i )
+      msgs[i] = sha256_batch::message{ data.data() + size_t(i) * message_size, message_size };
+
+   vector<digest_type> out( leaves );
+   const uint32_t merkle_hashes = leaves > 1 ? leaves : 1; // a tree of n leaves takes about n pair hashes
+
+   measure( "fc::sha256 merkle", iterations, merkle_hashes, [&]() {
+      auto level = ids;
+      while( level.size() > 1 ) {
+         if( level.size() % 2 )
+            level.push_back( level.back() );
+         for( size_t i = 0; i < level.size() / 2; ++i )
+            level[i] = digest_type::hash( make_canonical_pair( level[2 * i], level[(2 * i) + 1] ) );
+         level.resize( level.size() / 2 );
+      }
+   });
+   measure( "fc::sha256 messages", iterations, leaves, [&]() {
+      for( uint32_t i = 0; i < leaves; ++i )
+         out[i] = digest_type::hash( msgs[i].data, msgs[i].size );
+   });
+
+   const string original = sha256_batch::backend();
+   for( const char* name : { "portable", "sha-ni", "avx2", "auto" } ) {
+      if( !sha256_batch::set_backend( name ) ) {
+         std::cout << name << ": not supported by this cpu" << std::endl;
+         continue;
+      }
+      measure( string(name) + " merkle", iterations, merkle_hashes, [&]() { merkle( ids ); } );
+      measure( string(name) + " messages", iterations, leaves, [&]() {
+         sha256_batch::hash( msgs.data(), msgs.size(), out.data() );
+      });
+   }
+   sha256_batch::set_backend( original );
+   std::cout << "default backend: " << original << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+   options_description cli ("eosio-hashbench command line options");
+   try {
+      hashbench bench;
+      bench.set_program_options(cli);
+      variables_map vmap;
+      bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+      bpo::notify(vmap);
+      if (vmap.count("help") > 0) {
+        cli.print(std::cerr);
+        return 0;
+      }
+      bench.initialize(vmap);
+      bench.run();
+   } catch( const fc::exception& e ) {
+      elog( "${e}", ("e", e.to_detail_string()));
+      return -1;
+   } catch( const boost::exception& e ) {
+      elog("${e}", ("e",boost::diagnostic_information(e)));
+      return -1;
+   } catch( const std::exception& e ) {
+      elog("${e}", ("e",e.what()));
+      return -1;
+   } catch( ... ) {
+      elog("unknown exception");
+      return -1;
+   }
+
+   return 0;
+}
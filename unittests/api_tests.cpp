@@ -26,6 +26,7 @@
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/wasm_interface.hpp>
 #include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/generated_transaction_object.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/sha256.hpp>
@@ -1054,6 +1055,79 @@ BOOST_FIXTURE_TEST_CASE(transaction_tests, TESTER) { try {
    BOOST_REQUIRE_EQUAL( validate(), true );
 } FC_LOG_AND_RETHROW() }
 
+BOOST_FIXTURE_TEST_CASE(recurring_action_tests, TESTER) { try {
+   produce_blocks(2);
+   create_accounts( {N(testapi)} );
+   set_code( N(testapi), test_api_wast );
+   produce_blocks(1);
+
+   const action_name tick = TEST_METHOD("test_print", "test_prints");
+   uint32_t fired = 0;
+   uint32_t billed_cpu = 0;
+   auto c = control->applied_transaction.connect([&]( const transaction_trace_ptr& t) {
+      if( t && !t->action_traces.empty() && t->action_traces.front().act.name == tick ) {
+         ++fired;
+         billed_cpu = t->receipt->cpu_usage_us;
+      }
+   } );
+
+   // recurring actions do not exist until they are activated by eosio
+   auto res = push_action( action( {{N(testapi), config::active_name}}, setrecur{ N(testapi), tick, 1000, {} } ), N(testapi) );
+   BOOST_CHECK_EQUAL( boost::algorithm::ends_with(res, "recurring actions have not been activated"), true );
+
+   res = push_action( action( {{N(testapi), config::active_name}}, actrecur{} ), N(testapi) );
+   BOOST_CHECK_EQUAL( boost::algorithm::ends_with(res, "missing authority of eosio"), true );
+   BOOST_REQUIRE_EQUAL( success(), push_action( action( {{config::system_account_name, config::active_name}}, actrecur{} ), config::system_account_name ) );
+
+   // only privileged accounts may schedule recurring actions
+   res = push_action( action( {{N(testapi), config::active_name}}, setrecur{ N(testapi), tick, 1000, {} } ), N(testapi) );
+   BOOST_CHECK_EQUAL( boost::algorithm::ends_with(res, "only privileged accounts can schedule recurring actions"), true );
+
+   push_action(config::system_account_name, N(setpriv), config::system_account_name,  mutable_variant_object()
+                                                       ("account", "testapi")
+                                                       ("is_priv", 1));
+
+   res = push_action( action( {{N(testapi), config::active_name}}, setrecur{ N(testapi), tick, 100, {} } ), N(testapi) );
+   BOOST_CHECK_EQUAL( boost::algorithm::ends_with(res, "recurring action interval must be at least one block interval"), true );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( action( {{N(testapi), config::active_name}}, setrecur{ N(testapi), tick, 1000, {} } ), N(testapi) ) );
+   fired = 0;
+
+   // fires once every other block, at the start of the block, without any deferred transaction, and is billed a fixed amount
+   produce_blocks(10);
+   BOOST_CHECK_EQUAL( 5u, fired );
+   BOOST_CHECK_EQUAL( config::recurring_action_cpu_usage, billed_cpu );
+   BOOST_CHECK_EQUAL( 0u, control->db().get_index<generated_transaction_multi_index,by_trx_id>().size() );
+
+   // an account which loses its privileges keeps its entries, but they do not fire
+   push_action(config::system_account_name, N(setpriv), config::system_account_name,  mutable_variant_object()
+                                                       ("account", "testapi")
+                                                       ("is_priv", 0));
+   fired = 0;
+   produce_blocks(4);
+   BOOST_CHECK_EQUAL( 0u, fired );
+   push_action(config::system_account_name, N(setpriv), config::system_account_name,  mutable_variant_object()
+                                                       ("account", "testapi")
+                                                       ("is_priv", 1));
+   produce_blocks(4);
+   BOOST_CHECK_EQUAL( 2u, fired );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( action( {{N(testapi), config::active_name}}, delrecur{ N(testapi), tick } ), N(testapi) ) );
+   fired = 0;
+   produce_blocks(10);
+   BOOST_CHECK_EQUAL( 0u, fired );
+
+   // an action which never returns fails once it reaches the checktime limit, on the producer and on the validating node
+   const action_name spin = TEST_METHOD("test_checktime", "checktime_failure");
+   BOOST_REQUIRE_EQUAL( success(), push_action( action( {{N(testapi), config::active_name}}, setrecur{ N(testapi), spin, 1000, {} } ), N(testapi) ) );
+   produce_blocks(4);
+   BOOST_REQUIRE_EQUAL( success(), push_action( action( {{N(testapi), config::active_name}}, delrecur{ N(testapi), spin } ), N(testapi) ) );
+   produce_blocks(1);
+
+   c.disconnect();
+   BOOST_REQUIRE_EQUAL( validate(), true );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_FIXTURE_TEST_CASE(deferred_transaction_tests, TESTER) { try {
    produce_blocks(2);
    create_accounts( {N(testapi), N(testapi2), N(alice)} );
@@ -1306,7 +1380,24 @@ BOOST_FIXTURE_TEST_CASE(db_tests, TESTER) { try {
    CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_general", {});
    CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_lowerbound", {});
    CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_upperbound", {});
+
+   // batched reads are only available to privileged contracts
+   BOOST_CHECK_EXCEPTION( CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_batch", {}), unaccessible_api,
+                          [](const fc::exception& e) {
+                             return expect_assert_message(e, "testapi does not have permission to call this API");
+                          }
+                        );
+   push_action(config::system_account_name, N(setpriv), config::system_account_name,  mutable_variant_object()
+                                                       ("account", "testapi")
+                                                       ("is_priv", 1));
+   CALL_TEST_FUNCTION( *this, "test_db", "primary_i64_batch", {});
+
    CALL_TEST_FUNCTION( *this, "test_db", "idx64_general", {});
+   CALL_TEST_FUNCTION( *this, "test_db", "idx64_batch", {});
+   push_action(config::system_account_name, N(setpriv), config::system_account_name,  mutable_variant_object()
+                                                       ("account", "testapi")
+                                                       ("is_priv", 0));
+
    CALL_TEST_FUNCTION( *this, "test_db", "idx64_lowerbound", {});
    CALL_TEST_FUNCTION( *this, "test_db", "idx64_upperbound", {});
 
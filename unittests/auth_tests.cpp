@@ -294,6 +294,53 @@ BOOST_AUTO_TEST_CASE(link_then_update_auth) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(cached_auth_invalidation) { try {
+   TESTER chain;
+
+   chain.create_account("alice");
+
+   const auto spending_priv_key = chain.get_private_key("alice", "spending");
+   const auto spending_pub_key = spending_priv_key.get_public_key();
+   chain.set_authority("alice", "spending", spending_pub_key, "active");
+   chain.link_authority("alice", "eosio", "spending", "reqauth");
+   chain.produce_block();
+
+   const auto& authorization = chain.control->get_authorization_manager();
+   const auto active_pub_key = chain.get_public_key("alice", "active");
+   const auto new_active_priv_key = chain.get_private_key("alice", "new_active");
+   const auto new_active_pub_key = new_active_priv_key.get_public_key();
+   const action reqauth_act( { permission_level{N(alice), "spending"} }, config::system_account_name, N(reqauth),
+                             fc::raw::pack(N(alice)) );
+
+   // Repeated checks within a block may be answered from the cache, but must give the same results
+   for( int i = 0; i < 2; ++i ) {
+      authorization.check_authorization( N(alice), config::active_name, { active_pub_key } );
+      BOOST_CHECK_THROW( authorization.check_authorization( N(alice), config::active_name, { new_active_pub_key } ),
+                         unsatisfied_authorization );
+      authorization.check_authorization( { reqauth_act }, { spending_pub_key } );
+   }
+
+   // Updating the permission in the same block must not leave the old result behind
+   chain.set_authority("alice", "active", authority(new_active_pub_key), "owner",
+                       { permission_level{N(alice), config::active_name} }, { chain.get_private_key("alice", "active") });
+   BOOST_CHECK_THROW( authorization.check_authorization( N(alice), config::active_name, { active_pub_key } ),
+                      unsatisfied_authorization );
+   authorization.check_authorization( N(alice), config::active_name, { new_active_pub_key } );
+
+   // Neither may unlinking the permission
+   chain.unlink_authority("alice", "eosio", "reqauth");
+   BOOST_CHECK_THROW( authorization.check_authorization( { reqauth_act }, { spending_pub_key } ), irrelevant_auth_exception );
+
+   // Nor deleting it
+   chain.link_authority("alice", "eosio", "spending", "reqauth");
+   chain.produce_block();
+   authorization.check_authorization( { reqauth_act }, { spending_pub_key } );
+   chain.unlink_authority("alice", "eosio", "reqauth");
+   chain.delete_authority("alice", "spending");
+   BOOST_CHECK_THROW( authorization.check_authorization( { reqauth_act }, { spending_pub_key } ), permission_query_exception );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE(create_account) {
 try {
    TESTER chain;
@@ -2385,5 +2385,47 @@ BOOST_FIXTURE_TEST_CASE( delay_expired, validating_tester) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_FIXTURE_TEST_CASE( delay_expired_bulk_retire, validating_tester) { try {
+
+   produce_blocks(2);
+
+   vector<transaction_id_type> ids;
+   for( const auto& a : { N(newco), N(newco2) } ) {
+      signed_transaction trx;
+      account_name creator = config::system_account_name;
+      trx.actions.emplace_back( vector<permission_level>{{creator,config::active_name}},
+                                newaccount{
+                                   .creator  = creator,
+                                   .name     = a,
+                                   .owner    = authority( get_public_key( a, "owner" ) ),
+                                   .active   = authority( get_public_key( a, "active" ) )
+                                });
+      set_transaction_headers(trx);
+      trx.delay_sec = 3;
+      trx.expiration = control->head_block_time() + fc::microseconds(1000000);
+      trx.sign( get_private_key( creator, "active" ), control->get_chain_id()  );
+
+      auto trace = push_transaction( trx );
+      BOOST_REQUIRE_EQUAL(transaction_receipt_header::delayed, trace->receipt->status);
+      ids.push_back( trace->id );
+   }
+
+   produce_block();
+   produce_empty_block(fc::milliseconds(610 * 1000));
+
+   // both are due and expired in the pending block, so they are retired without being pushed individually
+   BOOST_REQUIRE_EQUAL(2u, control->get_scheduled_transactions().size());
+   BOOST_REQUIRE_EQUAL(2u, control->retire_expired_scheduled_transactions(fc::time_point::maximum()));
+   BOOST_REQUIRE_EQUAL(0u, control->get_scheduled_transactions().size());
+
+   signed_block_ptr sb = produce_block();
+   BOOST_REQUIRE_EQUAL(2, sb->transactions.size());
+   for( const auto& r : sb->transactions ) {
+      BOOST_REQUIRE_EQUAL(transaction_receipt_header::expired, r.status);
+      BOOST_CHECK( std::find( ids.begin(), ids.end(), r.trx.get<transaction_id_type>() ) != ids.end() );
+   }
+
+} FC_LOG_AND_RETHROW() }
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,8 @@
 
 #include <fc/variant_object.hpp>
 
+#include <fstream>
+
 using namespace eosio::chain;
 using namespace eosio::testing;
 
@@ -374,4 +376,71 @@ BOOST_AUTO_TEST_CASE( read_modes ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( fork_db_restart ) try {
+   tester c;
+   c.produce_blocks(10);
+   c.create_accounts( {N(dan),N(sam),N(pam),N(scott)} );
+   c.set_producers( {N(dan),N(sam),N(pam),N(scott)} );
+
+   // enough blocks for the fork database log to be compacted at least once
+   c.produce_blocks(400);
+
+   auto head_id  = c.control->fork_db_head_block_id();
+   auto lib_num  = c.control->last_irreversible_block_num();
+   BOOST_REQUIRE( c.control->fork_db_head_block_num() > lib_num + 1 );
+   auto reversible_id = c.control->fork_db().get_block_in_current_chain_by_num( lib_num + 1 )->id;
+
+   c.close();
+   c.open( nullptr );
+
+   BOOST_REQUIRE_EQUAL( string(head_id), string(c.control->fork_db_head_block_id()) );
+   auto reversible = c.control->fork_db().get_block_in_current_chain_by_num( lib_num + 1 );
+   BOOST_REQUIRE( reversible );
+   BOOST_REQUIRE_EQUAL( string(reversible_id), string(reversible->id) );
+
+   c.produce_blocks(20);
+   BOOST_REQUIRE( c.control->last_irreversible_block_num() > lib_num );
+
+   // a crash while a record is being written leaves it truncated; the log loads up to the record before it
+   head_id = c.control->fork_db_head_block_id();
+   c.close();
+   {
+      std::ofstream log( (c.get_config().state_dir / config::forkdb_filename).generic_string().c_str(),
+                         std::ios::out | std::ios::binary | std::ios::app );
+      fc::raw::pack( log, uint32_t(1000) );
+      fc::raw::pack( log, uint8_t(1) );
+   }
+   c.open( nullptr );
+   BOOST_REQUIRE_EQUAL( string(head_id), string(c.control->fork_db_head_block_id()) );
+
+   c.produce_blocks(20);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( irreversible_replay ) try {
+   tester c;
+   c.produce_blocks(10);
+   c.create_accounts( {N(dan),N(sam),N(pam),N(scott)} );
+   c.set_producers( {N(dan),N(sam),N(pam),N(scott)} );
+   c.produce_blocks(200);
+
+   auto lib_num = c.control->last_irreversible_block_num();
+   auto lib_id  = c.control->get_block_id_for_num( lib_num );
+   auto mid_id  = c.control->get_block_id_for_num( lib_num / 2 );
+
+   // replay only the block log, which goes through the single header state path
+   c.close();
+   fc::remove_all( c.get_config().state_dir );
+   fc::remove_all( c.get_config().blocks_dir / config::reversible_blocks_dir_name );
+   c.open( nullptr );
+
+   BOOST_REQUIRE_EQUAL( lib_num, c.control->head_block_num() );
+   BOOST_REQUIRE_EQUAL( string(lib_id), string(c.control->head_block_id()) );
+   BOOST_REQUIRE_EQUAL( string(mid_id), string(c.control->get_block_id_for_num( lib_num / 2 )) );
+
+   c.produce_blocks(20);
+   BOOST_REQUIRE( c.control->last_irreversible_block_num() > lib_num );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
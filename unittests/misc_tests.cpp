@@ -7,12 +7,17 @@
 #include <eosio/chain/authority.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/asset.hpp>
+#include <eosio/chain/merkle.hpp>
+#include <eosio/chain/sha256_batch.hpp>
+#include <eosio/chain/transaction_context.hpp>
 #include <eosio/testing/tester.hpp>
 
 #include <fc/io/json.hpp>
 
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+
 #ifdef NON_VALIDATING_TEST
 #define TESTER tester
 #else
@@ -25,6 +30,8 @@ using namespace eosio::testing;
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
 
+#include <atomic>
+
 namespace eosio
 {
 using namespace chain;
@@ -608,6 +615,153 @@ BOOST_AUTO_TEST_CASE(transaction_test) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(deadline_timer_test) { try {
+   const auto& cal = deadline_timer::calibrate();
+   BOOST_CHECK_EQUAL( &cal, &deadline_timer::calibrate() ); // measured only once
+   BOOST_CHECK_EQUAL( cal.use_watchdog, cal.timer_overhead_us < 1000 );
+
+   deadline_timer t;
+   t.start( fc::time_point::maximum() );
+   BOOST_CHECK( !t.expired );
+
+   const auto interval = fc::milliseconds(200);
+   auto start = fc::time_point::now();
+   t.start( start + interval );
+   if( cal.use_watchdog )
+      BOOST_CHECK( !t.expired );
+   while( !t.expired && fc::time_point::now() < start + interval + fc::seconds(5) ) {}
+   BOOST_REQUIRE( t.expired );
+   if( cal.use_watchdog ) // armed early by the calibrated overhead, but not earlier
+      BOOST_CHECK( fc::time_point::now() >= start + interval - fc::microseconds(cal.timer_overhead_us) );
+
+   if( cal.use_watchdog ) { // a stopped timer does not expire
+      t.start( fc::time_point::now() + fc::milliseconds(20) );
+      t.stop();
+      std::this_thread::sleep_for( std::chrono::milliseconds(60) );
+      BOOST_CHECK( !t.expired );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(signature_recovery_cache_test) { try {
+   const auto priv_key = private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string("recovery")));
+   const auto pub_key = priv_key.get_public_key();
+   const chain_id_type chain_id = fc::sha256::hash(std::string("chain"));
+   const chain_id_type other_chain_id = fc::sha256::hash(std::string("other chain"));
+
+   signed_transaction trx;
+   trx.actions.emplace_back( vector<permission_level>{{N(alice), config::active_name}}, N(eosio), N(reqauth), bytes() );
+   trx.sign( priv_key, chain_id );
+
+   // the first recovery fills the cache, the second is answered from it
+   BOOST_CHECK( trx.get_signature_keys( chain_id ) == flat_set<public_key_type>{pub_key} );
+   BOOST_CHECK( trx.get_signature_keys( chain_id ) == flat_set<public_key_type>{pub_key} );
+
+   // the same signature over a different digest must not be answered from the cache
+   auto other_keys = trx.get_signature_keys( other_chain_id );
+   BOOST_REQUIRE_EQUAL( other_keys.size(), 1 );
+   BOOST_CHECK( *other_keys.begin() != pub_key );
+   BOOST_CHECK( other_keys == trx.get_signature_keys( other_chain_id, false, false ) );
+
+   // the cache is shared by all threads
+   vector<std::thread> threads;
+   std::atomic<uint32_t> mismatches{0};
+   for( int t = 0; t < 4; ++t ) {
+      threads.emplace_back( [&]() {
+         for( int i = 0; i < 50; ++i ) {
+            if( trx.get_signature_keys( chain_id ) != flat_set<public_key_type>{pub_key} )
+               ++mismatches;
+         }
+      } );
+   }
+   for( auto& t : threads ) t.join();
+   BOOST_CHECK_EQUAL( mismatches.load(), 0 );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(sha256_batch_test) { try {
+   // messages of every length around the padding boundaries, in an order that mixes short and long ones
+   vector<string> data;
+   for( size_t len = 0; len < 300; ++len ) {
+      string s( len, '\0' );
+      for( size_t i = 0; i < len; ++i )
+         s[i] = char( (len * 31 + i * 7) & 0xff );
+      data.push_back( s );
+   }
+   std::reverse( data.begin() + 100, data.end() );
+
+   vector<sha256_batch::message> msgs;
+   vector<digest_type> expected;
+   for( const auto& s : data ) {
+      msgs.push_back( sha256_batch::message{ s.data(), s.size() } );
+      expected.push_back( digest_type::hash( s.data(), s.size() ) );
+   }
+
+   vector<digest_type> leaves;
+   for( uint32_t i = 0; i < 37; ++i )
+      leaves.push_back( digest_type::hash( i ) );
+
+   // merkle() as it was computed before batching
+   auto reference_merkle = []( vector<digest_type> ids ) {
+      while( ids.size() > 1 ) {
+         if( ids.size() % 2 )
+            ids.push_back( ids.back() );
+         for( size_t i = 0; i < ids.size() / 2; ++i )
+            ids[i] = digest_type::hash( make_canonical_pair( ids[2 * i], ids[(2 * i) + 1] ) );
+         ids.resize( ids.size() / 2 );
+      }
+      return ids.front();
+   };
+
+   const string original = sha256_batch::backend();
+   uint32_t tested = 0;
+   for( const char* name : { "portable", "sha-ni", "avx2", "auto" } ) {
+      if( !sha256_batch::set_backend( name ) )
+         continue;
+      ++tested;
+      BOOST_TEST_MESSAGE( "sha256_batch backend " << name );
+
+      BOOST_CHECK( sha256_batch::hash( msgs ) == expected );
+
+      vector<digest_type> pairs( leaves.size() / 2 );
+      sha256_batch::hash_pairs( leaves.data(), pairs.size(), pairs.data() );
+      for( size_t i = 0; i < pairs.size(); ++i )
+         BOOST_CHECK_EQUAL( pairs[i], digest_type::hash( std::make_pair( leaves[2 * i], leaves[2 * i + 1] ) ) );
+
+      for( size_t n = 1; n <= leaves.size(); ++n ) {
+         vector<digest_type> ids( leaves.begin(), leaves.begin() + n );
+         BOOST_CHECK_EQUAL( merkle( ids ), reference_merkle( ids ) );
+      }
+   }
+   BOOST_CHECK( tested >= 1 );
+   BOOST_CHECK( !sha256_batch::set_backend( "unknown" ) );
+   BOOST_REQUIRE( sha256_batch::set_backend( original ) );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(merkle_accumulator_test) { try {
+   merkle_accumulator acc;
+   BOOST_CHECK_EQUAL( acc.root(), digest_type() );
+
+   vector<digest_type> leaves;
+   merkle_accumulator restore_point;
+   for( uint32_t i = 0; i < 300; ++i ) {
+      leaves.push_back( digest_type::hash( i ) );
+      acc.append( leaves.back() );
+      BOOST_REQUIRE_EQUAL( acc.size(), leaves.size() );
+      BOOST_REQUIRE_EQUAL( acc.root(), merkle( leaves ) );
+      if( i == 100 ) restore_point = acc;
+   }
+
+   // a copy taken earlier rolls the accumulator back
+   acc = restore_point;
+   leaves.resize( 101 );
+   BOOST_CHECK_EQUAL( acc.root(), merkle( leaves ) );
+   leaves.push_back( digest_type::hash( std::string("other") ) );
+   acc.append( leaves.back() );
+   BOOST_CHECK_EQUAL( acc.root(), merkle( leaves ) );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace eosio
@@ -1,5 +1,6 @@
 #include <boost/test/unit_test.hpp>
 #include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/resource_limits_private.hpp>
 #include <eosio/chain/config.hpp>
 #include <eosio/testing/chainbase_fixture.hpp>
 
@@ -238,6 +239,48 @@ BOOST_AUTO_TEST_SUITE(resource_limits_test)
 
    } FC_LOG_AND_RETHROW();
 
+   /**
+    * Usage is accumulated in memory, follows its undo sessions and only reaches chainbase in process_block_usage
+    */
+   BOOST_FIXTURE_TEST_CASE(pending_usage_sessions, resource_limits_fixture) try {
+      const account_name account(1);
+      initialize_account(account);
+      set_account_limits(account, -1, -1, 1 );
+      process_account_limit_updates();
+
+      const uint64_t block_cpu_limit = get_block_cpu_limit();
+      auto unused_cpu = get_account_cpu_limit_ex(account).used;
+
+      {
+         auto s = start_usage_session();
+         add_transaction_usage({account}, 100, 0, 1);
+         BOOST_REQUIRE_EQUAL(get_block_cpu_limit(), block_cpu_limit - 100);
+         BOOST_REQUIRE_GT(get_account_cpu_limit_ex(account).used, unused_cpu);
+         s.undo();
+      }
+      BOOST_REQUIRE_EQUAL(get_block_cpu_limit(), block_cpu_limit);
+      BOOST_REQUIRE_EQUAL(get_account_cpu_limit_ex(account).used, unused_cpu);
+
+      auto block_session = start_usage_session();
+      {
+         auto s = start_usage_session();
+         add_transaction_usage({account}, 100, 0, 1);
+         s.squash();
+      }
+      auto used_cpu = get_account_cpu_limit_ex(account).used;
+      BOOST_REQUIRE_GT(used_cpu, unused_cpu);
+      BOOST_REQUIRE_EQUAL(get_block_cpu_limit(), block_cpu_limit - 100);
+
+      // nothing has been written to chainbase yet
+      const auto& usage = chainbase_fixture::_db->get<resource_usage_object,by_owner>(account);
+      BOOST_REQUIRE_EQUAL(usage.cpu_usage.value_ex, 0);
+
+      process_block_usage(1);
+      BOOST_REQUIRE_GT(usage.cpu_usage.value_ex, 0);
+      BOOST_REQUIRE_EQUAL(get_account_cpu_limit_ex(account).used, used_cpu);
+      block_session.push();
+   } FC_LOG_AND_RETHROW();
+
    BOOST_FIXTURE_TEST_CASE(enforce_account_ram_limit, resource_limits_fixture) try {
       const uint64_t limit = 1000;
       const uint64_t increment = 77;